@@ -22,8 +22,11 @@
 #include "internal/generic/Normal.h"
 #include "internal/generic/Normals.h"
 #include "internal/generic/Numerics.h"
+#include "internal/generic/OnceFlag.h"
+#include "internal/generic/Parallel.h"
 #include "internal/generic/Point.h"
 #include "internal/generic/Points.h"
+#include "internal/generic/Predicates.h"
 #include "internal/generic/Scalar.h"
 #include "internal/generic/StackAllocator.h"
 #include "internal/generic/Vertex.h"
@@ -36,10 +39,16 @@
 #include "internal/geometry/Edges.h"
 #include "internal/geometry/Face.h"
 #include "internal/geometry/Faces.h"
+#include "internal/geometry/FaceTree.h"
 #include "internal/geometry/FaceVisitor.h"
 #include "internal/geometry/FacesVisitor.h"
+#include "internal/geometry/QuantizedVertices.h"
+#include "internal/geometry/Ray.h"
 #include "internal/geometry/Shape.h"
+#include "internal/geometry/ShapeCodec.h"
 #include "internal/geometry/ShapeFactory.h"
 #include "internal/geometry/Transformation.h"
 
+#include "internal/utilities/OutputBuffer.h"
+#include "internal/utilities/Raster.h"
 #include "internal/utilities/svg.h"
@@ -2,34 +2,50 @@
 
 #include "internal/generic/Vertex.h"
 
-class Normal : public Vertex
+template<typename T>
+class NormalT : public VertexT<T>
 {
 public:
-    using Vertex::Vertex;
+    using VertexT<T>::VertexT;
 
-    Normal(const Vertex & vertex);
+    NormalT(const VertexT<T> & vertex);
+    // Conversion between precisions
+    template<typename T2>
+    explicit NormalT(const NormalT<T2>& other);
 
-    Normal & normalize();
-    Normal normalized() const;
+    NormalT & normalize();
+    NormalT normalized() const;
 };
 
-inline Normal::Normal(const Vertex& vertex)
+template<typename T>
+inline NormalT<T>::NormalT(const VertexT<T>& vertex)
 {
-    x = vertex.x;
-    y = vertex.y;
-    z = vertex.z;
+    this->x = vertex.x;
+    this->y = vertex.y;
+    this->z = vertex.z;
     normalize();
 }
 
-inline Normal & Normal::normalize()
+template<typename T>
+template<typename T2>
+inline NormalT<T>::NormalT(const NormalT<T2>& other)
+    : VertexT<T>(other)
+{}
+
+template<typename T>
+inline NormalT<T> & NormalT<T>::normalize()
 {
-    Scalar l = length();
+    T l = this->length();
     *this /= l;
     return *this;
 }
 
-inline Normal Normal::normalized() const
+template<typename T>
+inline NormalT<T> NormalT<T>::normalized() const
 {
-    return Normal(*this).normalize();
+    return NormalT<T>(*this).normalize();
 }
 
+typedef NormalT<Scalar> Normal;
+typedef NormalT<float> NormalF;
+typedef NormalT<double> NormalD;
@@ -4,5 +4,9 @@
 
 #include "internal/generic/Normal.h"
 
-typedef std::vector<Normal> Normals;
+template<typename T>
+using NormalsT = std::vector<NormalT<T>>;
 
+typedef NormalsT<Scalar> Normals;
+typedef NormalsT<float> NormalsF;
+typedef NormalsT<double> NormalsD;
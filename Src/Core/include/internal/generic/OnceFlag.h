@@ -0,0 +1,74 @@
+﻿#pragma once
+
+#include <atomic>
+#include <mutex>
+
+// Guards lazily computed (volatile) data which is read from several threads.
+// call(func) runs func when the data isn't ready, threads calling meanwhile
+// wait for it to finish. Once ready, call is a single atomic load, so warm
+// data is read without locking. Unlike std::once_flag it can be reset, which
+// (like any change of the data) must not race with readers.
+class OnceFlag
+{
+public:
+    OnceFlag() = default;
+    // Copies the state only, the data is copied by the owner
+    OnceFlag(const OnceFlag& other);
+    OnceFlag& operator = (const OnceFlag& other);
+
+    // Run func (which fills the data) unless the data is ready.
+    // When func throws the data stays not ready.
+    template<typename FUNC>
+    void call(FUNC&& func) const;
+
+    // True when the data is ready, the data may then be read (or copied)
+    bool isSet() const;
+    // Mark data filled in another way as ready
+    void set() const;
+    // Mark the data as not ready
+    void reset() const;
+
+private:
+    mutable std::atomic<bool> ready{ false };
+    mutable std::mutex mutex;
+};
+
+inline OnceFlag::OnceFlag(const OnceFlag& other)
+    : ready(other.isSet())
+{}
+
+inline OnceFlag& OnceFlag::operator = (const OnceFlag& other)
+{
+    ready.store(other.isSet(), std::memory_order_release);
+    return *this;
+}
+
+template<typename FUNC>
+inline void OnceFlag::call(FUNC&& func) const
+{
+    if (ready.load(std::memory_order_acquire))
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!ready.load(std::memory_order_relaxed))
+    {
+        func();
+        ready.store(true, std::memory_order_release);
+    }
+}
+
+inline bool OnceFlag::isSet() const
+{
+    return ready.load(std::memory_order_acquire);
+}
+
+inline void OnceFlag::set() const
+{
+    ready.store(true, std::memory_order_release);
+}
+
+inline void OnceFlag::reset() const
+{
+    ready.store(false, std::memory_order_relaxed);
+}
@@ -0,0 +1,120 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Parallel
+{
+    // Number of threads used by the parallel loops
+    inline size_t ThreadCount()
+    {
+        static const size_t count = std::max<size_t>(1, std::thread::hardware_concurrency());
+        return count;
+    }
+
+    // Split [0,count) into consecutive ranges and call func(begin, end) for
+    // each range on its own thread. The calling thread takes the last range.
+    // Ranges are at least minRange long, so small loops stay on one thread.
+    // The first exception thrown by func is rethrown after all threads finished.
+    template<typename FUNC>
+    inline void ForRanges(const size_t count, FUNC&& func, const size_t minRange = 1024)
+    {
+        const size_t threads = std::min(ThreadCount(), (count + minRange - 1) / std::max<size_t>(minRange, 1));
+        if (threads <= 1)
+        {
+            if (count > 0)
+            {
+                func((size_t)0, count);
+            }
+            return;
+        }
+        std::exception_ptr error;
+        std::mutex errorMutex;
+        auto run = [&](const size_t begin, const size_t end)
+        {
+            try
+            {
+                func(begin, end);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!error) error = std::current_exception();
+            }
+        };
+        std::vector<std::thread> workers;
+        workers.reserve(threads - 1);
+        const size_t step = count / threads;
+        const size_t rest = count % threads;
+        size_t begin = 0;
+        for (size_t i = 0; i + 1 < threads; ++i)
+        {
+            const size_t end = begin + step + (i < rest ? 1 : 0);
+            workers.emplace_back(run, begin, end);
+            begin = end;
+        }
+        run(begin, count);
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+
+    // Call func(index) for every index in [0,count), see ForRanges
+    template<typename FUNC>
+    inline void For(const size_t count, FUNC&& func, const size_t minRange = 1024)
+    {
+        ForRanges(count, [&func](const size_t begin, const size_t end)
+            {
+                for (size_t i = begin; i < end; ++i)
+                {
+                    func(i);
+                }
+            }, minRange);
+    }
+
+    // Sort [begin,end) with comp. Blocks of at least minRange elements are
+    // sorted on their own threads, then merged pairwise (also in parallel).
+    // Like std::sort the order of equal elements is unspecified, use a
+    // comparator which is a total order for a deterministic result.
+    template<typename ITERATOR, typename COMPARE>
+    inline void Sort(ITERATOR begin, ITERATOR end, COMPARE comp, const size_t minRange = 1 << 14)
+    {
+        const size_t count = end - begin;
+        const size_t blocks = std::min(ThreadCount(), (count + minRange - 1) / std::max<size_t>(minRange, 1));
+        if (blocks <= 1)
+        {
+            std::sort(begin, end, comp);
+            return;
+        }
+        std::vector<size_t> bounds(blocks + 1);
+        for (size_t i = 0; i <= blocks; ++i)
+        {
+            bounds[i] = i * count / blocks;
+        }
+        For(blocks, [&](const size_t i)
+            {
+                std::sort(begin + bounds[i], begin + bounds[i + 1], comp);
+            }, 1);
+        for (size_t width = 1; width < blocks; width *= 2)
+        {
+            For((blocks + 2 * width - 1) / (2 * width), [&](const size_t i)
+                {
+                    const size_t first = i * 2 * width;
+                    const size_t middle = std::min(first + width, blocks);
+                    const size_t last = std::min(first + 2 * width, blocks);
+                    if (middle < last)
+                    {
+                        std::inplace_merge(begin + bounds[first], begin + bounds[middle], begin + bounds[last], comp);
+                    }
+                }, 1);
+        }
+    }
+}
@@ -0,0 +1,31 @@
+﻿#pragma once
+
+#include "internal/generic/Point.h"
+#include "internal/generic/Scalar.h"
+#include "internal/generic/Vertex.h"
+
+//
+// Geometric predicates with exact signs, see "Adaptive Precision
+// Floating-Point Arithmetic and Fast Robust Geometric Predicates"
+// (Shewchuk 1997).
+// The determinant is evaluated in floating point first, only when it is
+// within the error bound of zero it is evaluated again with exact expansion
+// arithmetic. The sign of the result is exact, the value an approximation.
+//
+namespace Predicates
+{
+    // Positive if a, b, c are counterclockwise, negative if clockwise, 0 if collinear
+    Scalar Orient2D(const Point& a, const Point& b, const Point& c);
+
+    // Positive if d is below the plane through a, b, c, where a, b, c are
+    // counterclockwise seen from above. Negative if above, 0 if coplanar.
+    Scalar Orient3D(const Vertex& a, const Vertex& b, const Vertex& c, const Vertex& d);
+
+    // Positive if d is inside the circle through the counterclockwise a, b, c,
+    // negative if outside, 0 if on the circle
+    Scalar InCircle(const Point& a, const Point& b, const Point& c, const Point& d);
+
+    // Positive if e is inside the sphere through a, b, c, d (with Orient3D(a, b, c, d) > 0),
+    // negative if outside, 0 if on the sphere
+    Scalar InSphere(const Vertex& a, const Vertex& b, const Vertex& c, const Vertex& d, const Vertex& e);
+}
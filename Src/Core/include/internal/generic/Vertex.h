@@ -5,88 +5,109 @@
 #include "internal/generic/Numerics.h"
 #include "internal/generic/Scalar.h"
 
-class Vertex
+// A point or vector, T is the precision (float or double)
+template<typename T>
+class VertexT
 {
 public:
-    Scalar x;
-    Scalar y;
-    Scalar z;
+    typedef T scalar_type;
 
-    Vertex() 
+    T x;
+    T y;
+    T z;
+
+    VertexT() 
         : x(0)
         , y(0)
         , z(0)
     {}
-    Vertex(
-        const Scalar x,
-        const Scalar y,
-        const Scalar z)
+    VertexT(
+        const T x,
+        const T y,
+        const T z)
         : x(x)
         , y(y)
         , z(z)
     {}
-    Vertex(
-        const Vertex& other);
-    Vertex(
-        Vertex&& other) noexcept;
-
-    Vertex& operator = (const Vertex& other);
-    Vertex& operator = (Vertex&& other) noexcept;
-    Scalar& operator [] (const size_t index);
-    Scalar operator [] (const size_t index) const;
-
-    void copy(const Vertex& other);
-    void swap(Vertex& other) noexcept;
-
-    const Vertex & operator + () const;
-    Vertex   operator + (const Vertex& other) const;
-    Vertex & operator += (const Vertex& other);
-
-    Vertex   operator - () const;
-    Vertex   operator - (const Vertex& other) const;
-    Vertex & operator -= (const Vertex& other);
-
-    Vertex   operator * (const Scalar& factor) const;
-    Vertex & operator *= (const Scalar& factor);
-
-    Vertex   operator / (const Scalar& factor) const;
-    Vertex & operator /= (const Scalar& factor);
-
-    bool operator == (const Vertex& other) const;
-    bool operator != (const Vertex& other) const;
-
-    Vertex crossProduct(const Vertex& other) const;
-    Scalar innerProduct(const Vertex& other) const;
-    Scalar dist2(const Vertex& other) const;
-    Scalar dist(const Vertex& other) const;
-    Scalar length() const;
+    VertexT(
+        const VertexT& other);
+    VertexT(
+        VertexT&& other) noexcept;
+    // Conversion between precisions, explicit since it may round
+    template<typename T2>
+    explicit VertexT(
+        const VertexT<T2>& other);
+
+    VertexT& operator = (const VertexT& other);
+    VertexT& operator = (VertexT&& other) noexcept;
+    T& operator [] (const size_t index);
+    T operator [] (const size_t index) const;
+
+    void copy(const VertexT& other);
+    void swap(VertexT& other) noexcept;
+
+    const VertexT & operator + () const;
+    VertexT   operator + (const VertexT& other) const;
+    VertexT & operator += (const VertexT& other);
+
+    VertexT   operator - () const;
+    VertexT   operator - (const VertexT& other) const;
+    VertexT & operator -= (const VertexT& other);
+
+    VertexT   operator * (const T& factor) const;
+    VertexT & operator *= (const T& factor);
+
+    VertexT   operator / (const T& factor) const;
+    VertexT & operator /= (const T& factor);
+
+    bool operator == (const VertexT& other) const;
+    bool operator != (const VertexT& other) const;
+
+    VertexT crossProduct(const VertexT& other) const;
+    T innerProduct(const VertexT& other) const;
+    T dist2(const VertexT& other) const;
+    T dist(const VertexT& other) const;
+    T length() const;
 
     constexpr size_t size() const { return 3; }
 };
 
-inline Vertex::Vertex(const Vertex& other)
+template<typename T>
+inline VertexT<T>::VertexT(const VertexT<T>& other)
 {
     copy(other);
 }
 
-inline Vertex::Vertex(Vertex&& other) noexcept
+template<typename T>
+inline VertexT<T>::VertexT(VertexT<T>&& other) noexcept
 {
     swap(other);
 }
 
-inline Vertex& Vertex::operator=(const Vertex& other)
+template<typename T>
+template<typename T2>
+inline VertexT<T>::VertexT(const VertexT<T2>& other)
+    : x((T)other.x)
+    , y((T)other.y)
+    , z((T)other.z)
+{}
+
+template<typename T>
+inline VertexT<T>& VertexT<T>::operator=(const VertexT<T>& other)
 {
     copy(other);
     return *this;
 }
 
-inline Vertex& Vertex::operator=(Vertex&& other) noexcept
+template<typename T>
+inline VertexT<T>& VertexT<T>::operator=(VertexT<T>&& other) noexcept
 {
     swap(other);
     return *this;
 }
 
-inline Scalar& Vertex::operator[](const size_t index)
+template<typename T>
+inline T& VertexT<T>::operator[](const size_t index)
 {
     switch (index)
     {
@@ -99,7 +120,8 @@ inline Scalar& Vertex::operator[](const size_t index)
 #endif // NDEBUG
 }
 
-inline Scalar Vertex::operator[](const size_t index) const
+template<typename T>
+inline T VertexT<T>::operator[](const size_t index) const
 {
     switch (index)
     {
@@ -112,36 +134,42 @@ inline Scalar Vertex::operator[](const size_t index) const
 #endif // NDEBUG
 }
 
-inline void Vertex::copy(const Vertex& other)
+template<typename T>
+inline void VertexT<T>::copy(const VertexT<T>& other)
 {
     x = other.x;
     y = other.y;
     z = other.z;
 }
 
-inline void Vertex::swap(Vertex& other) noexcept
+template<typename T>
+inline void VertexT<T>::swap(VertexT<T>& other) noexcept
 {
     std::swap(x, other.x);
     std::swap(y, other.y);
     std::swap(z, other.z);
 }
 
-inline Vertex Vertex::operator-() const
+template<typename T>
+inline VertexT<T> VertexT<T>::operator-() const
 {
-    return Vertex(-x,-y,-z);
+    return VertexT<T>(-x,-y,-z);
 }
 
-inline const Vertex& Vertex::operator+() const
+template<typename T>
+inline const VertexT<T>& VertexT<T>::operator+() const
 {
     return *this;
 }
 
-inline Vertex Vertex::operator + (const Vertex& other) const
+template<typename T>
+inline VertexT<T> VertexT<T>::operator + (const VertexT<T>& other) const
 {
-    return Vertex(*this)+=other;
+    return VertexT<T>(*this)+=other;
 }
 
-inline Vertex & Vertex::operator += (const Vertex& other)
+template<typename T>
+inline VertexT<T> & VertexT<T>::operator += (const VertexT<T>& other)
 {
     x += other.x;
     y += other.y;
@@ -149,12 +177,14 @@ inline Vertex & Vertex::operator += (const Vertex& other)
     return *this;
 }
 
-inline Vertex Vertex::operator - (const Vertex& other) const
+template<typename T>
+inline VertexT<T> VertexT<T>::operator - (const VertexT<T>& other) const
 {
-    return Vertex(*this) -= other;
+    return VertexT<T>(*this) -= other;
 }
 
-inline Vertex& Vertex::operator -= (const Vertex& other)
+template<typename T>
+inline VertexT<T>& VertexT<T>::operator -= (const VertexT<T>& other)
 {
     x -= other.x;
     y -= other.y;
@@ -162,12 +192,14 @@ inline Vertex& Vertex::operator -= (const Vertex& other)
     return *this;
 }
 
-inline Vertex Vertex::operator * (const Scalar& factor) const
+template<typename T>
+inline VertexT<T> VertexT<T>::operator * (const T& factor) const
 {
-    return Vertex(*this) *= factor;
+    return VertexT<T>(*this) *= factor;
 }
 
-inline Vertex& Vertex::operator *= (const Scalar& factor)
+template<typename T>
+inline VertexT<T>& VertexT<T>::operator *= (const T& factor)
 {
     x *= factor;
     y *= factor;
@@ -175,61 +207,70 @@ inline Vertex& Vertex::operator *= (const Scalar& factor)
     return *this;
 }
 
-inline Vertex Vertex::operator/(const Scalar& factor) const
+template<typename T>
+inline VertexT<T> VertexT<T>::operator/(const T& factor) const
 {
-    return Vertex(*this) *= (((Scalar)1.0)/factor);
+    return VertexT<T>(*this) *= (((T)1.0)/factor);
 }
 
-inline Vertex& Vertex::operator/=(const Scalar& factor)
+template<typename T>
+inline VertexT<T>& VertexT<T>::operator/=(const T& factor)
 {
-    x *= ((Scalar)1.0) / factor;
-    y *= ((Scalar)1.0) / factor;
-    z *= ((Scalar)1.0) / factor;
+    x *= ((T)1.0) / factor;
+    y *= ((T)1.0) / factor;
+    z *= ((T)1.0) / factor;
     return *this;
 }
 
-inline bool Vertex::operator == (const Vertex& other) const
+template<typename T>
+inline bool VertexT<T>::operator == (const VertexT<T>& other) const
 {
     return Numerics::Equal(x, other.x)
         && Numerics::Equal(y, other.y)
         && Numerics::Equal(z, other.z);
 }
 
-inline bool Vertex::operator != (const Vertex& other) const
+template<typename T>
+inline bool VertexT<T>::operator != (const VertexT<T>& other) const
 {
     return Numerics::NotEqual(x, other.x)
         || Numerics::NotEqual(y, other.y)
         || Numerics::NotEqual(z, other.z);
 }
 
-inline Vertex Vertex::crossProduct(const Vertex& other) const
+template<typename T>
+inline VertexT<T> VertexT<T>::crossProduct(const VertexT<T>& other) const
 {
-    return Vertex(y*other.z - z*other.y, z*other.x - x*other.z, x*other.y - y*other.x);
+    return VertexT<T>(y*other.z - z*other.y, z*other.x - x*other.z, x*other.y - y*other.x);
 }
 
-inline Scalar Vertex::innerProduct(const Vertex& other) const
+template<typename T>
+inline T VertexT<T>::innerProduct(const VertexT<T>& other) const
 {
     return x * other.x + y * other.y + z * other.z;
 }
 
-inline Scalar Vertex::dist2(const Vertex& other) const
+template<typename T>
+inline T VertexT<T>::dist2(const VertexT<T>& other) const
 {
     auto tmp = *this - other;
     return tmp.innerProduct(tmp);
 }
 
-inline Scalar Vertex::dist(const Vertex& other) const
+template<typename T>
+inline T VertexT<T>::dist(const VertexT<T>& other) const
 {
     return Numerics::Sqrt(dist2(other));
 }
 
-inline Scalar Vertex::length() const
+template<typename T>
+inline T VertexT<T>::length() const
 {
     return Numerics::Sqrt(innerProduct(*this));
 }
 
-
-
-
-
-
+// Scalar is the default precision, float halves the memory of vertex data
+// which doesn't need double precision (rendering, broad phase)
+typedef VertexT<Scalar> Vertex;
+typedef VertexT<float> VertexF;
+typedef VertexT<double> VertexD;
@@ -4,5 +4,22 @@
 
 #include "internal/generic/Vertex.h"
 
-typedef std::vector<Vertex> Vertices;
+template<typename T>
+using VerticesT = std::vector<VertexT<T>>;
 
+typedef VerticesT<Scalar> Vertices;
+typedef VerticesT<float> VerticesF;
+typedef VerticesT<double> VerticesD;
+
+// Convert vertices (or normals) between precisions
+template<typename TO, typename FROM>
+inline std::vector<TO> ConvertVertices(const std::vector<FROM>& vertices)
+{
+    std::vector<TO> res;
+    res.reserve(vertices.size());
+    for (const auto& vertex : vertices)
+    {
+        res.emplace_back(vertex);
+    }
+    return res;
+}
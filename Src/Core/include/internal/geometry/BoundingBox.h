@@ -7,86 +7,101 @@
 
 #include "internal/geometry/IBoundingObject.h"
 
-class BoundingBox final : public IBoundingObject
+template<typename T>
+class BoundingBoxT final : public IBoundingObjectT<T>
 {
 public:
-    Vertex min;
-    Vertex max;
+    using typename IBoundingObjectT<T>::Type;
 
-    ~BoundingBox();
-    BoundingBox() noexcept;
-    BoundingBox(
-        const Vertex& min,
-        const Vertex& max);
-    BoundingBox(const Vertices& vertices);
+    VertexT<T> min;
+    VertexT<T> max;
+
+    ~BoundingBoxT();
+    BoundingBoxT() noexcept;
+    BoundingBoxT(
+        const VertexT<T>& min,
+        const VertexT<T>& max);
+    BoundingBoxT(const VerticesT<T>& vertices);
 
     virtual void invalidate() override;
     virtual operator bool() const override;
     virtual Type getType() const override;
-    virtual Scalar calculateVolume() const override;
-    virtual void create(const Vertices& vertices) override;
+    virtual T calculateVolume() const override;
+    virtual void create(const VerticesT<T>& vertices) override;
     virtual void scale(const double& factor) override;
-    virtual bool overlap(const IBoundingObject& other) const override;
-            bool overlap(const BoundingBox& other) const;
+    virtual bool overlap(const IBoundingObjectT<T>& other) const override;
+            bool overlap(const BoundingBoxT& other) const;
+    virtual bool contains(const VertexT<T>& point) const override;
 };
 
-inline BoundingBox::~BoundingBox() 
+template<typename T>
+inline BoundingBoxT<T>::~BoundingBoxT() 
 {};
-inline BoundingBox::BoundingBox() noexcept
+template<typename T>
+inline BoundingBoxT<T>::BoundingBoxT() noexcept
 {
     invalidate();
 }
-inline BoundingBox::BoundingBox(
-    const Vertex& min,
-    const Vertex& max)
+template<typename T>
+inline BoundingBoxT<T>::BoundingBoxT(
+    const VertexT<T>& min,
+    const VertexT<T>& max)
     : min(min)
     , max(max)
 {}
-inline BoundingBox::BoundingBox(const Vertices& vertices)
+template<typename T>
+inline BoundingBoxT<T>::BoundingBoxT(const VerticesT<T>& vertices)
 {
     create(vertices);
 }
 
-inline void BoundingBox::invalidate()
+template<typename T>
+inline void BoundingBoxT<T>::invalidate()
 {
-    max.x = Limits<Scalar>::MinValue;
-    max.y = Limits<Scalar>::MaxValue;
+    max.x = Limits<T>::MinValue;
+    max.y = Limits<T>::MaxValue;
 }
-inline BoundingBox::operator bool() const
+template<typename T>
+inline BoundingBoxT<T>::operator bool() const
 {
     return max.x >= min.x;
 }
-inline IBoundingObject::Type BoundingBox::getType() const
+template<typename T>
+inline typename IBoundingObjectT<T>::Type BoundingBoxT<T>::getType() const
 {
     return Type::Box;
 }
-inline Scalar BoundingBox::calculateVolume() const
+template<typename T>
+inline T BoundingBoxT<T>::calculateVolume() const
 {
     return (max.x - min.x) * (max.y - min.y) * (max.z - min.z);
 }
 
-inline void BoundingBox::create(const Vertices& vertices)
+template<typename T>
+inline void BoundingBoxT<T>::create(const VerticesT<T>& vertices)
 {
-    min = Vertex(Limits<Scalar>::MaxValue, Limits<Scalar>::MaxValue, Limits<Scalar>::MaxValue);
-    max = Vertex(Limits<Scalar>::MinValue, Limits<Scalar>::MinValue, Limits<Scalar>::MinValue);
-    for (const auto& Vertex : vertices)
+    min = VertexT<T>(Limits<T>::MaxValue, Limits<T>::MaxValue, Limits<T>::MaxValue);
+    max = VertexT<T>(Limits<T>::MinValue, Limits<T>::MinValue, Limits<T>::MinValue);
+    for (const auto& vertex : vertices)
     {
-        min.x = std::min(min.x, Vertex.x);
-        min.y = std::min(min.y, Vertex.y);
-        min.z = std::min(min.z, Vertex.z);
-        max.x = std::max(max.x, Vertex.x);
-        max.y = std::max(max.y, Vertex.y);
-        max.z = std::max(max.z, Vertex.z);
+        min.x = std::min(min.x, vertex.x);
+        min.y = std::min(min.y, vertex.y);
+        min.z = std::min(min.z, vertex.z);
+        max.x = std::max(max.x, vertex.x);
+        max.y = std::max(max.y, vertex.y);
+        max.z = std::max(max.z, vertex.z);
     }
 }
 
-inline void BoundingBox::scale(const double& factor)
+template<typename T>
+inline void BoundingBoxT<T>::scale(const double& factor)
 {
     min *= factor;
     max *= factor;
 }
 
-inline bool BoundingBox::overlap(const BoundingBox& other) const
+template<typename T>
+inline bool BoundingBoxT<T>::overlap(const BoundingBoxT<T>& other) const
 {
     return
         max.x >= other.min.x &&
@@ -97,17 +112,30 @@ inline bool BoundingBox::overlap(const BoundingBox& other) const
         min.z <= other.max.z;
 }
 
-inline bool BoundingBox::overlap(const IBoundingObject& other) const
+template<typename T>
+inline bool BoundingBoxT<T>::contains(const VertexT<T>& point) const
+{
+    return
+        point.x >= min.x &&
+        point.x <= max.x &&
+        point.y >= min.y &&
+        point.y <= max.y &&
+        point.z >= min.z &&
+        point.z <= max.z;
+}
+
+template<typename T>
+inline bool BoundingBoxT<T>::overlap(const IBoundingObjectT<T>& other) const
 {
     switch (other.getType())
     {
     case Type::Box:
-        return overlap(*(BoundingBox*)(&other));
+        return overlap(*(BoundingBoxT<T>*)(&other));
     default:
         // maybe some other object can determine overlap with me?
         return other.overlap(*this);
     }
 }
 
-
-
+typedef BoundingBoxT<Scalar> BoundingBox;
+typedef BoundingBoxT<float> BoundingBoxF;
@@ -10,102 +10,119 @@
 #include "internal/geometry/BoundingSphere.h"
 #include "internal/geometry/IBoundingObject.h"
 
-class BoundingObject final : public IBoundingObject
+template<typename T>
+class BoundingObjectT final : public IBoundingObjectT<T>
 {
 public:
-    ~BoundingObject();
-    BoundingObject() noexcept;
-    BoundingObject(
-        const Vertex& min,
-        const Vertex& max);
-    BoundingObject(
-        const Vertex& center,
-        const Scalar& radius);
-    BoundingObject(const BoundingObject& other);
-    BoundingObject(BoundingObject&& other) noexcept;
-    BoundingObject(const Vertices& vertices);
-    BoundingObject(const Vertices& vertices, const Type type);
-
-    BoundingObject& operator = (const BoundingObject& other);
-    BoundingObject& operator = (BoundingObject&& other) noexcept;
-
-    void copy(const BoundingObject& other);
-    void swap(BoundingObject& other);
+    using typename IBoundingObjectT<T>::Type;
+
+    ~BoundingObjectT();
+    BoundingObjectT() noexcept;
+    BoundingObjectT(
+        const VertexT<T>& min,
+        const VertexT<T>& max);
+    BoundingObjectT(
+        const VertexT<T>& center,
+        const T& radius);
+    BoundingObjectT(const BoundingObjectT& other);
+    BoundingObjectT(BoundingObjectT&& other) noexcept;
+    BoundingObjectT(const VerticesT<T>& vertices);
+    BoundingObjectT(const VerticesT<T>& vertices, const Type type);
+
+    BoundingObjectT& operator = (const BoundingObjectT& other);
+    BoundingObjectT& operator = (BoundingObjectT&& other) noexcept;
+
+    void copy(const BoundingObjectT& other);
+    void swap(BoundingObjectT& other);
 
     virtual void invalidate() override;
     virtual operator bool() const override;
     virtual Type getType() const override;
-    virtual Scalar calculateVolume() const override;
-    virtual void create(const Vertices& vertices) override;
-            void create(const Vertices& vertices, const Type type);
+    virtual T calculateVolume() const override;
+    virtual void create(const VerticesT<T>& vertices) override;
+            void create(const VerticesT<T>& vertices, const Type type);
     virtual void scale(const double& factor) override;
-    virtual bool overlap(const IBoundingObject& other) const override;
+    virtual bool overlap(const IBoundingObjectT<T>& other) const override;
+    virtual bool contains(const VertexT<T>& point) const override;
 
 private:
-    std::variant<BoundingBox, BoundingSphere> object;
+    std::variant<BoundingBoxT<T>, BoundingSphereT<T>> object;
 };
 
-inline BoundingObject::~BoundingObject()
+template<typename T>
+inline BoundingObjectT<T>::~BoundingObjectT()
 {}
 
-inline BoundingObject::BoundingObject() noexcept
-    : object(BoundingSphere())
+template<typename T>
+inline BoundingObjectT<T>::BoundingObjectT() noexcept
+    : object(BoundingSphereT<T>())
 {}
 
-inline BoundingObject::BoundingObject(const Vertex & min, const Vertex & max)
-    : object(BoundingBox(min,max))
+template<typename T>
+inline BoundingObjectT<T>::BoundingObjectT(const VertexT<T> & min, const VertexT<T> & max)
+    : object(BoundingBoxT<T>(min,max))
 {}
 
-inline BoundingObject::BoundingObject(const Vertex& center, const Scalar& radius)
-    : object(BoundingSphere(center,radius))
+template<typename T>
+inline BoundingObjectT<T>::BoundingObjectT(const VertexT<T>& center, const T& radius)
+    : object(BoundingSphereT<T>(center,radius))
 {}
 
-inline BoundingObject::BoundingObject(const BoundingObject& other)
+template<typename T>
+inline BoundingObjectT<T>::BoundingObjectT(const BoundingObjectT<T>& other)
 {
     copy(other);
 }
 
-inline BoundingObject::BoundingObject(BoundingObject&& other) noexcept
+template<typename T>
+inline BoundingObjectT<T>::BoundingObjectT(BoundingObjectT<T>&& other) noexcept
     : object(other.object)
 {
     swap(other);
 }
 
-inline BoundingObject::BoundingObject(const Vertices& vertices)
+template<typename T>
+inline BoundingObjectT<T>::BoundingObjectT(const VerticesT<T>& vertices)
 {
     create(vertices);
 }
-inline BoundingObject::BoundingObject(const Vertices& vertices, const Type type)
+template<typename T>
+inline BoundingObjectT<T>::BoundingObjectT(const VerticesT<T>& vertices, const Type type)
 {
     create(vertices, type);
 }
 
-inline BoundingObject& BoundingObject::operator=(const BoundingObject& other)
+template<typename T>
+inline BoundingObjectT<T>& BoundingObjectT<T>::operator=(const BoundingObjectT<T>& other)
 {
     copy(other);
     return *this;
 }
 
-inline BoundingObject& BoundingObject::operator=(BoundingObject&& other) noexcept
+template<typename T>
+inline BoundingObjectT<T>& BoundingObjectT<T>::operator=(BoundingObjectT<T>&& other) noexcept
 {
     swap(other);
     return *this;
 }
 
-inline void BoundingObject::copy(const BoundingObject& other)
+template<typename T>
+inline void BoundingObjectT<T>::copy(const BoundingObjectT<T>& other)
 {
     object = other.object;
 }
 
-inline void BoundingObject::swap(BoundingObject& other)
+template<typename T>
+inline void BoundingObjectT<T>::swap(BoundingObjectT<T>& other)
 {
     std::swap(object,other.object);
 }
 
-inline void BoundingObject::create(const Vertices& vertices)
+template<typename T>
+inline void BoundingObjectT<T>::create(const VerticesT<T>& vertices)
 {
-    auto box = BoundingBox(vertices);
-    auto sphere = BoundingSphere(vertices);
+    auto box = BoundingBoxT<T>(vertices);
+    auto sphere = BoundingSphereT<T>(vertices);
     auto boxVolume = box.calculateVolume();
     auto sphereVolume = sphere.calculateVolume();
     if (boxVolume <= sphereVolume)
@@ -118,48 +135,69 @@ inline void BoundingObject::create(const Vertices& vertices)
     }
 }
 
-inline void BoundingObject::create(const Vertices& vertices, const Type type)
+template<typename T>
+inline void BoundingObjectT<T>::create(const VerticesT<T>& vertices, const Type type)
 {
     switch (type)
     {
     case Type::Box:
-        object = BoundingBox(vertices);
+        object = BoundingBoxT<T>(vertices);
         break;
     case Type::Sphere:
-        object = BoundingSphere(vertices);
+        object = BoundingSphereT<T>(vertices);
         break;
     default:
         assert(false); // unhandled type
     }
 }
 
-inline typename BoundingObject::Type BoundingObject::getType() const
+template<typename T>
+inline typename BoundingObjectT<T>::Type BoundingObjectT<T>::getType() const
 {
     return std::visit([](auto&& arg) { return arg.getType(); }, object);
 }
 
-inline Scalar BoundingObject::calculateVolume() const
+template<typename T>
+inline T BoundingObjectT<T>::calculateVolume() const
 {
     return std::visit([](auto&& arg) { return arg.calculateVolume(); }, object);
 }
 
-inline bool BoundingObject::overlap(const IBoundingObject& other) const
+template<typename T>
+inline bool BoundingObjectT<T>::overlap(const IBoundingObjectT<T>& other) const
 {
+    // getType reports the wrapped type, so a wrapped other object is unwrapped
+    // as well, the wrapped objects cast the other to the type it reports
+    if (const auto* otherObject = dynamic_cast<const BoundingObjectT<T>*>(&other))
+    {
+        return std::visit([](auto&& arg, auto&& otherArg) { return arg.overlap(otherArg); }, object, otherObject->object);
+    }
     return std::visit([&other](auto&& arg) { return arg.overlap(other); }, object);
 }
 
-inline void BoundingObject::scale(const double& factor)
+template<typename T>
+inline bool BoundingObjectT<T>::contains(const VertexT<T>& point) const
+{
+    return std::visit([&point](auto&& arg) { return arg.contains(point); }, object);
+}
+
+template<typename T>
+inline void BoundingObjectT<T>::scale(const double& factor)
 {
     return std::visit([&factor](auto&& arg) { return arg.scale(factor); }, object);
 }
 
-inline void BoundingObject::invalidate()
+template<typename T>
+inline void BoundingObjectT<T>::invalidate()
 {
     return std::visit([](auto&& arg) { return arg.invalidate(); }, object);
 }
 
-inline BoundingObject::operator bool() const
+template<typename T>
+inline BoundingObjectT<T>::operator bool() const
 {
     return std::visit([](auto&& arg) { return (bool)arg; }, object);
 }
 
+typedef BoundingObjectT<Scalar> BoundingObject;
+typedef BoundingObjectT<float> BoundingObjectF;
@@ -7,100 +7,114 @@
 #include "internal/geometry/BoundingBox.h"
 #include "internal/geometry/IBoundingObject.h"
 
-class BoundingSphere final : public IBoundingObject 
+template<typename T>
+class BoundingSphereT final : public IBoundingObjectT<T> 
 {
 public:
-    Vertex center;
-    Scalar radius;
+    using typename IBoundingObjectT<T>::Type;
 
-    ~BoundingSphere();
-    BoundingSphere() noexcept;
-    BoundingSphere(
-        const Vertex& center,
-        const Scalar& radius);
-    BoundingSphere(const Vertices& vertices);
+    VertexT<T> center;
+    T radius;
+
+    ~BoundingSphereT();
+    BoundingSphereT() noexcept;
+    BoundingSphereT(
+        const VertexT<T>& center,
+        const T& radius);
+    BoundingSphereT(const VerticesT<T>& vertices);
 
     virtual void invalidate() override;
     virtual operator bool() const override;
     virtual Type getType() const override;
-    virtual Scalar calculateVolume() const override;
-    virtual void create(const Vertices& vertices) override;
+    virtual T calculateVolume() const override;
+    virtual void create(const VerticesT<T>& vertices) override;
     virtual void scale(const double& factor) override;
-    virtual bool overlap(const IBoundingObject& other) const override;
-            bool overlap(const BoundingSphere& other) const;
-            bool overlap(const BoundingBox& other) const;
+    virtual bool overlap(const IBoundingObjectT<T>& other) const override;
+            bool overlap(const BoundingSphereT& other) const;
+            bool overlap(const BoundingBoxT<T>& other) const;
+    virtual bool contains(const VertexT<T>& point) const override;
 };
 
-inline BoundingSphere::~BoundingSphere()
+template<typename T>
+inline BoundingSphereT<T>::~BoundingSphereT()
 {};
-inline BoundingSphere::BoundingSphere() noexcept
-    : radius(Limits<Scalar>::MinValue)
+template<typename T>
+inline BoundingSphereT<T>::BoundingSphereT() noexcept
+    : radius(Limits<T>::MinValue)
 {}
-inline BoundingSphere::BoundingSphere(
-    const Vertex& center,
-    const Scalar& radius)
+template<typename T>
+inline BoundingSphereT<T>::BoundingSphereT(
+    const VertexT<T>& center,
+    const T& radius)
     : center(center)
     , radius(radius)
 {}
-inline BoundingSphere::BoundingSphere(const Vertices& vertices)
+template<typename T>
+inline BoundingSphereT<T>::BoundingSphereT(const VerticesT<T>& vertices)
 {
     create(vertices);
 }
 
-inline void BoundingSphere::invalidate()
+template<typename T>
+inline void BoundingSphereT<T>::invalidate()
 {
-    radius = Limits<Scalar>::MinValue;
+    radius = Limits<T>::MinValue;
 }
 
-inline BoundingSphere::operator bool() const
+template<typename T>
+inline BoundingSphereT<T>::operator bool() const
 {
     return radius >= 0;
 }
 
-inline IBoundingObject::Type BoundingSphere::getType() const
+template<typename T>
+inline typename IBoundingObjectT<T>::Type BoundingSphereT<T>::getType() const
 {
     return Type::Sphere;
 }
 
-inline Scalar BoundingSphere::calculateVolume() const
+template<typename T>
+inline T BoundingSphereT<T>::calculateVolume() const
 {
     return 4 * radius * radius * radius * Constants::Pi / 3;
 }
 
-inline void BoundingSphere::create(const Vertices& vertices)
+template<typename T>
+inline void BoundingSphereT<T>::create(const VerticesT<T>& vertices)
 {
-    // function to find the Vertex from the list furthest from the pivot
-    auto findFurthestVertex = [](const Vertex &pivot, const Vertices& vertices)
+    // function to find the VertexT<T> from the list furthest from the pivot
+    auto findFurthestVertex = [](const VertexT<T> &pivot, const VerticesT<T>& vertices)
         {
-            Scalar dist2 = 0;
-            Vertex p = pivot;
-            for (const auto& Vertex : vertices)
+            T dist2 = 0;
+            VertexT<T> p = pivot;
+            for (const auto& vertex : vertices)
             {
-                auto tmpDist2 = Vertex.dist2(pivot); // radius^2
+                auto tmpDist2 = vertex.dist2(pivot); // radius^2
                 if (tmpDist2 > dist2)
                 {
-                    p = Vertex;
+                    p = vertex;
                     dist2 = tmpDist2;
                 }
             }
             return p;
         };
-    // function to find the Vertex outside the circle and update the circle (center + radius^2)
-    auto findOutliers = [](Vertex& center, Scalar radius2, const Vertices& vertices)
+    // function to find the VertexT<T> outside the circle and update the circle (center + radius^2)
+    // (points within rounding distance of the sphere don't count, or this would never end)
+    auto findOutliers = [](VertexT<T>& center, T& radius2, const VerticesT<T>& vertices)
         {
-            Vertices outliers;
-            Scalar dist2Max = radius2;
-            Vertex furthest = center;
-            for (const auto& Vertex : vertices)
+            VerticesT<T> outliers;
+            T dist2Max = radius2;
+            VertexT<T> furthest = center;
+            for (const auto& vertex : vertices)
             {
-                auto dist2 = Vertex.dist2(center);
-                if (dist2 > radius2)
+                auto dist2 = vertex.dist2(center);
+                if (dist2 > radius2 * (1 + Limits<T>::CompareEpsilon))
                 {
-                    outliers.emplace_back(Vertex);
+                    outliers.emplace_back(vertex);
                     if (dist2 > dist2Max)
                     {
                         dist2Max = dist2;
-                        furthest = Vertex;
+                        furthest = vertex;
                     }
                 }
             }
@@ -115,57 +129,67 @@ inline void BoundingSphere::create(const Vertices& vertices)
             return outliers;
         };
     // determine cloud center
-    Vertex center;
-    for (const auto& Vertex : vertices)
+    center = VertexT<T>();
+    for (const auto& vertex : vertices)
     {
-        center += Vertex;
+        center += vertex;
     }
-    center /= (Scalar)vertices.size();
-    // find Vertex p1 furthest from center
+    center /= (T)vertices.size();
+    // find VertexT<T> p1 furthest from center
     auto p1 = findFurthestVertex(center, vertices);
-    // find Vertex p2 furthest from p1 
+    // find VertexT<T> p2 furthest from p1 
     auto p2 = findFurthestVertex(p1, vertices);
     // calculate center and radius squared
     center = (p1 + p2) / 2;
     auto radius2 = p1.dist2(p2) / 4; // /4, this is radius^2
     // find vertices outside of initial sphere
-    std::vector<Vertex> outliers = findOutliers(center, radius2, vertices);
+    std::vector<VertexT<T>> outliers = findOutliers(center, radius2, vertices);
     // increase bouding sphere untill there are no more outliers
     while (!outliers.empty())
     {
         outliers = findOutliers(center, radius2, outliers);
     }
-    // normalize the radius
-    radius = Numerics::Sqrt(radius2);
+    // normalize the radius, grown a little to include the points on the sphere
+    radius = Numerics::Sqrt(radius2) * (1 + Limits<T>::CompareEpsilon);
 }
 
-inline void BoundingSphere::scale(const double& factor)
+template<typename T>
+inline void BoundingSphereT<T>::scale(const double& factor)
 {
     center *= factor;
     radius *= factor;
 }
 
-inline bool BoundingSphere::overlap(const IBoundingObject& other) const
+template<typename T>
+inline bool BoundingSphereT<T>::overlap(const IBoundingObjectT<T>& other) const
 {
     switch (other.getType())
     {
     case Type::Box:
-        return overlap(*(BoundingBox*)(&other));
+        return overlap(*(BoundingBoxT<T>*)(&other));
     case Type::Sphere:
-        return overlap(*(BoundingSphere*)(&other));
+        return overlap(*(BoundingSphereT<T>*)(&other));
     default:
         // maybe some other object can determine overlap with me?
         return other.overlap(*this);
     }
 }
 
-inline bool BoundingSphere::overlap(const BoundingSphere& other) const
+template<typename T>
+inline bool BoundingSphereT<T>::contains(const VertexT<T>& point) const
+{
+    return point.dist2(center) <= radius * radius;
+}
+
+template<typename T>
+inline bool BoundingSphereT<T>::overlap(const BoundingSphereT<T>& other) const
 {
     auto vec = center - other.center;
     return (vec.innerProduct(vec) <= Numerics::Sqr(radius + other.radius));
 }
 
-inline bool BoundingSphere::overlap(const BoundingBox& box) const
+template<typename T>
+inline bool BoundingSphereT<T>::overlap(const BoundingBoxT<T>& box) const
 {
     if( center.x + radius >= box.min.x &&
         center.x - radius <= box.max.x &&
@@ -174,7 +198,7 @@ inline bool BoundingSphere::overlap(const BoundingBox& box) const
         center.z + radius >= box.min.z &&
         center.z - radius <= box.max.z)
     {
-        Vertex corner = center;
+        VertexT<T> corner = center;
         for (size_t i = 0; i < 3; ++i)
         {
             if (center[i] <= box.min[i]) corner[i] = box.min[i];
@@ -188,3 +212,6 @@ inline bool BoundingSphere::overlap(const BoundingBox& box) const
     }
     return false;
 }
+
+typedef BoundingSphereT<Scalar> BoundingSphere;
+typedef BoundingSphereT<float> BoundingSphereF;
@@ -1,5 +1,6 @@
-#pragma once
+﻿#pragma once
 
+#include <array>
 #include <vector>
 
 #include "internal/generic/Points.h"
@@ -11,6 +12,10 @@
 class Contour2D
 {
 public:
+    // counterclockwise indices into the points
+    typedef std::array<size_t, 3> Triangle;
+    typedef std::vector<Triangle> Triangles;
+
     Contour2D() 
         : points()
     {}
@@ -23,6 +28,12 @@ public:
     Contour2D(const Points& points)
         : points(points)
     {}
+    Contour2D(Points&& points)
+        : points(std::move(points))
+    {}
+
+    Contour2D& operator = (const Contour2D& other) = default;
+    Contour2D& operator = (Contour2D&& other) = default;
 
     Contour2D& add(const Scalar& x, const Scalar& y)
     {
@@ -41,6 +52,48 @@ public:
     auto begin() const { return points.begin(); }
     auto end() const { return points.end(); }
 
+    // Signed area, positive for counterclockwise contours
+    Scalar area() const;
+
+    // Triangles covering the contour, see Triangulate
+    Triangles triangulate() const;
+
+    // Triangles covering outer without the holes, using a sweep line
+    // monotone decomposition in O(n log n). The indices count through the
+    // points of outer and then through the points of each hole in turn.
+    // The orientation of the holes doesn't matter, they have to be disjoint
+    // and may not touch or cross each other or outer: the result is undefined
+    // then, crossings met by the sweep throw std::invalid_argument.
+    // Repeated points and spikes without area are skipped.
+    static Triangles Triangulate(const Contour2D& outer, const std::vector<Contour2D>& holes = {});
+
+    enum class Join
+    {
+        Miter, // sharp corners, cut square beyond miterLimit * |delta|
+        Round, // arcs, deviating at most arcTolerance from the true offset
+        Square // corners cut at |delta| from the original corner
+    };
+
+    // The contour grown by delta, or shrunk for a negative delta.
+    // The result can split in several contours or vanish, see Union for its layout.
+    std::vector<Contour2D> offset(const Scalar& delta, const Join join = Join::Miter, const Scalar& miterLimit = 2, const Scalar& arcTolerance = 0) const;
+
+    //
+    // Boolean operations on regions bounded by contours. A point is inside
+    // a region when the contours wind around it (nonzero fill rule), so
+    // counterclockwise contours add area and clockwise contours inside them
+    // make holes. The results are simple contours in the same layout: the
+    // counterclockwise outlines and their clockwise holes.
+    // Crossings are found by halving the bounding box until few edges remain
+    // and decided with exact orientation tests. Throws std::runtime_error in
+    // the unlikely case that rounded crossing points keep creating new ones.
+    //
+    static std::vector<Contour2D> Union(const std::vector<Contour2D>& a, const std::vector<Contour2D>& b = {});
+    static std::vector<Contour2D> Intersection(const std::vector<Contour2D>& a, const std::vector<Contour2D>& b);
+    static std::vector<Contour2D> Difference(const std::vector<Contour2D>& a, const std::vector<Contour2D>& b);
+    // Offset every contour of the region, the holes shrink when the region grows
+    static std::vector<Contour2D> Offset(const std::vector<Contour2D>& contours, const Scalar& delta, const Join join = Join::Miter, const Scalar& miterLimit = 2, const Scalar& arcTolerance = 0);
+
     // predefined contours
     static Contour2D Square(const Point& min = Point(0, 0), const Point& max = Point(1, 1));
     static Contour2D Circle(const Point& center = Point(0, 0), const Scalar& radius = 1, const size_t & pieces = 10);
@@ -1,17 +1,27 @@
 ﻿#pragma once
 
+#include <cstdint>
+#include <limits>
+
 #include "internal/generic/Index.h"
 
+//
+// Half edge. Edges are stored per face, in the order of the face points,
+// so edge and face indices need more range than vertex indices.
+//
 class Edge
 {
 public:
-    Index face;
+    // Used for a missing mirror edge (boundary of an open shape)
+    static constexpr uint32_t none = std::numeric_limits<uint32_t>::max();
+
+    uint32_t face;
 
     Index startVertex;
     Index endVertex;
 
-    Index nextEdge;
-    Index prevEdge;
-    Index mirrorEdge;
+    uint32_t nextEdge;
+    uint32_t prevEdge;
+    uint32_t mirrorEdge;
 };
 
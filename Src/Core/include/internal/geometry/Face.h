@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <initializer_list>
 #include <vector>
 
 #include "internal/generic/Index.h"
@@ -157,12 +158,23 @@ public:
     {
         set(points);
     }
+    Face(std::initializer_list<Index> points)
+        : count(0)
+    {
+        set(points.begin(), (Index)points.size());
+    }
+    Face(const Index* points, const Index count)
+        : count(0)
+    {
+        set(points, count);
+    }
     ~Face()
     {
         clear();
     }
 
     void set(const std::vector<Index>& points);
+    void set(const Index* points, const Index count);
     void copy(const Face& other);
     void swap(Face& other);
     void clear();
@@ -196,23 +208,21 @@ inline void Face::clear()
     count = 0;
 }
 inline void Face::set(const std::vector<Index>& points)
+{
+    set(points.data(), (Index)points.size());
+}
+inline void Face::set(const Index* points, const Index count)
 {
     clear();
-    count = (Index)points.size();
+    this->count = count;
     if (count <= maxFixPoints)
     {
-        for (size_t i = 0; i < count; ++i)
-        {
-            fixPoints[i] = points[i];
-        }
+        std::copy_n(points, count, fixPoints);
     }
     else
     {
         varPoints = new Index[count];
-        for (size_t i = 0; i < count; ++i)
-        {
-            varPoints[i] = points[i];
-        }
+        std::copy_n(points, count, varPoints);
     }
 }
 inline void Face::copy(const Face& other)
@@ -0,0 +1,79 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "internal/generic/Vertex.h"
+#include "internal/generic/Vertices.h"
+
+#include "internal/geometry/Faces.h"
+#include "internal/geometry/Ray.h"
+
+//
+// Bounding volume hierarchy over the (fan triangulated) faces of a shape,
+// built with the binned surface area heuristic.
+// The triangles are copied into the tree in traversal order, so ray queries
+// don't touch the shape data at all.
+//
+class FaceTree
+{
+public:
+    // Number of rays traversing the tree together in intersect(rays,...)
+    static constexpr size_t packetSize = 4;
+
+    void clear();
+    bool empty() const;
+    void build(const Vertices& vertices, const Faces& faces);
+
+    // Nearest hit, or any hit, of a single ray
+    RayHit intersect(const Ray& ray, const bool anyHit) const;
+    // Up to packetSize rays at once. The rays traverse the tree as a packet,
+    // which pays off when they are coherent (similar origin and direction).
+    void intersect(const Ray* rays, RayHit* hits, const size_t count, const bool anyHit) const;
+
+    // Winding number of the faces around origin, counted along a ray:
+    // +1 for every face the ray leaves through (along the face normal), -1 for
+    // every face it enters through. Non zero for points inside a closed shape.
+    int winding(const Vertex& origin) const;
+
+    // Faces with a triangle overlapping the box min-max, a face can be found more than once
+    void overlapping(const Vertex& min, const Vertex& max, std::vector<uint32_t>& faces) const;
+private:
+    struct Node
+    {
+        Scalar min[3];
+        Scalar max[3];
+        // leaf: first triangle, otherwise: first of the two children
+        uint32_t offset;
+        // leaf: number of triangles, otherwise: 0
+        uint32_t count;
+        // split axis, the first child is on the low side
+        uint32_t axis;
+    };
+
+    struct Triangle
+    {
+        Vertex v0;
+        Vertex e1;
+        Vertex e2;
+        uint32_t face;
+        uint32_t triangle;
+    };
+
+    std::vector<Node> nodes;
+    std::vector<Triangle> triangles;
+
+    template<bool ANYHIT> void traverse(const Ray& ray, RayHit& hit) const;
+    template<bool ANYHIT> void traversePacket(const Ray* rays, RayHit* hits, const size_t count) const;
+};
+
+inline void FaceTree::clear()
+{
+    nodes.clear();
+    triangles.clear();
+}
+
+inline bool FaceTree::empty() const
+{
+    return nodes.empty();
+}
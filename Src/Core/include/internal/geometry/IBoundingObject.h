@@ -2,7 +2,8 @@
 
 #include "internal/generic/Vertices.h"
 
-class IBoundingObject
+template<typename T>
+class IBoundingObjectT
 {
 public:
     enum class Type
@@ -11,13 +12,16 @@ public:
         Box = 2,
     };
 
-    virtual ~IBoundingObject() {}
+    virtual ~IBoundingObjectT() {}
     virtual void invalidate() = 0;
     virtual operator bool() const = 0;
     virtual Type getType() const = 0;
-    virtual Scalar calculateVolume() const = 0;
-    virtual void create(const Vertices& vertices) = 0;
+    virtual T calculateVolume() const = 0;
+    virtual void create(const VerticesT<T>& vertices) = 0;
     virtual void scale(const double& factor) = 0;
-    virtual bool overlap(const IBoundingObject& other) const = 0;
+    virtual bool overlap(const IBoundingObjectT& other) const = 0;
+    virtual bool contains(const VertexT<T>& point) const = 0;
 };
 
+typedef IBoundingObjectT<Scalar> IBoundingObject;
+typedef IBoundingObjectT<float> IBoundingObjectF;
@@ -0,0 +1,65 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "internal/generic/Vertex.h"
+#include "internal/generic/Vertices.h"
+
+#include "internal/geometry/Transformation.h"
+
+class ShapeCodec;
+
+//
+// Compact storage of vertices as fixed point coordinates relative to their
+// bounding box: 16 bits per coordinate (6 bytes per vertex) or 21 bits per
+// coordinate packed in 8 bytes, instead of 24 bytes for a Vertex.
+// The error per coordinate is at most half the box size / (2^bits - 1).
+// decode(transformation) folds the dequantization into the transformation,
+// so the vertices are decoded and transformed in one pass. A Shape built
+// from quantized vertices keeps them and uses it for its world space vertices.
+//
+class QuantizedVertices
+{
+public:
+    friend class ShapeCodec;
+
+    enum class Precision
+    {
+        Bits16 = 16,
+        Bits21 = 21,
+    };
+
+    QuantizedVertices();
+    QuantizedVertices(const Vertices& vertices, const Precision precision = Precision::Bits16);
+
+    size_t size() const;
+    bool empty() const;
+    Precision getPrecision() const;
+
+    // Bytes taken by the encoded coordinates
+    size_t getMemorySize() const;
+
+    // Largest difference per coordinate between a vertex and its decoded version
+    Vertex getMaxError() const;
+
+    // Decode a single vertex, or all of them
+    Vertex decode(const size_t index) const;
+    Vertices decode() const;
+
+    // Decode all vertices with the transformation applied, runs on multiple threads
+    Vertices decode(const Transformation& transformation) const;
+
+private:
+    // Integer coordinates of a vertex
+    void coordinates(const size_t index, uint32_t (&q)[3]) const;
+
+    // Decoded vertex is origin + q * step (per coordinate)
+    Vertex origin;
+    Vertex step;
+    Precision precision;
+    // Bits16: 3 values per vertex
+    std::vector<uint16_t> coordinates16;
+    // Bits21: x in the low, z in the high bits
+    std::vector<uint64_t> coordinates21;
+};
@@ -0,0 +1,58 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <limits>
+
+#include "internal/generic/Limits.h"
+#include "internal/generic/Normal.h"
+#include "internal/generic/Vertex.h"
+
+class Ray
+{
+public:
+    Ray()
+        : origin()
+        , direction(0, 0, 1)
+        , maxDistance(Limits<Scalar>::MaxValue)
+    {}
+    // The direction is normalized, so hit distances are real distances
+    Ray(const Vertex& origin, const Normal& direction, const Scalar& maxDistance = Limits<Scalar>::MaxValue)
+        : origin(origin)
+        , direction(direction)
+        , maxDistance(maxDistance)
+    {}
+
+    Vertex origin;
+    Normal direction;
+    Scalar maxDistance;
+};
+
+class RayHit
+{
+public:
+    // Used for the face when nothing was hit
+    static constexpr uint32_t none = std::numeric_limits<uint32_t>::max();
+
+    RayHit()
+        : face(none)
+        , triangle(0)
+        , distance(Limits<Scalar>::MaxValue)
+        , u(0)
+        , v(0)
+    {}
+
+    explicit operator bool() const
+    {
+        return face != none;
+    }
+
+    // The face which was hit
+    uint32_t face;
+    // Faces are split in a fan of triangles (face[0], face[triangle+1], face[triangle+2]),
+    // u and v are the barycentric coordinates of the hit in that triangle:
+    // hit = (1-u-v) * face[0] + u * face[triangle+1] + v * face[triangle+2]
+    uint32_t triangle;
+    Scalar distance;
+    Scalar u;
+    Scalar v;
+};
@@ -1,24 +1,59 @@
 ﻿#pragma once
 
+#include <memory>
+#include <optional>
+#include <type_traits>
+
 #include "internal/generic/Normals.h"
+#include "internal/generic/OnceFlag.h"
 #include "internal/generic/Vertices.h"
 
 #include "internal/geometry/BoundingObject.h"
 #include "internal/geometry/Edges.h"
 #include "internal/geometry/Faces.h"
+#include "internal/geometry/FaceTree.h"
 #include "internal/geometry/FaceVisitor.h"
 #include "internal/geometry/FacesVisitor.h"
+#include "internal/geometry/QuantizedVertices.h"
+#include "internal/geometry/Ray.h"
 #include "internal/geometry/Transformation.h"
 
 class ShapeFactory;
 
+//
+// A shape is an instance of its geometry: the vertices and faces in local
+// space with the data derived from them. Copies share the geometry, so
+// copying is cheap and identical parts take the memory of one. Changing
+// the geometry (scale, weld, optimize) of a shared geometry copies it first.
+// Moving the shape only changes its own transformation and world space data.
+//
+// The const members can be used from several threads at once: each piece of
+// volatile data is computed once, guarded by its own OnceFlag, and read
+// without locking afterwards. Changing a shape while it is read is a race.
+//
 class Shape
 {
 public:
     friend class ShapeFactory;
 
     Shape();
-    Shape(const Vertices & vertices, const Faces & faces);
+    Shape(const Vertices & vertices, const Faces & faces, const bool weldVertices = false);
+    Shape(Vertices && vertices, Faces && faces, const bool weldVertices = false);
+    // From compactly stored vertices (e.g. an asset cache), see QuantizedVertices.
+    // The shape keeps them encoded: the transformed vertices are decoded and
+    // transformed in one pass, the local space vertices are only decoded when
+    // they are needed (getVertices, normals, edges, ...). Changing the
+    // geometry decodes them for good.
+    Shape(const QuantizedVertices & vertices, const Faces & faces);
+    // From single precision vertices, kept the same way at half the memory:
+    // the transformed vertices are computed from them in double precision.
+    // Only taken for VerticesF, braced vertex lists stay double precision.
+    template<typename V, typename = std::enable_if_t<std::is_same_v<std::decay_t<V>, VerticesF>>>
+    Shape(V && vertices, Faces faces)
+        : Shape()
+    {
+        setSingleVertices(VerticesF(std::forward<V>(vertices)), std::move(faces));
+    }
     Shape(const Shape & other);
     Shape(Shape && other) noexcept;
 
@@ -31,15 +66,68 @@ public:
     // Rotate the shape
     void rotate(const Normal& axis, const Scalar& angle);
 
+    // Merge vertices which are equal within tolerance (per coordinate).
+    // Faces are remapped in place, collapsed points and faces are removed.
+    void weld(const Scalar& tolerance = Limits<Scalar>::CompareEpsilon);
+
+    // Remove unused vertices.
+    // With improveLocality the faces are reordered so consecutive faces share
+    // vertices (Tipsify) and the vertices are renumbered in order of first use,
+    // so per face loops over the vertices stay within a few cache lines.
+    void optimize(const bool improveLocality = false);
+
     // Calculate the shape surface area
     Scalar calculateSurfaceArea() const;
 
     // Calculate the shape volume
     Scalar calculateVolume() const;
 
-    // Determine if shapes overlap
+    // Simplify the shape with quadric error edge collapses (Garland & Heckbert).
+    // The faces are triangulated first, collapsing stops at targetFaceCount
+    // triangles or when a collapse would move the surface more than maxError.
+    Shape simplify(const size_t& targetFaceCount, const Scalar& maxError = Limits<Scalar>::MaxValue) const;
+
+    // Get a simplified version of the shape: level 0 is the shape itself, 
+    // each next level has about half the faces of the previous one.
+    // Returns the coarsest level available if the shape can't be reduced further.
+    // All levels are built on first use, so the references stay valid.
+    const Shape& getLevelOfDetail(const size_t& level) const;
+
+    // Nearest intersection of a ray with the (transformed) shape.
+    // The ray is moved into the local space of the shape, so the transformed
+    // vertices aren't needed. The face tree is built on first use.
+    RayHit raycast(const Ray& ray) const;
+    // Any intersection, cheaper when only visibility matters
+    RayHit raycastAny(const Ray& ray) const;
+    // Batch versions, the rays are traversed in packets of FaceTree::packetSize
+    // on multiple threads. Keep coherent rays next to each other.
+    std::vector<RayHit> raycast(const std::vector<Ray>& rays) const;
+    std::vector<RayHit> raycastAny(const std::vector<Ray>& rays) const;
+
+    // Determine if a point is inside the (transformed) shape, the shape should be closed.
+    // Points outside the bounds are rejected early, the others are counted
+    // against the faces along a ray through the face tree.
+    bool contains(const Vertex& point) const;
+    // Batch version, inside[i] is set for points[i]. Runs on multiple threads.
+    void contains(const Vertices& points, std::vector<bool>& inside) const;
+
+    // Determine if shapes overlap.
+    // Convex shapes are tested with GJK, which needs a handful of support
+    // point lookups instead of a pass over all faces.
     bool detectCollision(const Shape& other) const;
 
+    // True for a closed shape which is convex at every edge (computed once)
+    bool isConvex() const;
+
+    // Distance between the (transformed) shapes with GJK, 0 when they overlap.
+    // Non convex shapes are treated as their convex hull.
+    Scalar calculateDistance(const Shape& other) const;
+
+    // Penetration depth of overlapping shapes with EPA, 0 when they don't overlap.
+    // Moving other over direction * depth separates the shapes.
+    // Non convex shapes are treated as their convex hull.
+    Scalar calculatePenetration(const Shape& other, Normal& direction) const;
+
     // Get vertices
     const Vertices& getVertices() const;
     const Vertices& getTransformedVertices() const;
@@ -48,6 +136,9 @@ public:
     const Normals& getNormals() const;
     const Normals& getTransformedNormals() const;
 
+    // Get the half edges, stored per face in the order of the face points
+    const Edges& getEdges() const;
+
     // Get faces
     const Faces& getRawFaces() const;
     const Face& getRawFace(const size_t& index) const;
@@ -56,41 +147,106 @@ public:
     FaceVisitor getFace(const size_t& index) const;
     FaceVisitor getTransformedFace(const size_t& index) const;
 private:
+    // Vertices, faces and their local space data, shared between copies
+    struct Geometry
+    {
+        Geometry();
+        Geometry(const Vertices& vertices, const Faces& faces);
+        Geometry(Vertices&& vertices, Faces&& faces);
+        Geometry(const QuantizedVertices& quantized, const Faces& faces);
+        Geometry(VerticesF&& singleVertices, Faces&& faces);
+        Geometry(const Geometry& other);
+
+        // The points (vertices) of each face
+        Faces faces;
+
+        // Vertices are stored in the shape:
+        // - to save space (same vertex used in multiple faces)
+        // - so transformations can be applied on all vertices at once
+        // A geometry built from quantized or single precision vertices
+        // converts them on first use (volatile data then), otherwise they
+        // are always ready.
+        mutable Vertices vertices;
+        OnceFlag verticesReady;
+
+        // The compact vertices the geometry was built from, at most one of
+        // them is used. Empty otherwise or once the geometry has changed.
+        QuantizedVertices quantized;
+        VerticesF singleVertices;
+
+        // The normals for each face (volatile data)
+        mutable Normals normals;
+        OnceFlag normalsReady;
+
+        // The surface area for each face (volatile data)
+        mutable std::vector<Scalar> surfaceAreas;
+        OnceFlag surfaceAreasReady;
+
+        // The edges for each face (volatile data)
+        mutable Edges edges;
+
+        // One edge starting at each vertex (volatile data, comes with the edges)
+        mutable std::vector<uint32_t> vertexEdges;
+        OnceFlag edgesReady;
+
+        // Set when the shape is closed and convex (volatile data)
+        mutable std::optional<bool> convex;
+        OnceFlag convexReady;
+
+        // Bounding volume hierarchy of the faces in local space (volatile data)
+        mutable FaceTree faceTree;
+        OnceFlag faceTreeReady;
+    };
+    std::shared_ptr<Geometry> geometry;
+
     // The transformation (rotation + translation only) to apply on the vertices
     Transformation transformation;
 
-    // The points (vertices) of each face
-    Faces faces;
-
-    // Vertices are stored in the shape:
-    // - to save space (same vertex used in multiple faces)
-    // - so transformations can be applied on all vertices at once
-    Vertices vertices;
-    
-    // The vertices with the transformation applied
+    // The vertices with the transformation applied (volatile data)
     mutable Vertices transformedVertices;
-
-    // The normals for each face (volatile data)
-    mutable Normals normals;
+    OnceFlag transformedVerticesReady;
 
     // The normals with the transformation applied (volatile data)
     mutable Normals transformedNormals;
+    OnceFlag transformedNormalsReady;
 
-    // The surface area for each face (volatile data)
-    mutable std::vector<Scalar> surfaceAreas;
+    // Any class inheriting from IBoundingBox, in world space (volatile data)
+    mutable BoundingObject bounds;
+    OnceFlag boundsReady;
 
-    // The edges for each face (volatile data)
-    mutable Edges edges;
+    // Simplified versions of the shape, level 1 and up (volatile data)
+    mutable std::vector<Shape> levelsOfDetail;
+    OnceFlag levelsOfDetailReady;
 
-    // Any class inheriting from IBoundingBox (volatile data)  
-    mutable BoundingObject bounds;
+    // The geometry shared by default constructed (and moved from) shapes
+    static const std::shared_ptr<Geometry>& EmptyGeometry();
+
+    // The geometry for a change, copied first when it is shared.
+    // The vertices are decoded first, the compact ones are dropped.
+    Geometry& modifyGeometry();
+
+    // Constructor helper, optimize when not all compact vertices are used
+    void removeUnusedCompactVertices(const size_t vertexCount);
+    // Constructor helper, keeps the single precision vertices as the geometry
+    void setSingleVertices(VerticesF && vertices, Faces && faces);
 
-    // Remove unused vertices
-    void optimize();
+    // Locality passes for optimize
+    void reorderFaces();
+    void reorderVertices();
+
+    // Vertex furthest in direction (local space). Convex shapes hill climb
+    // over the edges from start, others check all vertices.
+    Index support(const Vertex& direction, const Index start) const;
+
+    // GJK overlap test, for convex shapes
+    bool overlapConvex(const Shape& other) const;
 
     // Invalidate volatile data
     void invalidateBounds() const;
+    void invalidateConvexity() const;
     void invalidateEdges() const;
+    void invalidateFaceTree() const;
+    void invalidateLevelsOfDetail() const;
     void invalidateNormals() const;
     void invalidateTransformedNormals() const;
     void invalidateSurfaceAreas() const;
@@ -98,24 +254,31 @@ private:
 
     // Initialize volatile data if needed
     void requireBounds() const;
+    void requireConvexity() const;
     void requireEdges() const;
+    void requireFaceTree() const;
+    void requireLevelsOfDetail() const;
     void requireNormals() const;
     void requireTransformedNormals() const;
     void requireSurfaceAreas() const;
     void requireTransformedVertices() const;
+    void requireVertices() const;
+
+    std::vector<RayHit> raycast(const std::vector<Ray>& rays, const bool anyHit) const;
 };
 
 inline FacesVisitor Shape::getFaces() const
 {
+    requireVertices();
     requireNormals();
-    return FacesVisitor(faces,vertices,normals);
+    return FacesVisitor(geometry->faces, geometry->vertices, geometry->normals);
 }
 
 inline FacesVisitor Shape::getTransformedFaces() const
 {
     requireTransformedNormals();
     requireTransformedVertices();
-    return FacesVisitor(faces, transformedVertices, transformedNormals);
+    return FacesVisitor(geometry->faces, transformedVertices, transformedNormals);
 }
 
 
@@ -0,0 +1,27 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "internal/geometry/QuantizedVertices.h"
+#include "internal/geometry/Shape.h"
+
+//
+// Compressed binary format for the faces and vertices of a shape.
+// The faces are coded corner by corner: the next corner is predicted from the
+// open (not yet shared) edges of the faces before, from recently used
+// vertices, or it is a vertex seen for the first time. Vertices are stored in
+// order of first use, quantized (see QuantizedVertices) and predicted across
+// the shared edge (parallelogram rule) or from the previous corner.
+// All decisions and residuals go through an adaptive binary range coder.
+// Only the local space geometry is stored, unused vertices are dropped.
+//
+class ShapeCodec
+{
+public:
+    static std::vector<uint8_t> Encode(const Shape& shape, const QuantizedVertices::Precision precision = QuantizedVertices::Precision::Bits16);
+
+    // Throws std::invalid_argument when the data isn't valid
+    static Shape Decode(const std::vector<uint8_t>& data);
+    static Shape Decode(const uint8_t* data, const size_t size);
+};
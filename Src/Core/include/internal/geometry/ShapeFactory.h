@@ -4,6 +4,7 @@
 #include "internal/generic/Vertex.h"
 
 #include "internal/geometry/Contour2D.h"
+#include "internal/geometry/Contour3D.h"
 #include "internal/geometry/Shape.h"
 
 class ShapeFactory
@@ -13,7 +14,53 @@ public:
     static Shape Dodecahedron(const Vertex& center = Vertex(0, 0, 0), const Scalar& radius = 1);
     static Shape Octahedron(const Vertex& center = Vertex(0, 0, 0), const Scalar& radius = 1);
 
+    // Number of segments for a circle so no chord is further than tolerance from the circle.
+    // Use it to pick the segments of the round shapes below.
+    static size_t Segments(const Scalar& radius, const Scalar& tolerance);
+
+    // Round shapes have their axis along z, center is the middle of the shape,
+    // except for the cone, where it is the middle of the base.
+    // They need at least 3 segments and 2 rings (1 per half sphere for the
+    // capsule), else std::invalid_argument is thrown.
+    // UV sphere: segments around the axis, rings from pole to pole
+    static Shape Sphere(const Vertex& center = Vertex(0, 0, 0), const Scalar& radius = 1, const size_t& segments = 16, const size_t& rings = 8);
+    // Subdivided icosahedron: 20 * 4^levels triangles
+    static Shape Icosphere(const Vertex& center = Vertex(0, 0, 0), const Scalar& radius = 1, const size_t& levels = 2);
+    static Shape Cylinder(const Vertex& center = Vertex(0, 0, 0), const Scalar& radius = 1, const Scalar& height = 1, const size_t& segments = 16);
+    static Shape Cone(const Vertex& center = Vertex(0, 0, 0), const Scalar& radius = 1, const Scalar& height = 1, const size_t& segments = 16);
+    static Shape Torus(const Vertex& center = Vertex(0, 0, 0), const Scalar& majorRadius = 1, const Scalar& minorRadius = 0.25, const size_t& majorSegments = 24, const size_t& minorSegments = 12);
+    // Cylinder of height with half spheres on both ends, rings per half sphere
+    static Shape Capsule(const Vertex& center = Vertex(0, 0, 0), const Scalar& radius = 1, const Scalar& height = 1, const size_t& segments = 16, const size_t& rings = 4);
+
     // contour should be defined counterclockwise.
-    static Shape Extrusion(const Contour2D& contour = Contour2D::Square(), const Scalar& height = 1);
+    // The caps are single faces, or triangles with triangulateCaps.
+    static Shape Extrusion(const Contour2D& contour = Contour2D::Square(), const Scalar& height = 1, const bool triangulateCaps = false);
+
+    // The profile (counterclockwise) moved along the path, its x and y axes
+    // follow rotation minimizing frames. Open paths get caps at both ends,
+    // a closed path connects its end to its start with the twist spread out.
+    // Long paths are generated in parallel. Consecutive path points must differ.
+    static Shape Sweep(const Contour2D& profile, const Contour3D& path, const bool closedPath = false);
+    // The profile (counterclockwise) rotated around axis, x is the distance
+    // to the axis and y the position along it. Points on the axis become
+    // single vertices, negative x throws. The axis can't be zero.
+    static Shape Revolve(const Contour2D& profile, const Vertex& axis = Vertex(0, 0, 1), const size_t& segments = 16);
+
+    // Subdivision surfaces, each level multiplies the face count by 4 (Loop) 
+    // or by the face size (Catmull-Clark).
+    // Loop subdivision needs a triangle shape, Catmull-Clark accepts any
+    // polygons and returns quads. Open borders are kept as crease curves.
+    static Shape LoopSubdivision(const Shape& shape, const size_t& levels = 1);
+    static Shape CatmullClarkSubdivision(const Shape& shape, const size_t& levels = 1);
+
+    // Convex hull (Quickhull) as a triangle shape, the points shouldn't all be in one plane
+    static Shape ConvexHull(const Vertices& points);
+
+    // Boolean operations on closed shapes, the result is in world space (the
+    // transformations of a and b are applied). Faces of a and b which overlap
+    // in the same plane end up in the result once or not at all.
+    static Shape Union(const Shape& a, const Shape& b);
+    static Shape Intersection(const Shape& a, const Shape& b);
+    static Shape Difference(const Shape& a, const Shape& b);
 };
 
@@ -1,29 +1,190 @@
 ﻿#pragma once
 
+#include <cmath>
+
 #include "internal/generic/Matrix.h"
 #include "internal/generic/Normal.h"
 #include "internal/generic/Vertex.h"
 #include "internal/generic/Vertices.h"
 #include "internal/generic/Scalar.h"
 
-class Transformation
+// A rigid transformation (rotation + translation), T is the precision
+template<typename T>
+class TransformationT
 {
 public:
-    Transformation();
-    Transformation(const Transformation & other);
-    Transformation(Transformation && other) noexcept;
-    Transformation(const Vertex & translation);
-    Transformation(const Normal& axis, const Scalar& angle);
-    Transformation(const Normal& axis, const Normal& up);
+    template<typename T2> friend class TransformationT;
+
+    TransformationT();
+    TransformationT(const TransformationT & other);
+    TransformationT(TransformationT && other) noexcept;
+    TransformationT(const VertexT<T> & translation);
+    TransformationT(const NormalT<T>& axis, const T& angle);
+    TransformationT(const NormalT<T>& axis, const NormalT<T>& up);
+    // Conversion between precisions
+    template<typename T2>
+    explicit TransformationT(const TransformationT<T2>& other);
+
+    VertexT<T> operator * (const VertexT<T>& v) const;
+    VerticesT<T> operator * (const VerticesT<T>& v) const;
+
+    // Apply the rotation only, for directions
+    VertexT<T> rotate(const VertexT<T>& direction) const;
 
-    Vertex operator * (const Vertex& v) const;
-    Vertices operator * (const Vertices& v) const;
+    // The inverse, assuming a rigid transformation (rotation + translation)
+    TransformationT inverted() const;
 
-    const Transformation  operator *  (const Transformation& other) const;
-          Transformation& operator *= (const Transformation& other);
+    const TransformationT  operator *  (const TransformationT& other) const;
+          TransformationT& operator *= (const TransformationT& other);
 
-    Transformation& operator = (const Transformation& other);
+    TransformationT& operator = (const TransformationT& other);
 protected:
-    Matrix<4,4,Scalar> transform;
+    Matrix<4,4,T> transform;
 };
 
+template<typename T>
+inline TransformationT<T>::TransformationT()
+    : transform(
+        {
+            1, 0, 0, 0,
+            0, 1, 0, 0,
+            0, 0, 1, 0,
+            0, 0, 0, 1
+        })
+{}
+
+template<typename T>
+inline TransformationT<T>::TransformationT(const TransformationT<T>& other)
+    : transform(other.transform)
+{}
+
+template<typename T>
+inline TransformationT<T>::TransformationT(TransformationT<T> && other) noexcept
+    : transform(std::move(other.transform))
+{}
+
+template<typename T>
+inline TransformationT<T>::TransformationT(const VertexT<T> & translation)
+    : transform(
+        {
+            1, 0, 0, translation.x,
+            0, 1, 0, translation.y,
+            0, 0, 1, translation.z,
+            0, 0, 0, 1
+        })
+{}
+
+template<typename T>
+inline TransformationT<T>::TransformationT(const NormalT<T> & axis, const T & angle)
+{
+    const auto n = axis.normalized();
+    const auto& x = n.x;
+    const auto& y = n.y;
+    const auto& z = n.z;
+    const auto c = std::cos(angle);
+    const auto s = std::sin(angle);
+    transform =
+    { 
+        x*x*(1-c)+1*c, y*x*(1-c)-z*s, z*x*(1-c)+y*s, 0,
+        x*y*(1-c)+z*s, y*y*(1-c)+1*c, z*y*(1-c)-x*s, 0,
+        x*z*(1-c)-y*s, y*z*(1-c)+x*s, z*z*(1-c)+1*c, 0,
+        0,             0,             0,             1
+    };
+}
+
+template<typename T>
+inline TransformationT<T>::TransformationT(const NormalT<T>& axis, const NormalT<T>& up)
+{
+    auto xAxis = NormalT<T>(up.crossProduct(axis));
+    auto yAxis = NormalT<T>(axis.crossProduct(xAxis));
+    transform =
+    {
+        xAxis.x, xAxis.y, xAxis.z, 0,
+        yAxis.x, yAxis.y, yAxis.z, 0,
+        axis.x,  axis.y,  axis.z,  0,
+        0,       0,       0,       1
+    };
+}
+
+template<typename T>
+template<typename T2>
+inline TransformationT<T>::TransformationT(const TransformationT<T2>& other)
+{
+    for (size_t i = 0; i < transform.elements; ++i)
+    {
+        transform[i] = (T)other.transform[i];
+    }
+}
+
+template<typename T>
+inline VertexT<T> TransformationT<T>::operator*(const VertexT<T> & vertex) const
+{
+    T x = transform[ 0] * vertex.x + transform[ 1] * vertex.y + transform[ 2] * vertex.z + transform[ 3];
+    T y = transform[ 4] * vertex.x + transform[ 5] * vertex.y + transform[ 6] * vertex.z + transform[ 7];
+    T z = transform[ 8] * vertex.x + transform[ 9] * vertex.y + transform[10] * vertex.z + transform[11];
+    return { x, y, z };
+}
+
+template<typename T>
+inline VerticesT<T> TransformationT<T>::operator*(const VerticesT<T>& vertices) const
+{
+    VerticesT<T> res;
+    res.reserve(vertices.size());
+    for (const auto& vertex : vertices)
+    {
+        res.emplace_back(*this * vertex);
+    }
+    return res;
+}
+
+template<typename T>
+inline VertexT<T> TransformationT<T>::rotate(const VertexT<T>& direction) const
+{
+    T x = transform[ 0] * direction.x + transform[ 1] * direction.y + transform[ 2] * direction.z;
+    T y = transform[ 4] * direction.x + transform[ 5] * direction.y + transform[ 6] * direction.z;
+    T z = transform[ 8] * direction.x + transform[ 9] * direction.y + transform[10] * direction.z;
+    return { x, y, z };
+}
+
+template<typename T>
+inline TransformationT<T> TransformationT<T>::inverted() const
+{
+    // [R t]^-1 = [R' -R't]
+    TransformationT<T> res;
+    for (size_t row = 0; row < 3; ++row)
+    {
+        for (size_t column = 0; column < 3; ++column)
+        {
+            res.transform[4 * row + column] = transform[4 * column + row];
+        }
+    }
+    for (size_t row = 0; row < 3; ++row)
+    {
+        res.transform[4 * row + 3] = -(res.transform[4 * row + 0] * transform[3] + res.transform[4 * row + 1] * transform[7] + res.transform[4 * row + 2] * transform[11]);
+    }
+    return res;
+}
+
+template<typename T>
+inline const TransformationT<T> TransformationT<T>::operator*(const TransformationT<T>& other) const
+{
+    return TransformationT<T>(*this)*=other;
+}
+
+template<typename T>
+inline TransformationT<T>& TransformationT<T>::operator*=(const TransformationT<T>& other)
+{
+    transform *= other.transform;
+    return *this;
+}
+
+template<typename T>
+inline TransformationT<T>& TransformationT<T>::operator=(const TransformationT<T>& other)
+{
+    transform = other.transform;
+    return *this;
+}
+
+typedef TransformationT<Scalar> Transformation;
+typedef TransformationT<float> TransformationF;
+typedef TransformationT<double> TransformationD;
@@ -0,0 +1,133 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "internal/generic/Scalar.h"
+
+//
+// Text output collected in one block, which is handed to the sink when it
+// is full. Numbers are formatted with std::to_chars, so there is no locale
+// or stream state involved. The remainder is flushed on destruction.
+//
+class OutputBuffer
+{
+public:
+    typedef std::function<void(const char* data, const size_t size)> Sink;
+
+    OutputBuffer(Sink sink, const size_t capacity = 1 << 20);
+    // Write blocks to the stream
+    OutputBuffer(std::ostream& os, const size_t capacity = 1 << 20);
+    // Write blocks to the file, the file's own buffering is switched off
+    OutputBuffer(std::FILE* file, const size_t capacity = 1 << 20);
+    OutputBuffer(const OutputBuffer& other) = delete;
+    ~OutputBuffer();
+
+    void flush();
+
+    // significant digits of the floating point numbers, 5 by default.
+    // Limited to 1..17, 17 digits tell every double apart and any number
+    // then fits the room reserved for it.
+    void setPrecision(const int precision)
+    {
+        this->precision = std::clamp(precision, 1, 17);
+    }
+
+    OutputBuffer& operator << (const char c);
+    OutputBuffer& operator << (const char* text);
+    OutputBuffer& operator << (const std::string& text);
+    OutputBuffer& operator << (const int value);
+    OutputBuffer& operator << (const size_t value);
+    OutputBuffer& operator << (const Scalar value);
+
+    // two lowercase hexadecimal digits
+    OutputBuffer& hex(const unsigned char value);
+    OutputBuffer& write(const char* data, const size_t size);
+
+private:
+    Sink sink;
+    std::vector<char> data;
+    size_t used;
+    int precision;
+
+    // room for count characters at the end of the block
+    char* reserve(const size_t count)
+    {
+        if (used + count > data.size())
+        {
+            flush();
+        }
+        return data.data() + used;
+    }
+};
+
+inline OutputBuffer& OutputBuffer::operator << (const char c)
+{
+    *reserve(1) = c;
+    ++used;
+    return *this;
+}
+
+inline OutputBuffer& OutputBuffer::operator << (const char* text)
+{
+    return write(text, std::strlen(text));
+}
+
+inline OutputBuffer& OutputBuffer::operator << (const std::string& text)
+{
+    return write(text.data(), text.size());
+}
+
+inline OutputBuffer& OutputBuffer::operator << (const int value)
+{
+    char* begin = reserve(16);
+    used = std::to_chars(begin, begin + 16, value).ptr - data.data();
+    return *this;
+}
+
+inline OutputBuffer& OutputBuffer::operator << (const size_t value)
+{
+    char* begin = reserve(24);
+    used = std::to_chars(begin, begin + 24, value).ptr - data.data();
+    return *this;
+}
+
+inline OutputBuffer& OutputBuffer::operator << (const Scalar value)
+{
+    char* begin = reserve(32);
+    used = std::to_chars(begin, begin + 32, value, std::chars_format::general, precision).ptr - data.data();
+    return *this;
+}
+
+inline OutputBuffer& OutputBuffer::hex(const unsigned char value)
+{
+    static const char digits[] = "0123456789abcdef";
+    char* begin = reserve(2);
+    begin[0] = digits[value >> 4];
+    begin[1] = digits[value & 15];
+    used += 2;
+    return *this;
+}
+
+inline OutputBuffer& OutputBuffer::write(const char* text, const size_t size)
+{
+    if (size == 0)
+    {
+        return *this;
+    }
+    if (size > data.size())
+    {
+        flush();
+        sink(text, size);
+        return *this;
+    }
+    std::memcpy(reserve(size), text, size);
+    used += size;
+    return *this;
+}
@@ -0,0 +1,87 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "internal/generic/Scalar.h"
+
+#include "internal/geometry/Shape.h"
+
+#include "internal/utilities/OutputBuffer.h"
+#include "internal/utilities/svg.h"
+
+//
+// Software renderer for thumbnails: shapes are drawn with flat shading into
+// a z-buffered image of a fixed size, whatever the number of faces.
+// It uses the camera of the SVG output, so both show the same picture.
+//
+// The triangles are collected by addShape and drawn on the first write (or
+// render). The image is split in tiles, every tile gets the triangles which
+// overlap it and the tiles are drawn on multiple threads.
+//
+class Raster
+{
+public:
+    typedef SVG::Color::RGB RGB;
+
+    enum class Format
+    {
+        PPM, // binary portable pixmap
+        PNG, // uncompressed (stored deflate blocks)
+    };
+
+    Raster(const int width, const int height, const SVG::ViewBox& viewBox, const SVG::View& view = SVG::View());
+
+    void setView(const SVG::View& view);
+    // Fill the image with the background color and clear the depth
+    void clear(const RGB& background = RGB(255, 255, 255));
+
+    // Add the faces of the shape, shaded by the angle with the view direction
+    void addShape(const Shape& shape, const RGB& color);
+
+    // Draw the triangles added since the last render
+    void render();
+
+    RGB getPixel(const int x, const int y);
+
+    void writeToBuffer(OutputBuffer& out, const Format format);
+    void writeToStream(std::ostream& os, const Format format);
+    void writeToFile(const std::string& filename, const Format format);
+
+    int getWidth() const
+    {
+        return width;
+    }
+    int getHeight() const
+    {
+        return height;
+    }
+
+private:
+    // Triangle in pixel coordinates with the depth of the view
+    struct Triangle
+    {
+        Scalar x[3];
+        Scalar y[3];
+        Scalar z[3];
+        uint32_t color;
+    };
+
+    static const int tileSize = 64;
+
+    const int width;
+    const int height;
+    const SVG::ViewBox viewBox;
+    SVG::View view;
+
+    // 0xBBGGRR per pixel, row by row from the top
+    std::vector<uint32_t> pixels;
+    std::vector<Scalar> depths;
+    std::vector<Triangle> triangles;
+
+    void drawTile(const int tileX, const int tileY, const std::vector<uint32_t>& bin);
+    void writePPM(OutputBuffer& out);
+    void writePNG(OutputBuffer& out);
+};
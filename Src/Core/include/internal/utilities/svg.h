@@ -1,6 +1,7 @@
 ﻿#pragma once
 
 #include <map>
+#include <mutex>
 #include <ostream>
 #include <string>
 #include <variant>
@@ -10,10 +11,13 @@
 #include "internal/generic/Points.h"
 #include "internal/generic/Scalar.h"
 #include "internal/generic/Vertex.h"
+#include "internal/generic/Vertices.h"
 
 #include "internal/geometry/Shape.h"
 #include "internal/geometry/Transformation.h"
 
+#include "internal/utilities/OutputBuffer.h"
+
 class SVG
 {
 public:
@@ -34,6 +38,7 @@ public:
             , up(other.up)
             , transformation(other.transformation)
         {}
+        View& operator = (const View& other) = default;
 
         Vertex center;
         Vertex eye;
@@ -60,6 +65,7 @@ public:
         Point max;
 
         friend std::ostream& operator <<(std::ostream& os, const ViewBox& viewBox);
+        friend OutputBuffer& operator <<(OutputBuffer& out, const ViewBox& viewBox);
     };
 
     struct Color
@@ -107,6 +113,7 @@ public:
         bool operator != (const Color& other) const;
 
         friend std::ostream& operator <<(std::ostream& os, const Color& color);
+        friend OutputBuffer& operator <<(OutputBuffer& out, const Color& color);
     private:
         std::variant<Predefined,RGB> data;
         static std::map<Predefined, std::string> predefinedColors;
@@ -149,74 +156,101 @@ public:
         bool operator != (const Style& other) const;
 
         friend std::ostream& operator <<(std::ostream& os, const Style &style);
+        friend OutputBuffer& operator <<(OutputBuffer& out, const Style &style);
     };
 
+    // The objects refer to their style by its index in styles
+
     struct Axis
     {
-        Axis(const std::string & classId, const Point& tail, const Point& head, const Scalar& z)
-            : classId(classId)
+        Axis(const size_t style, const Point& tail, const Point& head, const Scalar& z)
+            : style(style)
             , tail(tail)
             , head(head)
             , z(z)
         {}
 
-        std::string classId;
+        size_t style;
         Point tail;
         Point head;
         Scalar z;
-
-        friend std::ostream& operator <<(std::ostream& os, const Axis & axis);
     };
 
+    // The points are in pathVertices, from first on
     struct Path
     {
-        Path(const std::string& classId, const Points& points, const Scalar & z)
-            : classId(classId)
-            , points(points)
+        Path(const size_t style, const size_t first, const size_t count, const Scalar & z)
+            : style(style)
+            , first(first)
+            , count(count)
             , z(z)
         {}
 
-        std::string classId;
-        Points points;
+        size_t style;
+        size_t first;
+        size_t count;
         Scalar z;
-
-        friend std::ostream& operator <<(std::ostream& os, const Path & path);
     };
 
     struct Text
     {
-        Text(const std::string& classId, const std::string & text, const Point& point, const Scalar& z)
-            : classId(classId)
+        Text(const size_t style, const std::string & text, const Point& point, const Scalar& z)
+            : style(style)
             , text(text)
             , point(point)
             , z(z)
         {
         }
 
-        std::string classId;
+        size_t style;
         std::string text;
         Point point;
         Scalar z;
+    };
 
-        friend std::ostream& operator <<(std::ostream& os, const Text& text);
+    typedef std::variant<Axis, Path, Text> Object;
+    typedef std::vector<Object> Objects;
+
+    // How the objects are put in drawing order
+    enum class HiddenSurface
+    {
+        // sort by mean depth, wrong for intersecting or cyclic overlapping faces
+        Painter,
+        // split the faces with a BSP tree and draw them back to front
+        BSP,
+        // as BSP, and leave out faces covered by opaque faces in front of them
+        BSPClipped,
     };
 
     SVG(const int width, const int height, const ViewBox& viewBox, const View & view = View());
     
     void setView(const View& view);
+    void setHiddenSurface(const HiddenSurface hiddenSurface);
+    // Merge neighbouring faces in the same plane into one path (off by default)
+    void setMergeCoplanarFaces(const bool mergeCoplanarFaces);
 
+    // All writers format into an OutputBuffer, which passes large blocks on
     void writeToStream(std::ostream & os);
     void writeToFile(const std::string & filename);
     std::string writeToString();
+    void writeToBuffer(OutputBuffer & out);
 
     Style& getStyle()
     {
         return style;
     }
-    void setStyleId(Style &style);
+    // Set the id of style, adding it when it is new. Returns its index.
+    size_t setStyleId(Style &style);
 
     void addAxis(const Vertex & center, const double length);
-    void addShape(const Shape& shape, const Vertex& center);
+    // Add the faces of the shape as paths. With cullBackFaces the faces
+    // turned away from the viewer are skipped, which is safe for closed shapes.
+    // addShape may be called from several threads, as long as the style and
+    // view aren't changed meanwhile and each shape is only added by one thread.
+    // The shapes end up in the order the calls finish.
+    void addShape(const Shape& shape, const Vertex& center, const bool cullBackFaces = false);
+    // Add the shapes in order, they are projected on multiple threads
+    void addShapes(const std::vector<Shape>& shapes, const bool cullBackFaces = false);
     void addText(const std::string &text, const Vertex& start);
 
     friend std::ostream& operator << (std::ostream& os, const SVG& svg);
@@ -225,19 +259,40 @@ private:
     const int height;
     const ViewBox viewBox;
     View view;
+    HiddenSurface hiddenSurface;
+    bool mergeCoplanarFaces;
 
     Style style;
     std::vector<Style> styles;
-    std::vector<std::variant<Axis, Path, Text>> objects;
+    Objects objects;
+    // The projected points of the paths, z is kept for the hidden surface removal
+    Vertices pathVertices;
+    // Guards styles, objects and pathVertices in addShape
+    std::mutex mutex;
 
     Vertex project(const Vertex & v) const;
+
+    // Project the faces of the shape, the paths refer to shapeVertices
+    void projectShape(const Shape& shape, const size_t styleIndex, const bool cullBackFaces, Objects& shapeObjects, Vertices& shapeVertices) const;
+    // As projectShape, faces in the same plane connected by edges are one path
+    void projectMergedShape(const Shape& shape, const size_t styleIndex, const bool cullBackFaces, Objects& shapeObjects, Vertices& shapeVertices) const;
+    // Add projected objects, their paths are moved behind pathVertices
+    void appendObjects(Objects& newObjects, const Vertices& newVertices);
+
+    // The objects in drawing order. Split paths add their points to vertices,
+    // which starts as a copy of pathVertices.
+    Objects orderObjects(Vertices& vertices) const;
+    Objects orderObjectsBSP(Vertices& vertices) const;
+    void removeOccluded(Objects& ordered, const Vertices& vertices) const;
 };
 
 std::ostream& operator << (std::ostream& os, const SVG& svg);
-std::ostream& operator << (std::ostream& os, const SVG::Axis& axis);
 std::ostream& operator << (std::ostream& os, const SVG::Color& color);
-std::ostream& operator << (std::ostream& os, const SVG::Path& path);
 std::ostream& operator << (std::ostream& os, const SVG::StrokeLineJoin& strokeLineJoin);
 std::ostream& operator << (std::ostream& os, const SVG::Style& style);
-std::ostream& operator << (std::ostream& os, const SVG::Text& text);
 std::ostream& operator << (std::ostream& os, const SVG::ViewBox& viewBox);
+
+OutputBuffer& operator << (OutputBuffer& out, const SVG::Color& color);
+OutputBuffer& operator << (OutputBuffer& out, const SVG::StrokeLineJoin& strokeLineJoin);
+OutputBuffer& operator << (OutputBuffer& out, const SVG::Style& style);
+OutputBuffer& operator << (OutputBuffer& out, const SVG::ViewBox& viewBox);
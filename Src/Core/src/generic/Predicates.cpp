@@ -0,0 +1,306 @@
+﻿#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "internal/generic/Predicates.h"
+
+namespace
+{
+    //
+    // Expansions: sums of non overlapping doubles, ordered by increasing magnitude,
+    // without zeros. The sign of an expansion is the sign of its last component.
+    //
+    typedef std::vector<Scalar> Expansion;
+
+    constexpr Scalar epsilon = std::numeric_limits<Scalar>::epsilon() / 2;
+    constexpr Scalar orient2dBound = (3 + 16 * epsilon) * epsilon;
+    constexpr Scalar orient3dBound = (7 + 56 * epsilon) * epsilon;
+    constexpr Scalar inCircleBound = (10 + 96 * epsilon) * epsilon;
+    constexpr Scalar inSphereBound = (16 + 224 * epsilon) * epsilon;
+
+    // x + y == a + b exactly
+    inline void TwoSum(const Scalar a, const Scalar b, Scalar& x, Scalar& y)
+    {
+        x = a + b;
+        const Scalar bVirtual = x - a;
+        const Scalar aVirtual = x - bVirtual;
+        y = (a - aVirtual) + (b - bVirtual);
+    }
+
+    // x + y == a + b exactly, for |a| >= |b|
+    inline void FastTwoSum(const Scalar a, const Scalar b, Scalar& x, Scalar& y)
+    {
+        x = a + b;
+        y = b - (x - a);
+    }
+
+    // x + y == a * b exactly
+    inline void TwoProduct(const Scalar a, const Scalar b, Scalar& x, Scalar& y)
+    {
+        x = a * b;
+        y = std::fma(a, b, -x);
+    }
+
+    Expansion Difference(const Scalar a, const Scalar b)
+    {
+        Scalar x, y;
+        TwoSum(a, -b, x, y);
+        Expansion res;
+        if (y != 0) res.push_back(y);
+        if (x != 0) res.push_back(x);
+        return res;
+    }
+
+    // e + b
+    void Grow(Expansion& e, const Scalar b)
+    {
+        Scalar q = b;
+        size_t count = 0;
+        for (size_t i = 0; i < e.size(); ++i)
+        {
+            Scalar h;
+            TwoSum(q, e[i], q, h);
+            if (h != 0)
+            {
+                e[count++] = h;
+            }
+        }
+        e.resize(count);
+        if (q != 0)
+        {
+            e.push_back(q);
+        }
+    }
+
+    Expansion Sum(Expansion e, const Expansion& f)
+    {
+        for (const auto& component : f)
+        {
+            Grow(e, component);
+        }
+        return e;
+    }
+
+    Expansion Negate(Expansion e)
+    {
+        for (auto& component : e)
+        {
+            component = -component;
+        }
+        return e;
+    }
+
+    // e * b
+    Expansion Scale(const Expansion& e, const Scalar b)
+    {
+        Expansion res;
+        if (e.empty() || b == 0)
+        {
+            return res;
+        }
+        res.reserve(2 * e.size());
+        Scalar q, h;
+        TwoProduct(e[0], b, q, h);
+        if (h != 0) res.push_back(h);
+        for (size_t i = 1; i < e.size(); ++i)
+        {
+            Scalar product1, product0, sum;
+            TwoProduct(e[i], b, product1, product0);
+            TwoSum(q, product0, sum, h);
+            if (h != 0) res.push_back(h);
+            FastTwoSum(product1, sum, q, h);
+            if (h != 0) res.push_back(h);
+        }
+        if (q != 0) res.push_back(q);
+        return res;
+    }
+
+    Expansion Product(const Expansion& e, const Expansion& f)
+    {
+        Expansion res;
+        for (const auto& component : f)
+        {
+            res = Sum(std::move(res), Scale(e, component));
+        }
+        return res;
+    }
+
+    Scalar Estimate(const Expansion& e)
+    {
+        Scalar res = 0;
+        for (const auto& component : e)
+        {
+            res += component;
+        }
+        // the last component has the sign
+        return (e.empty() || (res > 0) == (e.back() > 0)) ? res : e.back();
+    }
+
+    // a * d - b * c
+    Expansion Determinant2(const Expansion& a, const Expansion& b, const Expansion& c, const Expansion& d)
+    {
+        return Sum(Product(a, d), Negate(Product(b, c)));
+    }
+
+    Scalar Orient2DExact(const Point& a, const Point& b, const Point& c)
+    {
+        return Estimate(Determinant2(Difference(a.x, c.x), Difference(a.y, c.y), Difference(b.x, c.x), Difference(b.y, c.y)));
+    }
+
+    Scalar Orient3DExact(const Vertex& a, const Vertex& b, const Vertex& c, const Vertex& d)
+    {
+        const Expansion adx = Difference(a.x, d.x), ady = Difference(a.y, d.y), adz = Difference(a.z, d.z);
+        const Expansion bdx = Difference(b.x, d.x), bdy = Difference(b.y, d.y), bdz = Difference(b.z, d.z);
+        const Expansion cdx = Difference(c.x, d.x), cdy = Difference(c.y, d.y), cdz = Difference(c.z, d.z);
+        Expansion res = Product(adz, Determinant2(bdx, bdy, cdx, cdy));
+        res = Sum(std::move(res), Product(bdz, Determinant2(cdx, cdy, adx, ady)));
+        res = Sum(std::move(res), Product(cdz, Determinant2(adx, ady, bdx, bdy)));
+        return Estimate(res);
+    }
+
+    Scalar InCircleExact(const Point& a, const Point& b, const Point& c, const Point& d)
+    {
+        const Expansion adx = Difference(a.x, d.x), ady = Difference(a.y, d.y);
+        const Expansion bdx = Difference(b.x, d.x), bdy = Difference(b.y, d.y);
+        const Expansion cdx = Difference(c.x, d.x), cdy = Difference(c.y, d.y);
+        auto lift = [](const Expansion& x, const Expansion& y) { return Sum(Product(x, x), Product(y, y)); };
+        Expansion res = Product(lift(adx, ady), Determinant2(bdx, bdy, cdx, cdy));
+        res = Sum(std::move(res), Product(lift(bdx, bdy), Determinant2(cdx, cdy, adx, ady)));
+        res = Sum(std::move(res), Product(lift(cdx, cdy), Determinant2(adx, ady, bdx, bdy)));
+        return Estimate(res);
+    }
+
+    Scalar InSphereExact(const Vertex& a, const Vertex& b, const Vertex& c, const Vertex& d, const Vertex& e)
+    {
+        const Expansion aex = Difference(a.x, e.x), aey = Difference(a.y, e.y), aez = Difference(a.z, e.z);
+        const Expansion bex = Difference(b.x, e.x), bey = Difference(b.y, e.y), bez = Difference(b.z, e.z);
+        const Expansion cex = Difference(c.x, e.x), cey = Difference(c.y, e.y), cez = Difference(c.z, e.z);
+        const Expansion dex = Difference(d.x, e.x), dey = Difference(d.y, e.y), dez = Difference(d.z, e.z);
+        const Expansion ab = Determinant2(aex, aey, bex, bey);
+        const Expansion bc = Determinant2(bex, bey, cex, cey);
+        const Expansion cd = Determinant2(cex, cey, dex, dey);
+        const Expansion da = Determinant2(dex, dey, aex, aey);
+        const Expansion ac = Determinant2(aex, aey, cex, cey);
+        const Expansion bd = Determinant2(bex, bey, dex, dey);
+        const Expansion abc = Sum(Sum(Product(aez, bc), Negate(Product(bez, ac))), Product(cez, ab));
+        const Expansion bcd = Sum(Sum(Product(bez, cd), Negate(Product(cez, bd))), Product(dez, bc));
+        const Expansion cda = Sum(Sum(Product(cez, da), Product(dez, ac)), Product(aez, cd));
+        const Expansion dab = Sum(Sum(Product(dez, ab), Product(aez, bd)), Product(bez, da));
+        auto lift = [](const Expansion& x, const Expansion& y, const Expansion& z) { return Sum(Sum(Product(x, x), Product(y, y)), Product(z, z)); };
+        Expansion res = Product(lift(dex, dey, dez), abc);
+        res = Sum(std::move(res), Negate(Product(lift(cex, cey, cez), dab)));
+        res = Sum(std::move(res), Product(lift(bex, bey, bez), cda));
+        res = Sum(std::move(res), Negate(Product(lift(aex, aey, aez), bcd)));
+        return Estimate(res);
+    }
+}
+
+Scalar Predicates::Orient2D(const Point& a, const Point& b, const Point& c)
+{
+    const Scalar left = (a.x - c.x) * (b.y - c.y);
+    const Scalar right = (a.y - c.y) * (b.x - c.x);
+    const Scalar det = left - right;
+    if ((left > 0 && right <= 0) || (left < 0 && right >= 0) || left == 0)
+    {
+        // no cancellation
+        return det;
+    }
+    const Scalar bound = orient2dBound * std::abs(left + right);
+    if (det >= bound || -det >= bound)
+    {
+        return det;
+    }
+    return Orient2DExact(a, b, c);
+}
+
+Scalar Predicates::Orient3D(const Vertex& a, const Vertex& b, const Vertex& c, const Vertex& d)
+{
+    const Scalar adx = a.x - d.x, ady = a.y - d.y, adz = a.z - d.z;
+    const Scalar bdx = b.x - d.x, bdy = b.y - d.y, bdz = b.z - d.z;
+    const Scalar cdx = c.x - d.x, cdy = c.y - d.y, cdz = c.z - d.z;
+    const Scalar bdxcdy = bdx * cdy, cdxbdy = cdx * bdy;
+    const Scalar cdxady = cdx * ady, adxcdy = adx * cdy;
+    const Scalar adxbdy = adx * bdy, bdxady = bdx * ady;
+    const Scalar det = adz * (bdxcdy - cdxbdy) + bdz * (cdxady - adxcdy) + cdz * (adxbdy - bdxady);
+    const Scalar permanent =
+        (std::abs(bdxcdy) + std::abs(cdxbdy)) * std::abs(adz) +
+        (std::abs(cdxady) + std::abs(adxcdy)) * std::abs(bdz) +
+        (std::abs(adxbdy) + std::abs(bdxady)) * std::abs(cdz);
+    const Scalar bound = orient3dBound * permanent;
+    if (det > bound || -det > bound)
+    {
+        return det;
+    }
+    return Orient3DExact(a, b, c, d);
+}
+
+Scalar Predicates::InCircle(const Point& a, const Point& b, const Point& c, const Point& d)
+{
+    const Scalar adx = a.x - d.x, ady = a.y - d.y;
+    const Scalar bdx = b.x - d.x, bdy = b.y - d.y;
+    const Scalar cdx = c.x - d.x, cdy = c.y - d.y;
+    const Scalar bdxcdy = bdx * cdy, cdxbdy = cdx * bdy;
+    const Scalar cdxady = cdx * ady, adxcdy = adx * cdy;
+    const Scalar adxbdy = adx * bdy, bdxady = bdx * ady;
+    const Scalar alift = adx * adx + ady * ady;
+    const Scalar blift = bdx * bdx + bdy * bdy;
+    const Scalar clift = cdx * cdx + cdy * cdy;
+    const Scalar det = alift * (bdxcdy - cdxbdy) + blift * (cdxady - adxcdy) + clift * (adxbdy - bdxady);
+    const Scalar permanent =
+        (std::abs(bdxcdy) + std::abs(cdxbdy)) * alift +
+        (std::abs(cdxady) + std::abs(adxcdy)) * blift +
+        (std::abs(adxbdy) + std::abs(bdxady)) * clift;
+    const Scalar bound = inCircleBound * permanent;
+    if (det > bound || -det > bound)
+    {
+        return det;
+    }
+    return InCircleExact(a, b, c, d);
+}
+
+Scalar Predicates::InSphere(const Vertex& a, const Vertex& b, const Vertex& c, const Vertex& d, const Vertex& e)
+{
+    const Scalar aex = a.x - e.x, aey = a.y - e.y, aez = a.z - e.z;
+    const Scalar bex = b.x - e.x, bey = b.y - e.y, bez = b.z - e.z;
+    const Scalar cex = c.x - e.x, cey = c.y - e.y, cez = c.z - e.z;
+    const Scalar dex = d.x - e.x, dey = d.y - e.y, dez = d.z - e.z;
+    const Scalar aexbey = aex * bey, bexaey = bex * aey;
+    const Scalar bexcey = bex * cey, cexbey = cex * bey;
+    const Scalar cexdey = cex * dey, dexcey = dex * cey;
+    const Scalar dexaey = dex * aey, aexdey = aex * dey;
+    const Scalar aexcey = aex * cey, cexaey = cex * aey;
+    const Scalar bexdey = bex * dey, dexbey = dex * bey;
+    const Scalar ab = aexbey - bexaey;
+    const Scalar bc = bexcey - cexbey;
+    const Scalar cd = cexdey - dexcey;
+    const Scalar da = dexaey - aexdey;
+    const Scalar ac = aexcey - cexaey;
+    const Scalar bd = bexdey - dexbey;
+    const Scalar abc = aez * bc - bez * ac + cez * ab;
+    const Scalar bcd = bez * cd - cez * bd + dez * bc;
+    const Scalar cda = cez * da + dez * ac + aez * cd;
+    const Scalar dab = dez * ab + aez * bd + bez * da;
+    const Scalar alift = aex * aex + aey * aey + aez * aez;
+    const Scalar blift = bex * bex + bey * bey + bez * bez;
+    const Scalar clift = cex * cex + cey * cey + cez * cez;
+    const Scalar dlift = dex * dex + dey * dey + dez * dez;
+    const Scalar det = (dlift * abc - clift * dab) + (blift * cda - alift * bcd);
+    const Scalar az = std::abs(aez), bz = std::abs(bez), cz = std::abs(cez), dz = std::abs(dez);
+    const Scalar abPlus = std::abs(aexbey) + std::abs(bexaey);
+    const Scalar bcPlus = std::abs(bexcey) + std::abs(cexbey);
+    const Scalar cdPlus = std::abs(cexdey) + std::abs(dexcey);
+    const Scalar daPlus = std::abs(dexaey) + std::abs(aexdey);
+    const Scalar acPlus = std::abs(aexcey) + std::abs(cexaey);
+    const Scalar bdPlus = std::abs(bexdey) + std::abs(dexbey);
+    const Scalar permanent =
+        (cdPlus * bz + bdPlus * cz + bcPlus * dz) * alift +
+        (daPlus * cz + acPlus * dz + cdPlus * az) * blift +
+        (abPlus * dz + bdPlus * az + daPlus * bz) * clift +
+        (bcPlus * az + acPlus * bz + abPlus * cz) * dlift;
+    const Scalar bound = inSphereBound * permanent;
+    if (det > bound || -det > bound)
+    {
+        return det;
+    }
+    return InSphereExact(a, b, c, d, e);
+}
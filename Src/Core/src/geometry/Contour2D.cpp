@@ -4,6 +4,16 @@
 
 #include "internal/geometry/Contour2D.h"
 
+Scalar Contour2D::area() const
+{
+    Scalar res = 0;
+    for (size_t i = 0, j = points.size() - 1; i < points.size(); j = i++)
+    {
+        res += points[j].x * points[i].y - points[i].x * points[j].y;
+    }
+    return res / 2;
+}
+
 Contour2D Contour2D::Square(const Point& min, const Point& max)
 {
     return Contour2D()
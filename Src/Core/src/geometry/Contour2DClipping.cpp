@@ -0,0 +1,609 @@
+﻿#include <algorithm>
+#include <array>
+#include <cmath>
+#include <functional>
+#include <map>
+#include <queue>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+#include "internal/generic/Constants.h"
+#include "internal/generic/Limits.h"
+#include "internal/generic/Predicates.h"
+#include "internal/geometry/Contour2D.h"
+
+//
+// Boolean operations and offsetting on contours.
+//
+// All edges are cut where they cross or touch, the candidate pairs are found
+// by halving the bounding box until few edges remain. A sweep line orders the resulting segments from bottom to top, which
+// gives the winding numbers of both operands on each side of every segment.
+// The segments with the inside of the result on one side only are chained
+// into the result contours, with the inside on their left.
+//
+// Offsetting moves every edge along its normal and joins the corners, the
+// raw outline overlaps itself at concave corners. Resolving it with the
+// positive fill rule leaves the offset region.
+//
+// Orientation decisions use the exact predicates. Only crossing points are
+// rounded, the crossings are searched again until the rounding introduces
+// no new ones. An end point within a rounding tolerance of a crossing edge
+// is used as the crossing point, so nearly collinear edges settle at once.
+//
+namespace
+{
+    // sweep order, left to right and bottom to top
+    inline bool Before(const Point& a, const Point& b)
+    {
+        return a.x < b.x || (a.x == b.x && a.y < b.y);
+    }
+
+    inline bool Same(const Point& a, const Point& b)
+    {
+        return a.x == b.x && a.y == b.y;
+    }
+
+    struct Segment
+    {
+        // Before(a, b)
+        Point a;
+        Point b;
+        // change in winding number of each operand from the right to the left side
+        int winding[2];
+    };
+
+    class Clipper
+    {
+    public:
+        typedef std::function<bool(const int, const int)> Inside;
+
+        void add(const Contour2D& contour, const size_t operand)
+        {
+            const size_t count = contour.size();
+            for (size_t i = 0, j = count - 1; i < count; j = i++)
+            {
+                add(contour[j], contour[i], operand);
+            }
+        }
+
+        void add(const Point& from, const Point& to, const size_t operand)
+        {
+            if (Same(from, to))
+            {
+                return;
+            }
+            const bool forward = Before(from, to);
+            Segment segment = { forward ? from : to, forward ? to : from, { 0, 0 } };
+            segment.winding[operand] = forward ? 1 : -1;
+            segments.emplace_back(segment);
+        }
+
+        std::vector<Contour2D> resolve(const Inside& inside)
+        {
+            Scalar extent = 0;
+            for (const auto& segment : segments)
+            {
+                extent = std::max({ extent, std::abs(segment.a.x), std::abs(segment.a.y), std::abs(segment.b.x), std::abs(segment.b.y) });
+            }
+            tolerance = extent * 1e-12;
+            for (size_t pass = 1; subdivide(); ++pass)
+            {
+                if (pass == MaxPasses)
+                {
+                    throw std::runtime_error("the crossings of the contours didn't settle");
+                }
+            }
+            mergeDuplicates();
+            computeWindings();
+            return chain(inside);
+        }
+
+    private:
+        // rounds of crossing searches, the rounding settles after one or two
+        static const size_t MaxPasses = 8;
+
+        std::vector<Segment> segments;
+        // distance below which an end point is snapped onto a crossing edge
+        Scalar tolerance = 0;
+        // winding numbers below (right of) each segment
+        std::vector<std::array<int, 2>> below;
+
+        // Cut the segments where they cross or touch each other.
+        // Returns true when a rounded crossing point was introduced.
+        bool subdivide()
+        {
+            std::vector<std::vector<Point>> cuts(segments.size());
+            bool rounded = false;
+            auto inside = [](const Segment& s, const Point& p)
+            {
+                return Before(s.a, p) && Before(p, s.b);
+            };
+            auto test = [&](const size_t i, const size_t j)
+            {
+                const Segment& s = segments[i];
+                const Segment& t = segments[j];
+                const Scalar o1 = Predicates::Orient2D(s.a, s.b, t.a);
+                const Scalar o2 = Predicates::Orient2D(s.a, s.b, t.b);
+                if ((o1 > 0 && o2 > 0) || (o1 < 0 && o2 < 0))
+                {
+                    return;
+                }
+                const Scalar o3 = Predicates::Orient2D(t.a, t.b, s.a);
+                const Scalar o4 = Predicates::Orient2D(t.a, t.b, s.b);
+                if ((o3 > 0 && o4 > 0) || (o3 < 0 && o4 < 0))
+                {
+                    return;
+                }
+                if (o1 != 0 && o2 != 0 && o3 != 0 && o4 != 0)
+                {
+                    // proper crossing
+                    const Scalar dx = t.b.x - t.a.x, dy = t.b.y - t.a.y;
+                    const Scalar ex = s.b.x - s.a.x, ey = s.b.y - s.a.y;
+                    const Scalar f = ((t.a.x - s.a.x) * dy - (t.a.y - s.a.y) * dx) / (ex * dy - ey * dx);
+                    const Point crossing(s.a.x + ex * f, s.a.y + ey * f);
+                    // End points in the range of the other segment, by their
+                    // distance to it (first) or to the rounded crossing.
+                    const Scalar lengthS = std::sqrt(ex * ex + ey * ey);
+                    const Scalar lengthT = std::sqrt(dx * dx + dy * dy);
+                    const Point* points[4] = { &t.a, &t.b, &s.a, &s.b };
+                    const Scalar lines[4] = { std::abs(o1) / lengthS, std::abs(o2) / lengthS, std::abs(o3) / lengthT, std::abs(o4) / lengthT };
+                    std::array<std::pair<Scalar, size_t>, 4> ends;
+                    size_t count = 0;
+                    for (size_t k = 0; k < 4; ++k)
+                    {
+                        if (inside(k < 2 ? s : t, *points[k]))
+                        {
+                            ends[count++] = { lines[k], k };
+                        }
+                    }
+                    std::sort(ends.begin(), ends.begin() + count);
+                    if (count > 0 && ends[0].first <= tolerance)
+                    {
+                        // snap the other segment onto the end point
+                        cuts[ends[0].second < 2 ? i : j].push_back(*points[ends[0].second]);
+                    }
+                    else if (inside(s, crossing) && inside(t, crossing))
+                    {
+                        cuts[i].push_back(crossing);
+                        cuts[j].push_back(crossing);
+                    }
+                    else if (count > 0)
+                    {
+                        // Rounded onto or past an end point. Cut the other
+                        // segment at the end point nearest to the crossing.
+                        for (size_t k = 0; k < count; ++k)
+                        {
+                            const Point& point = *points[ends[k].second];
+                            ends[k].first = std::abs(point.x - crossing.x) + std::abs(point.y - crossing.y);
+                        }
+                        std::sort(ends.begin(), ends.begin() + count);
+                        cuts[ends[0].second < 2 ? i : j].push_back(*points[ends[0].second]);
+                    }
+                    rounded = true;
+                    return;
+                }
+                // touching or collinear, cut at the end points on the other segment
+                if (o1 == 0 && inside(s, t.a)) cuts[i].push_back(t.a);
+                if (o2 == 0 && inside(s, t.b)) cuts[i].push_back(t.b);
+                if (o3 == 0 && inside(t, s.a)) cuts[j].push_back(s.a);
+                if (o4 == 0 && inside(t, s.b)) cuts[j].push_back(s.b);
+            };
+            std::vector<size_t> all(segments.size());
+            Point lo(Limits<Scalar>::MaxValue, Limits<Scalar>::MaxValue), hi(Limits<Scalar>::MinValue, Limits<Scalar>::MinValue);
+            for (size_t i = 0; i < all.size(); ++i)
+            {
+                all[i] = i;
+                lo = Point(std::min(lo.x, segments[i].a.x), std::min(lo.y, std::min(segments[i].a.y, segments[i].b.y)));
+                hi = Point(std::max(hi.x, segments[i].b.x), std::max(hi.y, std::max(segments[i].a.y, segments[i].b.y)));
+            }
+            bool cut = false;
+            if (!all.empty())
+            {
+                overlapping(all, lo, hi, hi, 0, test);
+            }
+            std::vector<Segment> res;
+            res.reserve(segments.size());
+            for (size_t i = 0; i < segments.size(); ++i)
+            {
+                auto& points = cuts[i];
+                if (points.empty())
+                {
+                    res.push_back(segments[i]);
+                    continue;
+                }
+                cut = true;
+                std::sort(points.begin(), points.end(), Before);
+                points.erase(std::unique(points.begin(), points.end(), Same), points.end());
+                Point start = segments[i].a;
+                for (const auto& point : points)
+                {
+                    res.push_back({ start, point, { segments[i].winding[0], segments[i].winding[1] } });
+                    start = point;
+                }
+                res.push_back({ start, segments[i].b, { segments[i].winding[0], segments[i].winding[1] } });
+            }
+            segments.swap(res);
+            return cut && rounded;
+        }
+
+        // Call test(i, j) once for every pair of segments with overlapping
+        // bounds, by halving the box [lo, hi] until few segments remain.
+        // A pair is tested in the cell holding the low corner of their common bounds.
+        template<typename TEST>
+        void overlapping(const std::vector<size_t>& ids, const Point& lo, const Point& hi, const Point& top, const size_t depth, TEST& test) const
+        {
+            auto low = [this](const size_t i) { return Point(segments[i].a.x, std::min(segments[i].a.y, segments[i].b.y)); };
+            auto high = [this](const size_t i) { return Point(segments[i].b.x, std::max(segments[i].a.y, segments[i].b.y)); };
+            const bool horizontal = hi.x - lo.x >= hi.y - lo.y;
+            const Scalar mid = horizontal ? (lo.x + hi.x) / 2 : (lo.y + hi.y) / 2;
+            std::vector<size_t> first, second;
+            if (ids.size() > 16 && depth < 48 && mid > (horizontal ? lo.x : lo.y) && mid < (horizontal ? hi.x : hi.y))
+            {
+                for (const auto& i : ids)
+                {
+                    if ((horizontal ? low(i).x : low(i).y) < mid) first.push_back(i);
+                    if ((horizontal ? high(i).x : high(i).y) >= mid) second.push_back(i);
+                }
+            }
+            // stop when halving only duplicates the segments
+            if (first.size() + second.size() == 0 || 4 * (first.size() + second.size()) > 7 * ids.size())
+            {
+                for (size_t m = 0; m < ids.size(); ++m)
+                {
+                    for (size_t n = m + 1; n < ids.size(); ++n)
+                    {
+                        const size_t i = ids[m], j = ids[n];
+                        const Point a = low(i), b = high(i), c = low(j), d = high(j);
+                        if (a.x > d.x || c.x > b.x || a.y > d.y || c.y > b.y)
+                        {
+                            continue;
+                        }
+                        const Scalar x = std::max(a.x, c.x), y = std::max(a.y, c.y);
+                        if (x < lo.x || y < lo.y || (x >= hi.x && hi.x != top.x) || (y >= hi.y && hi.y != top.y))
+                        {
+                            continue;
+                        }
+                        test(i, j);
+                    }
+                }
+                return;
+            }
+            if (!first.empty())
+            {
+                overlapping(first, lo, horizontal ? Point(mid, hi.y) : Point(hi.x, mid), top, depth + 1, test);
+            }
+            if (!second.empty())
+            {
+                overlapping(second, horizontal ? Point(mid, lo.y) : Point(lo.x, mid), hi, top, depth + 1, test);
+            }
+        }
+
+        // Coinciding segments become one, segments which cancel out are removed
+        void mergeDuplicates()
+        {
+            std::sort(segments.begin(), segments.end(), [](const Segment& s, const Segment& t)
+                {
+                    return Before(s.a, t.a) || (Same(s.a, t.a) && Before(s.b, t.b));
+                });
+            size_t count = 0;
+            for (size_t i = 0; i < segments.size(); ++i)
+            {
+                if (count > 0 && Same(segments[count - 1].a, segments[i].a) && Same(segments[count - 1].b, segments[i].b))
+                {
+                    segments[count - 1].winding[0] += segments[i].winding[0];
+                    segments[count - 1].winding[1] += segments[i].winding[1];
+                }
+                else
+                {
+                    segments[count++] = segments[i];
+                }
+            }
+            segments.resize(count);
+            segments.erase(std::remove_if(segments.begin(), segments.end(), [](const Segment& s)
+                {
+                    return s.winding[0] == 0 && s.winding[1] == 0;
+                }), segments.end());
+        }
+
+        // Status order of the sweep: below means right of the segment, the
+        // sweep line is tilted slightly so vertical segments are ordered too.
+        struct SegmentOrder
+        {
+            const std::vector<Segment>& segments;
+
+            bool operator()(const size_t i, const size_t j) const
+            {
+                if (i == j)
+                {
+                    return false;
+                }
+                const Segment& s = segments[i];
+                const Segment& t = segments[j];
+                Scalar side;
+                if (Same(s.a, t.a))
+                {
+                    side = Predicates::Orient2D(s.a, s.b, t.b);
+                }
+                else if (Before(t.a, s.a))
+                {
+                    side = -Predicates::Orient2D(t.a, t.b, s.a);
+                    if (side == 0) side = -Predicates::Orient2D(t.a, t.b, s.b);
+                }
+                else
+                {
+                    side = Predicates::Orient2D(s.a, s.b, t.a);
+                    if (side == 0) side = Predicates::Orient2D(s.a, s.b, t.b);
+                }
+                return side == 0 ? i < j : side > 0;
+            }
+        };
+
+        void computeWindings()
+        {
+            // segments are sorted on their start, equal starts from bottom to top
+            std::stable_sort(segments.begin(), segments.end(), [](const Segment& s, const Segment& t)
+                {
+                    if (!Same(s.a, t.a))
+                    {
+                        return Before(s.a, t.a);
+                    }
+                    return Predicates::Orient2D(s.a, s.b, t.b) > 0;
+                });
+            below.assign(segments.size(), { 0, 0 });
+            typedef std::set<size_t, SegmentOrder> Status;
+            Status status(SegmentOrder{ segments });
+            std::vector<Status::iterator> position(segments.size());
+            auto later = [this](const size_t i, const size_t j) { return Before(segments[j].b, segments[i].b); };
+            std::priority_queue<size_t, std::vector<size_t>, decltype(later)> ends(later);
+            for (size_t i = 0; i < segments.size(); ++i)
+            {
+                const Point& start = segments[i].a;
+                while (!ends.empty() && !Before(start, segments[ends.top()].b))
+                {
+                    status.erase(position[ends.top()]);
+                    ends.pop();
+                }
+                position[i] = status.insert(i).first;
+                ends.push(i);
+                if (position[i] != status.begin())
+                {
+                    const size_t previous = *std::prev(position[i]);
+                    below[i][0] = below[previous][0] + segments[previous].winding[0];
+                    below[i][1] = below[previous][1] + segments[previous].winding[1];
+                }
+            }
+        }
+
+        std::vector<Contour2D> chain(const Inside& inside) const
+        {
+            // directed edges with the inside on their left
+            struct Edge
+            {
+                Point from;
+                Point to;
+                bool used;
+            };
+            std::vector<Edge> edges;
+            for (size_t i = 0; i < segments.size(); ++i)
+            {
+                const bool right = inside(below[i][0], below[i][1]);
+                const bool left = inside(below[i][0] + segments[i].winding[0], below[i][1] + segments[i].winding[1]);
+                if (left != right)
+                {
+                    edges.push_back(left ? Edge{ segments[i].a, segments[i].b, false } : Edge{ segments[i].b, segments[i].a, false });
+                }
+            }
+            std::sort(edges.begin(), edges.end(), [](const Edge& e, const Edge& f) { return Before(e.from, f.from); });
+            auto direction = [&edges](const size_t edge)
+            {
+                return std::atan2(edges[edge].to.y - edges[edge].from.y, edges[edge].to.x - edges[edge].from.x);
+            };
+            // Arriving by edge, continue with the sharpest left turn so
+            // contours touching in a point separate. Returns edges.size() at a dead end.
+            auto following = [&](const size_t edge, const size_t first)
+            {
+                const Point& at = edges[edge].to;
+                const size_t begin = std::lower_bound(edges.begin(), edges.end(), at, [](const Edge& e, const Point& p) { return Before(e.from, p); }) - edges.begin();
+                const Scalar incoming = direction(edge);
+                size_t best = edges.size();
+                Scalar bestTurn = -10;
+                for (size_t candidate = begin; candidate < edges.size() && Same(edges[candidate].from, at); ++candidate)
+                {
+                    if (edges[candidate].used && candidate != first)
+                    {
+                        continue;
+                    }
+                    Scalar turn = direction(candidate) - incoming;
+                    while (turn <= -Constants::Pi) turn += 2 * Constants::Pi;
+                    while (turn > Constants::Pi) turn -= 2 * Constants::Pi;
+                    if (turn > bestTurn)
+                    {
+                        bestTurn = turn;
+                        best = candidate;
+                    }
+                }
+                return best;
+            };
+            std::vector<Contour2D> res;
+            for (size_t first = 0; first < edges.size(); ++first)
+            {
+                if (edges[first].used)
+                {
+                    continue;
+                }
+                Points points;
+                for (size_t edge = first; edge < edges.size() && !edges[edge].used; edge = following(edge, first))
+                {
+                    edges[edge].used = true;
+                    // drop points on a straight line
+                    while (points.size() >= 2 && Predicates::Orient2D(points[points.size() - 2], points.back(), edges[edge].from) == 0)
+                    {
+                        points.pop_back();
+                    }
+                    points.push_back(edges[edge].from);
+                }
+                while (points.size() >= 3 && Predicates::Orient2D(points[points.size() - 2], points.back(), points.front()) == 0)
+                {
+                    points.pop_back();
+                }
+                while (points.size() >= 3 && Predicates::Orient2D(points.back(), points[0], points[1]) == 0)
+                {
+                    points.erase(points.begin());
+                }
+                if (points.size() >= 3)
+                {
+                    res.emplace_back(std::move(points));
+                }
+            }
+            return res;
+        }
+    };
+
+    // Outline of contour moved by delta along the outward normals, overlapping itself at concave corners
+    void OffsetOutline(Clipper& clipper, const Contour2D& contour, const Scalar& delta, const Contour2D::Join join, const Scalar& miterLimit, const Scalar& arcTolerance)
+    {
+        Points points;
+        for (const auto& point : contour)
+        {
+            if (points.empty() || !Same(points.back(), point))
+            {
+                points.push_back(point);
+            }
+        }
+        while (points.size() > 1 && Same(points.back(), points.front()))
+        {
+            points.pop_back();
+        }
+        if (points.size() < 2)
+        {
+            return;
+        }
+        const size_t count = points.size();
+        const Scalar side = delta > 0 ? 1 : -1;
+        const Scalar distance = std::abs(delta);
+        const Scalar tolerance = arcTolerance > 0 ? std::min(arcTolerance, distance) : distance / 100;
+        const Scalar arcStep = 2 * std::acos(1 - tolerance / distance);
+        auto unit = [](const Point& from, const Point& to)
+        {
+            const Scalar dx = to.x - from.x, dy = to.y - from.y;
+            const Scalar length = std::sqrt(dx * dx + dy * dy);
+            return Point(dx / length, dy / length);
+        };
+        auto at = [](const Point& p, const Point& v, const Scalar& f)
+        {
+            return Point(p.x + v.x * f, p.y + v.y * f);
+        };
+        Points outline;
+        for (size_t i = 0; i < count; ++i)
+        {
+            const Point& p = points[i];
+            const Point d1 = unit(points[(i + count - 1) % count], p);
+            const Point d2 = unit(p, points[(i + 1) % count]);
+            // outward for counterclockwise contours: to the right
+            const Point n1(d1.y, -d1.x), n2(d2.y, -d2.x);
+            const Scalar cross = d1.x * d2.y - d1.y * d2.x;
+            const Scalar dot = d1.x * d2.x + d1.y * d2.y;
+            if (cross * delta < 0 || (cross == 0 && dot > 0))
+            {
+                // concave or straight, the loop through p is removed later
+                outline.push_back(at(p, n1, delta));
+                if (cross != 0)
+                {
+                    outline.push_back(p);
+                    outline.push_back(at(p, n2, delta));
+                }
+                continue;
+            }
+            const bool reversal = (cross == 0);
+            Contour2D::Join type = join;
+            if (type == Contour2D::Join::Miter && (reversal || std::sqrt(2 / (1 + dot)) > miterLimit))
+            {
+                type = Contour2D::Join::Square;
+            }
+            switch (type)
+            {
+            case Contour2D::Join::Miter:
+                outline.push_back(at(p, Point(n1.x + n2.x, n1.y + n2.y), delta / (1 + dot)));
+                break;
+            case Contour2D::Join::Square:
+            {
+                Point b = reversal ? Point(d1.x * side, d1.y * side) : unit(Point(0, 0), Point(n1.x + n2.x, n1.y + n2.y));
+                const Scalar t1 = distance * (1 - (n1.x * b.x + n1.y * b.y)) / (side * (d1.x * b.x + d1.y * b.y));
+                const Scalar t2 = distance * (1 - (n2.x * b.x + n2.y * b.y)) / (side * (d2.x * b.x + d2.y * b.y));
+                outline.push_back(at(at(p, n1, delta), d1, t1));
+                outline.push_back(at(at(p, n2, delta), d2, t2));
+                break;
+            }
+            case Contour2D::Join::Round:
+            {
+                const Scalar angle = reversal ? Constants::Pi * side : std::atan2(cross, dot);
+                const size_t steps = std::max<size_t>(1, (size_t)std::ceil(std::abs(angle) / arcStep));
+                for (size_t k = 0; k <= steps; ++k)
+                {
+                    const Scalar a = angle * k / steps;
+                    const Scalar c = std::cos(a), s = std::sin(a);
+                    outline.push_back(at(p, Point(n1.x * c - n1.y * s, n1.x * s + n1.y * c), delta));
+                }
+                break;
+            }
+            }
+        }
+        for (size_t i = 0, j = outline.size() - 1; i < outline.size(); j = i++)
+        {
+            clipper.add(outline[j], outline[i], 0);
+        }
+    }
+
+    std::vector<Contour2D> Boolean(const std::vector<Contour2D>& a, const std::vector<Contour2D>& b, const Clipper::Inside& inside)
+    {
+        Clipper clipper;
+        for (const auto& contour : a)
+        {
+            clipper.add(contour, 0);
+        }
+        for (const auto& contour : b)
+        {
+            clipper.add(contour, 1);
+        }
+        return clipper.resolve(inside);
+    }
+}
+
+std::vector<Contour2D> Contour2D::offset(const Scalar& delta, const Join join, const Scalar& miterLimit, const Scalar& arcTolerance) const
+{
+    if (area() >= 0)
+    {
+        return Offset({ *this }, delta, join, miterLimit, arcTolerance);
+    }
+    return Offset({ Contour2D(Points(points.rbegin(), points.rend())) }, delta, join, miterLimit, arcTolerance);
+}
+
+std::vector<Contour2D> Contour2D::Union(const std::vector<Contour2D>& a, const std::vector<Contour2D>& b)
+{
+    return Boolean(a, b, [](const int wa, const int wb) { return wa != 0 || wb != 0; });
+}
+
+std::vector<Contour2D> Contour2D::Intersection(const std::vector<Contour2D>& a, const std::vector<Contour2D>& b)
+{
+    return Boolean(a, b, [](const int wa, const int wb) { return wa != 0 && wb != 0; });
+}
+
+std::vector<Contour2D> Contour2D::Difference(const std::vector<Contour2D>& a, const std::vector<Contour2D>& b)
+{
+    return Boolean(a, b, [](const int wa, const int wb) { return wa != 0 && wb == 0; });
+}
+
+std::vector<Contour2D> Contour2D::Offset(const std::vector<Contour2D>& contours, const Scalar& delta, const Join join, const Scalar& miterLimit, const Scalar& arcTolerance)
+{
+    if (delta == 0)
+    {
+        return Union(contours);
+    }
+    Clipper clipper;
+    for (const auto& contour : contours)
+    {
+        OffsetOutline(clipper, contour, delta, join, miterLimit, arcTolerance);
+    }
+    return clipper.resolve([](const int winding, const int) { return winding > 0; });
+}
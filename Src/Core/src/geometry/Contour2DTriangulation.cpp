@@ -0,0 +1,490 @@
+﻿#include <algorithm>
+#include <cmath>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+#include "internal/generic/Constants.h"
+#include "internal/generic/Predicates.h"
+#include "internal/geometry/Contour2D.h"
+
+//
+// Triangulation by monotone decomposition, see "Computational Geometry:
+// Algorithms and Applications" (de Berg et al.) chapter 3.
+//
+// A line sweeps from top to bottom and adds diagonals at the split and merge
+// vertices, which cuts the polygon in y-monotone pieces. Every piece is
+// triangulated in linear time by walking its two chains with a stack.
+//
+// The outer boundary runs counterclockwise and the holes clockwise, so the
+// interior is always on the left of an edge. Edge i runs from vertex i to
+// next[i].
+// Repeated points and the tips of spikes without area (a point where the
+// contour turns straight back) are left out, the sweep can't order their
+// edges. The triangles still use the indices of the input points.
+//
+namespace
+{
+    enum class VertexType
+    {
+        Start,
+        Split,
+        End,
+        Merge,
+        Regular
+    };
+
+    class Triangulation
+    {
+    public:
+        Triangulation(const Contour2D& outer, const std::vector<Contour2D>& holes)
+        {
+            addRing(outer, true);
+            for (const auto& hole : holes)
+            {
+                addRing(hole, false);
+            }
+        }
+
+        Contour2D::Triangles build()
+        {
+            if (points.size() >= 3)
+            {
+                decompose();
+                for (auto& piece : pieces())
+                {
+                    triangulateMonotone(piece);
+                }
+            }
+            for (auto& triangle : triangles)
+            {
+                for (auto& corner : triangle)
+                {
+                    corner = source[corner];
+                }
+            }
+            return std::move(triangles);
+        }
+
+    private:
+        Points points;
+        // index of each point in the input
+        std::vector<size_t> source;
+        size_t inputSize = 0;
+        std::vector<size_t> next;
+        std::vector<size_t> prev;
+        std::vector<std::pair<size_t, size_t>> diagonals;
+        Contour2D::Triangles triangles;
+
+        // the sweep visits a before b
+        bool above(const size_t a, const size_t b) const
+        {
+            return points[a].y > points[b].y || (points[a].y == points[b].y && points[a].x < points[b].x);
+        }
+
+        static bool Same(const Point& a, const Point& b)
+        {
+            return a.x == b.x && a.y == b.y;
+        }
+
+        // b is the tip of a spike without area between a and c
+        static bool Spike(const Point& a, const Point& b, const Point& c)
+        {
+            return Predicates::Orient2D(a, b, c) == 0 && (b.x - a.x) * (c.x - b.x) + (b.y - a.y) * (c.y - b.y) <= 0;
+        }
+
+        // The ring without repeated points and spike tips
+        static std::vector<size_t> Clean(const Contour2D& ring)
+        {
+            std::vector<size_t> kept;
+            for (size_t i = 0; i < ring.size(); ++i)
+            {
+                if (!kept.empty() && Same(ring[kept.back()], ring[i]))
+                {
+                    continue;
+                }
+                kept.push_back(i);
+                while (kept.size() >= 3 && Spike(ring[kept[kept.size() - 3]], ring[kept[kept.size() - 2]], ring[kept.back()]))
+                {
+                    kept.erase(kept.end() - 2);
+                    if (Same(ring[kept[kept.size() - 2]], ring[kept.back()]))
+                    {
+                        kept.pop_back();
+                    }
+                }
+            }
+            // the same around the first point
+            bool changed = true;
+            while (changed && kept.size() >= 3)
+            {
+                changed = false;
+                if (Same(ring[kept.back()], ring[kept.front()]) || Spike(ring[kept[kept.size() - 2]], ring[kept.back()], ring[kept.front()]))
+                {
+                    kept.pop_back();
+                    changed = true;
+                }
+                else if (Spike(ring[kept.back()], ring[kept.front()], ring[kept[1]]))
+                {
+                    kept.erase(kept.begin());
+                    changed = true;
+                }
+            }
+            return kept;
+        }
+
+        void addRing(const Contour2D& ring, const bool counterclockwise)
+        {
+            const size_t offset = inputSize;
+            inputSize += ring.size();
+            const size_t first = points.size();
+            const std::vector<size_t> kept = Clean(ring);
+            const size_t count = kept.size();
+            if (count < 3)
+            {
+                // nothing to fill, the points are kept as isolated vertices
+                for (size_t i = 0; i < count; ++i)
+                {
+                    points.push_back(ring[kept[i]]);
+                    source.push_back(offset + kept[i]);
+                    next.push_back(first + i);
+                    prev.push_back(first + i);
+                }
+                return;
+            }
+            const bool reverse = (ring.area() > 0) != counterclockwise;
+            for (size_t i = 0; i < count; ++i)
+            {
+                points.push_back(ring[kept[i]]);
+                source.push_back(offset + kept[i]);
+                const size_t forward = first + (i + 1) % count;
+                const size_t backward = first + (i + count - 1) % count;
+                next.push_back(reverse ? backward : forward);
+                prev.push_back(reverse ? forward : backward);
+            }
+        }
+
+        VertexType type(const size_t v) const
+        {
+            const bool prevBelow = above(v, prev[v]);
+            const bool nextBelow = above(v, next[v]);
+            const bool convex = Predicates::Orient2D(points[prev[v]], points[v], points[next[v]]) > 0;
+            if (prevBelow && nextBelow)
+            {
+                return convex ? VertexType::Start : VertexType::Split;
+            }
+            if (!prevBelow && !nextBelow)
+            {
+                return convex ? VertexType::End : VertexType::Merge;
+            }
+            return VertexType::Regular;
+        }
+
+        // Sweep status: the edges with the interior on their right, ordered
+        // left to right. Edges are compared where the later of their top
+        // vertices meets the other edge, points by the side of the edge they are on.
+        struct EdgeOrder
+        {
+            typedef void is_transparent;
+            const Triangulation& owner;
+
+            bool edgeLeftOf(const size_t edge, const Point& p) const
+            {
+                return Predicates::Orient2D(owner.points[edge], owner.points[owner.next[edge]], p) > 0;
+            }
+            bool edgeRightOf(const size_t edge, const Point& p) const
+            {
+                return Predicates::Orient2D(owner.points[edge], owner.points[owner.next[edge]], p) < 0;
+            }
+            bool operator()(const size_t a, const size_t b) const
+            {
+                if (a == b)
+                {
+                    return false;
+                }
+                return owner.above(b, a) ? edgeRightOf(b, owner.points[a]) : edgeLeftOf(a, owner.points[b]);
+            }
+            bool operator()(const size_t edge, const Point& p) const
+            {
+                return edgeLeftOf(edge, p);
+            }
+            bool operator()(const Point& p, const size_t edge) const
+            {
+                return edgeRightOf(edge, p);
+            }
+        };
+
+        void decompose()
+        {
+            std::vector<size_t> order(points.size());
+            for (size_t i = 0; i < order.size(); ++i)
+            {
+                order[i] = i;
+            }
+            std::sort(order.begin(), order.end(), [this](const size_t a, const size_t b) { return above(a, b); });
+            std::vector<VertexType> types(points.size());
+            for (size_t i = 0; i < points.size(); ++i)
+            {
+                types[i] = type(i);
+            }
+            typedef std::set<size_t, EdgeOrder> Status;
+            Status status(EdgeOrder{ *this });
+            std::vector<Status::iterator> position(points.size(), status.end());
+            std::vector<size_t> helper(points.size());
+            auto insert = [&](const size_t edge, const size_t v)
+            {
+                const auto inserted = status.insert(edge);
+                if (!inserted.second)
+                {
+                    // only edges which cross or overlap compare equal
+                    throw std::invalid_argument("the contours cross or touch each other");
+                }
+                position[edge] = inserted.first;
+                helper[edge] = v;
+            };
+            auto remove = [&](const size_t edge, const size_t v)
+            {
+                if (types[helper[edge]] == VertexType::Merge)
+                {
+                    diagonals.emplace_back(v, helper[edge]);
+                }
+                if (position[edge] != status.end())
+                {
+                    status.erase(position[edge]);
+                    position[edge] = status.end();
+                }
+            };
+            auto leftOf = [&](const size_t v, const size_t newHelper)
+            {
+                auto it = status.lower_bound(points[v]);
+                if (it == status.begin())
+                {
+                    return;
+                }
+                const size_t edge = *--it;
+                if (types[helper[edge]] == VertexType::Merge)
+                {
+                    diagonals.emplace_back(v, helper[edge]);
+                }
+                helper[edge] = newHelper;
+            };
+            for (const auto& v : order)
+            {
+                switch (types[v])
+                {
+                case VertexType::Start:
+                    insert(v, v);
+                    break;
+                case VertexType::Split:
+                {
+                    auto it = status.lower_bound(points[v]);
+                    if (it != status.begin())
+                    {
+                        const size_t edge = *--it;
+                        diagonals.emplace_back(v, helper[edge]);
+                        helper[edge] = v;
+                    }
+                    insert(v, v);
+                    break;
+                }
+                case VertexType::End:
+                    remove(prev[v], v);
+                    break;
+                case VertexType::Merge:
+                    remove(prev[v], v);
+                    leftOf(v, v);
+                    break;
+                case VertexType::Regular:
+                    if (above(prev[v], v))
+                    {
+                        // on a left chain, the interior is to the right
+                        remove(prev[v], v);
+                        insert(v, v);
+                    }
+                    else
+                    {
+                        leftOf(v, v);
+                    }
+                    break;
+                }
+            }
+        }
+
+        // The faces of the polygon cut along the diagonals, as counterclockwise vertex lists
+        std::vector<std::vector<size_t>> pieces() const
+        {
+            // outgoing half edges of every vertex
+            std::vector<std::vector<size_t>> outgoing(points.size());
+            for (size_t i = 0; i < points.size(); ++i)
+            {
+                if (next[i] != i)
+                {
+                    outgoing[i].push_back(next[i]);
+                }
+            }
+            for (const auto& diagonal : diagonals)
+            {
+                outgoing[diagonal.first].push_back(diagonal.second);
+                outgoing[diagonal.second].push_back(diagonal.first);
+            }
+            std::vector<std::vector<bool>> used(points.size());
+            for (size_t i = 0; i < points.size(); ++i)
+            {
+                used[i].resize(outgoing[i].size(), false);
+            }
+            auto angle = [this](const size_t from, const size_t to)
+            {
+                return std::atan2(points[to].y - points[from].y, points[to].x - points[from].x);
+            };
+            // from from->to, continue with the first outgoing edge clockwise of to->from
+            auto following = [&](const size_t from, const size_t to)
+            {
+                const auto& candidates = outgoing[to];
+                if (candidates.size() == 1)
+                {
+                    return (size_t)0;
+                }
+                const Scalar back = angle(to, from);
+                size_t best = 0;
+                Scalar bestTurn = 10;
+                for (size_t k = 0; k < candidates.size(); ++k)
+                {
+                    Scalar turn = back - angle(to, candidates[k]);
+                    while (turn <= 0) turn += 2 * Constants::Pi;
+                    while (turn > 2 * Constants::Pi) turn -= 2 * Constants::Pi;
+                    if (turn < bestTurn)
+                    {
+                        bestTurn = turn;
+                        best = k;
+                    }
+                }
+                return best;
+            };
+            std::vector<std::vector<size_t>> res;
+            for (size_t start = 0; start < points.size(); ++start)
+            {
+                for (size_t k = 0; k < outgoing[start].size(); ++k)
+                {
+                    if (used[start][k])
+                    {
+                        continue;
+                    }
+                    std::vector<size_t> piece;
+                    size_t from = start, edge = k;
+                    while (!used[from][edge])
+                    {
+                        used[from][edge] = true;
+                        piece.push_back(from);
+                        const size_t to = outgoing[from][edge];
+                        edge = following(from, to);
+                        from = to;
+                    }
+                    res.emplace_back(std::move(piece));
+                }
+            }
+            return res;
+        }
+
+        void addTriangle(const size_t a, const size_t b, const size_t c)
+        {
+            if (Predicates::Orient2D(points[a], points[b], points[c]) < 0)
+            {
+                triangles.push_back({ a, c, b });
+            }
+            else
+            {
+                triangles.push_back({ a, b, c });
+            }
+        }
+
+        void triangulateMonotone(const std::vector<size_t>& piece)
+        {
+            const size_t n = piece.size();
+            if (n < 3)
+            {
+                return;
+            }
+            if (n == 3)
+            {
+                addTriangle(piece[0], piece[1], piece[2]);
+                return;
+            }
+            size_t top = 0, bottom = 0;
+            for (size_t i = 1; i < n; ++i)
+            {
+                if (above(piece[i], piece[top])) top = i;
+                if (above(piece[bottom], piece[i])) bottom = i;
+            }
+            // merge the left chain (top to bottom, counterclockwise) and the right chain
+            struct Entry
+            {
+                size_t vertex;
+                bool left;
+            };
+            std::vector<Entry> sorted;
+            sorted.reserve(n);
+            size_t l = top, r = (top + n - 1) % n;
+            sorted.push_back({ piece[top], true });
+            l = (l + 1) % n;
+            while (sorted.size() < n)
+            {
+                const bool leftDone = (l == (bottom + 1) % n);
+                const bool rightDone = (r == bottom);
+                if (!leftDone && (rightDone || above(piece[l], piece[r])))
+                {
+                    sorted.push_back({ piece[l], true });
+                    l = (l + 1) % n;
+                }
+                else
+                {
+                    sorted.push_back({ piece[r], false });
+                    r = (r + n - 1) % n;
+                }
+            }
+            std::vector<Entry> stack = { sorted[0], sorted[1] };
+            for (size_t j = 2; j + 1 < n; ++j)
+            {
+                const Entry& u = sorted[j];
+                if (u.left != stack.back().left)
+                {
+                    for (size_t k = 0; k + 1 < stack.size(); ++k)
+                    {
+                        addTriangle(u.vertex, stack[k].vertex, stack[k + 1].vertex);
+                    }
+                    stack = { sorted[j - 1], u };
+                }
+                else
+                {
+                    Entry last = stack.back();
+                    stack.pop_back();
+                    while (!stack.empty())
+                    {
+                        const Scalar side = Predicates::Orient2D(points[stack.back().vertex], points[u.vertex], points[last.vertex]);
+                        if (u.left ? side >= 0 : side <= 0)
+                        {
+                            break;
+                        }
+                        addTriangle(stack.back().vertex, last.vertex, u.vertex);
+                        last = stack.back();
+                        stack.pop_back();
+                    }
+                    stack.push_back(last);
+                    stack.push_back(u);
+                }
+            }
+            for (size_t k = 0; k + 1 < stack.size(); ++k)
+            {
+                addTriangle(sorted[n - 1].vertex, stack[k].vertex, stack[k + 1].vertex);
+            }
+        }
+    };
+}
+
+Contour2D::Triangles Contour2D::triangulate() const
+{
+    return Triangulate(*this);
+}
+
+Contour2D::Triangles Contour2D::Triangulate(const Contour2D& outer, const std::vector<Contour2D>& holes)
+{
+    return Triangulation(outer, holes).build();
+}
@@ -0,0 +1,407 @@
+﻿#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "internal/generic/Predicates.h"
+#include "internal/geometry/ShapeFactory.h"
+
+//
+// Quickhull, see "The Quickhull Algorithm for Convex Hulls" (Barber, Dobkin,
+// Huhdanpaa 1996).
+//
+// Starting from a tetrahedron, every face keeps a conflict list: the points
+// above it which are not assigned to another face. The furthest point of a
+// face is added by removing all faces it sees and connecting the horizon of
+// that region to the point. The points of the removed faces are handed out to
+// the new faces, points which are above none of them are inside the hull.
+//
+// Faces live in a pool and removed faces are reused, conflict lists are
+// linked through one array over the points, so no memory is allocated per
+// face or per point while the hull grows.
+//
+// Whether a point is above a face is decided by an exact orientation
+// predicate, so the visible region and its horizon are always consistent.
+// Plane distances are only used to pick the furthest point.
+//
+namespace
+{
+    constexpr uint32_t none = std::numeric_limits<uint32_t>::max();
+
+    struct HullFace
+    {
+        // counterclockwise seen from outside
+        std::array<uint32_t, 3> vertex;
+        // neighbour[i] is across the edge vertex[i] -> vertex[i+1]
+        std::array<uint32_t, 3> neighbour;
+        Normal normal;
+        Scalar offset;
+        // first point of the conflict list, the furthest point
+        uint32_t conflicts;
+        uint32_t furthest;
+        Scalar furthestDistance;
+        // visibility stamp of the iteration which saw this face
+        uint32_t visible;
+        bool alive;
+    };
+
+    // Depth first search state of findHorizon: the edges first, ..., first +
+    // limit - 1 of face are visited, count of them are done
+    struct HorizonFrame
+    {
+        uint32_t face;
+        uint32_t first;
+        uint32_t count;
+        uint32_t limit;
+    };
+
+    class Quickhull
+    {
+    public:
+        Quickhull(const Vertices& points)
+            : points(points)
+            , nextConflict(points.size(), none)
+        {
+            // Tolerance for the collinear test of the initial simplex, scaled
+            // to the coordinates as suggested by Barber et al.
+            Vertex maxAbs;
+            for (const auto& point : points)
+            {
+                for (size_t i = 0; i < 3; ++i)
+                {
+                    maxAbs[i] = std::max(maxAbs[i], std::abs(point[i]));
+                }
+            }
+            epsilon = 3 * std::numeric_limits<Scalar>::epsilon() * (maxAbs.x + maxAbs.y + maxAbs.z);
+        }
+
+        Shape build()
+        {
+            createSimplex();
+            while (!pending.empty())
+            {
+                const uint32_t face = pending.back();
+                pending.pop_back();
+                if (faces[face].alive && faces[face].conflicts != none)
+                {
+                    addPoint(faces[face].furthest, face);
+                }
+            }
+            return createShape();
+        }
+
+    private:
+        const Vertices& points;
+        Scalar epsilon;
+        std::vector<HullFace> faces;
+        std::vector<uint32_t> freeFaces;
+        std::vector<uint32_t> nextConflict;
+        std::vector<uint32_t> pending;
+        uint32_t stamp = 0;
+        // scratch space, reused between iterations
+        std::vector<std::pair<uint32_t, uint32_t>> horizon;
+        std::vector<uint32_t> visibleFaces;
+        std::vector<uint32_t> newFaces;
+        std::vector<HorizonFrame> stack;
+
+        Scalar distance(const HullFace& face, const uint32_t point) const
+        {
+            return face.normal.innerProduct(points[point]) - face.offset;
+        }
+
+        bool above(const HullFace& face, const uint32_t point) const
+        {
+            return Predicates::Orient3D(points[face.vertex[0]], points[face.vertex[1]], points[face.vertex[2]], points[point]) < 0;
+        }
+
+        uint32_t createFace(const uint32_t a, const uint32_t b, const uint32_t c)
+        {
+            uint32_t index;
+            if (freeFaces.empty())
+            {
+                index = (uint32_t)faces.size();
+                faces.emplace_back();
+            }
+            else
+            {
+                index = freeFaces.back();
+                freeFaces.pop_back();
+            }
+            HullFace& face = faces[index];
+            face.vertex = { a, b, c };
+            face.neighbour = { none, none, none };
+            face.normal = Normal((points[b] - points[a]).crossProduct(points[c] - points[a]));
+            face.offset = face.normal.innerProduct(points[a]);
+            face.conflicts = none;
+            face.furthest = none;
+            face.furthestDistance = 0;
+            face.visible = 0;
+            face.alive = true;
+            return index;
+        }
+
+        void addConflict(const uint32_t face, const uint32_t point, const Scalar& d)
+        {
+            HullFace& f = faces[face];
+            if (f.conflicts == none)
+            {
+                pending.push_back(face);
+            }
+            nextConflict[point] = f.conflicts;
+            f.conflicts = point;
+            if (f.furthest == none || d > f.furthestDistance)
+            {
+                f.furthestDistance = d;
+                f.furthest = point;
+            }
+        }
+
+        // Give a point to the first candidate face it is above
+        void assign(const uint32_t point, const std::vector<uint32_t>& candidates)
+        {
+            for (const auto& face : candidates)
+            {
+                if (above(faces[face], point))
+                {
+                    addConflict(face, point, distance(faces[face], point));
+                    return;
+                }
+            }
+        }
+
+        void link(const uint32_t a, const uint32_t edgeA, const uint32_t b, const uint32_t edgeB)
+        {
+            faces[a].neighbour[edgeA] = b;
+            faces[b].neighbour[edgeB] = a;
+        }
+
+        void createSimplex()
+        {
+            if (points.size() < 4)
+            {
+                throw std::invalid_argument("a convex hull needs at least 4 points");
+            }
+            // the two most distant extreme points along the axes
+            std::array<uint32_t, 6> extremes = {};
+            for (uint32_t i = 0; i < points.size(); ++i)
+            {
+                for (size_t axis = 0; axis < 3; ++axis)
+                {
+                    if (points[i][axis] < points[extremes[2 * axis]][axis]) extremes[2 * axis] = i;
+                    if (points[i][axis] > points[extremes[2 * axis + 1]][axis]) extremes[2 * axis + 1] = i;
+                }
+            }
+            uint32_t v0 = 0, v1 = 0;
+            Scalar best = -1;
+            for (const auto& a : extremes)
+            {
+                for (const auto& b : extremes)
+                {
+                    const Scalar d = points[a].dist2(points[b]);
+                    if (d > best)
+                    {
+                        best = d;
+                        v0 = a;
+                        v1 = b;
+                    }
+                }
+            }
+            // the point furthest from the line, then the one furthest from the plane
+            const Vertex line = points[v1] - points[v0];
+            uint32_t v2 = v0;
+            best = 0;
+            for (uint32_t i = 0; i < points.size(); ++i)
+            {
+                const Scalar d = line.crossProduct(points[i] - points[v0]).length();
+                if (d > best)
+                {
+                    best = d;
+                    v2 = i;
+                }
+            }
+            if (best <= epsilon * line.length())
+            {
+                throw std::invalid_argument("the points of a convex hull can't be collinear");
+            }
+            const Normal normal(line.crossProduct(points[v2] - points[v0]));
+            uint32_t v3 = v0;
+            best = 0;
+            for (uint32_t i = 0; i < points.size(); ++i)
+            {
+                const Scalar d = std::abs(normal.innerProduct(points[i] - points[v0]));
+                if (d > best)
+                {
+                    best = d;
+                    v3 = i;
+                }
+            }
+            const Scalar orientation = Predicates::Orient3D(points[v0], points[v1], points[v2], points[v3]);
+            if (orientation == 0)
+            {
+                throw std::invalid_argument("the points of a convex hull can't be coplanar");
+            }
+            // orient the base away from the fourth point
+            if (orientation < 0)
+            {
+                std::swap(v1, v2);
+            }
+            const uint32_t f0 = createFace(v0, v1, v2);
+            const uint32_t f1 = createFace(v0, v3, v1);
+            const uint32_t f2 = createFace(v1, v3, v2);
+            const uint32_t f3 = createFace(v2, v3, v0);
+            link(f0, 0, f1, 2);
+            link(f0, 1, f2, 2);
+            link(f0, 2, f3, 2);
+            link(f1, 1, f2, 0);
+            link(f2, 1, f3, 0);
+            link(f3, 1, f1, 0);
+            // every point goes to the face it is furthest above
+            for (uint32_t i = 0; i < points.size(); ++i)
+            {
+                if (i == v0 || i == v1 || i == v2 || i == v3)
+                {
+                    continue;
+                }
+                uint32_t face = none;
+                Scalar furthest = 0;
+                for (const auto& f : { f0, f1, f2, f3 })
+                {
+                    if (!above(faces[f], i))
+                    {
+                        continue;
+                    }
+                    const Scalar d = distance(faces[f], i);
+                    if (face == none || d > furthest)
+                    {
+                        furthest = d;
+                        face = f;
+                    }
+                }
+                if (face != none)
+                {
+                    addConflict(face, i, furthest);
+                }
+            }
+        }
+
+        // Collect the faces seen from point, depth first from face, and the
+        // horizon edges (face, edge) around them in counterclockwise order.
+        void findHorizon(const uint32_t point, const uint32_t face)
+        {
+            ++stamp;
+            horizon.clear();
+            visibleFaces.clear();
+            stack.clear();
+            faces[face].visible = stamp;
+            visibleFaces.push_back(face);
+            stack.push_back({ face, 0, 0, 3 });
+            while (!stack.empty())
+            {
+                HorizonFrame& frame = stack.back();
+                if (frame.count == frame.limit)
+                {
+                    stack.pop_back();
+                    continue;
+                }
+                const uint32_t edge = (frame.first + frame.count++) % 3;
+                const uint32_t current = frame.face;
+                const uint32_t neighbour = faces[current].neighbour[edge];
+                if (faces[neighbour].visible == stamp)
+                {
+                    continue;
+                }
+                if (above(faces[neighbour], point))
+                {
+                    faces[neighbour].visible = stamp;
+                    visibleFaces.push_back(neighbour);
+                    // continue after the edge we came through
+                    const auto& back = faces[neighbour].neighbour;
+                    const uint32_t entry = (uint32_t)(std::find(back.begin(), back.end(), current) - back.begin());
+                    stack.push_back({ neighbour, (entry + 1) % 3, 0, 2 });
+                }
+                else
+                {
+                    horizon.emplace_back(current, edge);
+                }
+            }
+        }
+
+        void addPoint(const uint32_t point, const uint32_t face)
+        {
+            findHorizon(point, face);
+            // a cone of new faces from the horizon to the point
+            newFaces.clear();
+            for (const auto& edge : horizon)
+            {
+                const HullFace& old = faces[edge.first];
+                const uint32_t a = old.vertex[edge.second];
+                const uint32_t b = old.vertex[(edge.second + 1) % 3];
+                const uint32_t outside = old.neighbour[edge.second];
+                const uint32_t created = createFace(a, b, point);
+                auto& back = faces[outside].neighbour;
+                const uint32_t entry = (uint32_t)(std::find(back.begin(), back.end(), edge.first) - back.begin());
+                link(created, 0, outside, entry);
+                newFaces.push_back(created);
+            }
+            for (size_t i = 0; i < newFaces.size(); ++i)
+            {
+                link(newFaces[i], 1, newFaces[(i + 1) % newFaces.size()], 2);
+            }
+            // hand out the points of the removed faces
+            for (const auto& removed : visibleFaces)
+            {
+                HullFace& old = faces[removed];
+                old.alive = false;
+                for (uint32_t conflict = old.conflicts; conflict != none;)
+                {
+                    const uint32_t next = nextConflict[conflict];
+                    if (conflict != point)
+                    {
+                        assign(conflict, newFaces);
+                    }
+                    conflict = next;
+                }
+                old.conflicts = none;
+                freeFaces.push_back(removed);
+            }
+        }
+
+        Shape createShape() const
+        {
+            std::vector<uint32_t> mapping(points.size(), none);
+            Vertices vertices;
+            Faces res;
+            for (const auto& face : faces)
+            {
+                if (!face.alive)
+                {
+                    continue;
+                }
+                Index indices[3];
+                for (size_t i = 0; i < 3; ++i)
+                {
+                    auto& mapped = mapping[face.vertex[i]];
+                    if (mapped == none)
+                    {
+                        if (vertices.size() >= std::numeric_limits<Index>::max())
+                        {
+                            throw std::length_error("the convex hull has too many vertices");
+                        }
+                        mapped = (uint32_t)vertices.size();
+                        vertices.emplace_back(points[face.vertex[i]]);
+                    }
+                    indices[i] = (Index)mapped;
+                }
+                res.emplace_back(indices, 3);
+            }
+            return Shape(std::move(vertices), std::move(res));
+        }
+    };
+}
+
+Shape ShapeFactory::ConvexHull(const Vertices& points)
+{
+    return Quickhull(points).build();
+}
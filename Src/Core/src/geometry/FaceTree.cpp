@@ -0,0 +1,549 @@
+﻿#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include "internal/generic/Limits.h"
+#include "internal/geometry/FaceTree.h"
+
+namespace
+{
+    constexpr size_t binCount = 16;
+    constexpr size_t minLeafSize = 2;
+    constexpr size_t maxLeafSize = 16;
+    // The traversal stack holds at most maxDepth + 1 nodes
+    constexpr size_t maxDepth = 64;
+    constexpr size_t stackSize = maxDepth + 2;
+
+    struct Bounds
+    {
+        Bounds()
+            : min(Limits<Scalar>::MaxValue, Limits<Scalar>::MaxValue, Limits<Scalar>::MaxValue)
+            , max(Limits<Scalar>::MinValue, Limits<Scalar>::MinValue, Limits<Scalar>::MinValue)
+        {}
+        void grow(const Vertex& v)
+        {
+            for (size_t i = 0; i < 3; ++i)
+            {
+                min[i] = std::min(min[i], v[i]);
+                max[i] = std::max(max[i], v[i]);
+            }
+        }
+        void grow(const Bounds& other)
+        {
+            grow(other.min);
+            grow(other.max);
+        }
+        // half the surface area, enough for comparing costs
+        Scalar area() const
+        {
+            if (max.x < min.x)
+            {
+                return 0;
+            }
+            const Vertex d = max - min;
+            return d.x * d.y + d.y * d.z + d.z * d.x;
+        }
+        Vertex min;
+        Vertex max;
+    };
+
+    // Moller-Trumbore, two sided. Returns true for a hit closer than distance,
+    // which is updated together with u and v.
+    template<typename TRIANGLE>
+    bool hitTriangle(const TRIANGLE& t, const Vertex& origin, const Vertex& direction, Scalar& distance, Scalar& u, Scalar& v)
+    {
+        const Vertex p = direction.crossProduct(t.e2);
+        const Scalar det = t.e1.innerProduct(p);
+        if (det == 0)
+        {
+            return false;
+        }
+        const Scalar inv = 1 / det;
+        const Vertex s = origin - t.v0;
+        const Scalar hu = s.innerProduct(p) * inv;
+        if (hu < 0 || hu > 1)
+        {
+            return false;
+        }
+        const Vertex q = s.crossProduct(t.e1);
+        const Scalar hv = direction.innerProduct(q) * inv;
+        if (hv < 0 || hu + hv > 1)
+        {
+            return false;
+        }
+        const Scalar h = t.e2.innerProduct(q) * inv;
+        if (h <= 0 || h >= distance)
+        {
+            return false;
+        }
+        distance = h;
+        u = hu;
+        v = hv;
+        return true;
+    }
+
+    Scalar inverse(const Scalar& d)
+    {
+        return d == 0 ? Limits<Scalar>::MaxValue : 1 / d;
+    }
+}
+
+void FaceTree::build(const Vertices& vertices, const Faces& faces)
+{
+    clear();
+    size_t count = 0;
+    for (const auto& face : faces)
+    {
+        count += face.size() > 2 ? face.size() - 2 : 0;
+    }
+    if (count == 0)
+    {
+        return;
+    }
+    std::vector<Triangle> unordered;
+    unordered.reserve(count);
+    for (uint32_t faceIdx = 0; faceIdx < faces.size(); ++faceIdx)
+    {
+        const auto& face = faces[faceIdx];
+        const Vertex& v0 = vertices[face[0]];
+        for (uint32_t i = 0; i + 2 < face.size(); ++i)
+        {
+            unordered.push_back({ v0, vertices[face[i + 1]] - v0, vertices[face[i + 2]] - v0, faceIdx, i });
+        }
+    }
+    std::vector<Bounds> bounds(count);
+    std::vector<Vertex> centroids(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        const auto& t = unordered[i];
+        bounds[i].grow(t.v0);
+        bounds[i].grow(t.v0 + t.e1);
+        bounds[i].grow(t.v0 + t.e2);
+        centroids[i] = t.v0 + (t.e1 + t.e2) / 3;
+    }
+    std::vector<uint32_t> order(count);
+    std::iota(order.begin(), order.end(), 0);
+    nodes.reserve(2 * count);
+    nodes.emplace_back();
+
+    // Split the triangles [begin,end) of node, children are built depth first
+    auto split = [&](auto&& split, const uint32_t node, const uint32_t begin, const uint32_t end, const size_t depth) -> void
+    {
+        Bounds box, centroidBox;
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            box.grow(bounds[order[i]]);
+            centroidBox.grow(centroids[order[i]]);
+        }
+        for (size_t i = 0; i < 3; ++i)
+        {
+            nodes[node].min[i] = box.min[i];
+            nodes[node].max[i] = box.max[i];
+        }
+        auto makeLeaf = [&]()
+        {
+            nodes[node].offset = begin;
+            nodes[node].count = end - begin;
+            nodes[node].axis = 0;
+        };
+        const uint32_t n = end - begin;
+        const Vertex extent = centroidBox.max - centroidBox.min;
+        const size_t axis = (extent.x >= extent.y && extent.x >= extent.z) ? 0 : (extent.y >= extent.z ? 1 : 2);
+        if (n <= minLeafSize || depth >= maxDepth || extent[axis] <= 0)
+        {
+            makeLeaf();
+            return;
+        }
+        // bin the centroids along the longest axis and sweep for the cheapest split
+        auto binOf = [&](const uint32_t tri)
+        {
+            const size_t bin = (size_t)((centroids[tri][axis] - centroidBox.min[axis]) * binCount / extent[axis]);
+            return std::min(bin, binCount - 1);
+        };
+        Bounds binBounds[binCount];
+        size_t binCounts[binCount] = {};
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            const size_t bin = binOf(order[i]);
+            ++binCounts[bin];
+            binBounds[bin].grow(bounds[order[i]]);
+        }
+        Scalar rightCosts[binCount];
+        Bounds right;
+        size_t rightCount = 0;
+        for (size_t i = binCount - 1; i > 0; --i)
+        {
+            right.grow(binBounds[i]);
+            rightCount += binCounts[i];
+            rightCosts[i] = right.area() * rightCount;
+        }
+        Bounds left;
+        size_t leftCount = 0;
+        size_t bestSplit = 0;
+        Scalar bestCost = Limits<Scalar>::MaxValue;
+        for (size_t i = 1; i < binCount; ++i)
+        {
+            left.grow(binBounds[i - 1]);
+            leftCount += binCounts[i - 1];
+            const Scalar cost = left.area() * leftCount + rightCosts[i];
+            if (leftCount > 0 && leftCount < n && cost < bestCost)
+            {
+                bestCost = cost;
+                bestSplit = i;
+            }
+        }
+        // traversal cost 1, intersection cost 1 per triangle
+        const Scalar leafCost = (Scalar)n;
+        const Scalar splitCost = 1 + (box.area() > 0 ? bestCost / box.area() : (Scalar)n);
+        if (n <= maxLeafSize && leafCost <= splitCost)
+        {
+            makeLeaf();
+            return;
+        }
+        uint32_t middle;
+        if (bestSplit == 0)
+        {
+            // all centroids in one bin, fall back to a median split
+            middle = begin + n / 2;
+            std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end,
+                [&](const uint32_t a, const uint32_t b) { return centroids[a][axis] < centroids[b][axis]; });
+        }
+        else
+        {
+            middle = (uint32_t)(std::partition(order.begin() + begin, order.begin() + end,
+                [&](const uint32_t tri) { return binOf(tri) < bestSplit; }) - order.begin());
+        }
+        const uint32_t child = (uint32_t)nodes.size();
+        nodes[node].offset = child;
+        nodes[node].count = 0;
+        nodes[node].axis = (uint32_t)axis;
+        nodes.emplace_back();
+        nodes.emplace_back();
+        split(split, child, begin, middle, depth + 1);
+        split(split, child + 1, middle, end, depth + 1);
+    };
+    split(split, 0, 0, (uint32_t)count, 0);
+
+    triangles.reserve(count);
+    for (const auto& tri : order)
+    {
+        triangles.emplace_back(std::move(unordered[tri]));
+    }
+}
+
+RayHit FaceTree::intersect(const Ray& ray, const bool anyHit) const
+{
+    RayHit hit;
+    if (anyHit)
+    {
+        traverse<true>(ray, hit);
+    }
+    else
+    {
+        traverse<false>(ray, hit);
+    }
+    return hit;
+}
+
+void FaceTree::intersect(const Ray* rays, RayHit* hits, const size_t count, const bool anyHit) const
+{
+    if (anyHit)
+    {
+        traversePacket<true>(rays, hits, count);
+    }
+    else
+    {
+        traversePacket<false>(rays, hits, count);
+    }
+}
+
+int FaceTree::winding(const Vertex& origin) const
+{
+    if (nodes.empty())
+    {
+        return 0;
+    }
+    // A skew direction, so the ray is unlikely to hit edges or vertices of
+    // axis aligned or regular shapes exactly
+    static const Normal direction(0.5773, 0.5779, 0.5768);
+    const Scalar inv[3] = { 1 / direction.x, 1 / direction.y, 1 / direction.z };
+    int res = 0;
+    uint32_t stack[stackSize];
+    size_t top = 0;
+    stack[top++] = 0;
+    while (top > 0)
+    {
+        const Node& node = nodes[stack[--top]];
+        Scalar tNear = 0;
+        Scalar tFar = Limits<Scalar>::MaxValue;
+        for (size_t i = 0; i < 3; ++i)
+        {
+            const Scalar t0 = (node.min[i] - origin[i]) * inv[i];
+            const Scalar t1 = (node.max[i] - origin[i]) * inv[i];
+            tNear = std::max(tNear, std::min(t0, t1));
+            tFar = std::min(tFar, std::max(t0, t1));
+        }
+        if (tNear > tFar)
+        {
+            continue;
+        }
+        if (node.count > 0)
+        {
+            for (uint32_t i = node.offset; i < node.offset + node.count; ++i)
+            {
+                const Triangle& t = triangles[i];
+                Scalar distance = Limits<Scalar>::MaxValue;
+                Scalar u, v;
+                if (hitTriangle(t, origin, direction, distance, u, v))
+                {
+                    // the face normal is e1 x e2, leaving the shape means direction . normal > 0
+                    res += t.e1.crossProduct(t.e2).innerProduct(direction) > 0 ? 1 : -1;
+                }
+            }
+        }
+        else
+        {
+            stack[top++] = node.offset;
+            stack[top++] = node.offset + 1;
+        }
+    }
+    return res;
+}
+
+void FaceTree::overlapping(const Vertex& min, const Vertex& max, std::vector<uint32_t>& faces) const
+{
+    faces.clear();
+    if (nodes.empty())
+    {
+        return;
+    }
+    auto overlap = [&](const Vertex& otherMin, const Vertex& otherMax)
+    {
+        return
+            otherMax.x >= min.x && otherMin.x <= max.x &&
+            otherMax.y >= min.y && otherMin.y <= max.y &&
+            otherMax.z >= min.z && otherMin.z <= max.z;
+    };
+    uint32_t stack[stackSize];
+    size_t top = 0;
+    stack[top++] = 0;
+    while (top > 0)
+    {
+        const Node& node = nodes[stack[--top]];
+        if (!overlap(Vertex(node.min[0], node.min[1], node.min[2]), Vertex(node.max[0], node.max[1], node.max[2])))
+        {
+            continue;
+        }
+        if (node.count > 0)
+        {
+            for (uint32_t i = node.offset; i < node.offset + node.count; ++i)
+            {
+                const Triangle& t = triangles[i];
+                Bounds bounds;
+                bounds.grow(t.v0);
+                bounds.grow(t.v0 + t.e1);
+                bounds.grow(t.v0 + t.e2);
+                if (overlap(bounds.min, bounds.max))
+                {
+                    faces.push_back(t.face);
+                }
+            }
+        }
+        else
+        {
+            stack[top++] = node.offset;
+            stack[top++] = node.offset + 1;
+        }
+    }
+}
+
+template<bool ANYHIT>
+void FaceTree::traverse(const Ray& ray, RayHit& hit) const
+{
+    if (nodes.empty())
+    {
+        return;
+    }
+    const Vertex& origin = ray.origin;
+    const Vertex& direction = ray.direction;
+    const Scalar inv[3] = { inverse(direction.x), inverse(direction.y), inverse(direction.z) };
+    Scalar distance = ray.maxDistance;
+    uint32_t stack[stackSize];
+    size_t top = 0;
+    stack[top++] = 0;
+    while (top > 0)
+    {
+        const Node& node = nodes[stack[--top]];
+        Scalar tNear = 0;
+        Scalar tFar = distance;
+        for (size_t i = 0; i < 3; ++i)
+        {
+            const Scalar t0 = (node.min[i] - origin[i]) * inv[i];
+            const Scalar t1 = (node.max[i] - origin[i]) * inv[i];
+            tNear = std::max(tNear, std::min(t0, t1));
+            tFar = std::min(tFar, std::max(t0, t1));
+        }
+        if (tNear > tFar)
+        {
+            continue;
+        }
+        if (node.count > 0)
+        {
+            for (uint32_t i = node.offset; i < node.offset + node.count; ++i)
+            {
+                const Triangle& t = triangles[i];
+                if (hitTriangle(t, origin, direction, distance, hit.u, hit.v))
+                {
+                    hit.face = t.face;
+                    hit.triangle = t.triangle;
+                    hit.distance = distance;
+                    if (ANYHIT)
+                    {
+                        return;
+                    }
+                }
+            }
+        }
+        else
+        {
+            // visit the near child first
+            const bool lowFirst = direction[node.axis] >= 0;
+            stack[top++] = node.offset + (lowFirst ? 1 : 0);
+            stack[top++] = node.offset + (lowFirst ? 0 : 1);
+        }
+    }
+}
+
+template<bool ANYHIT>
+void FaceTree::traversePacket(const Ray* rays, RayHit* hits, const size_t count) const
+{
+    if (nodes.empty())
+    {
+        return;
+    }
+    // Structure of arrays per lane. The lane loops have a fixed trip count
+    // and no branches, so the compiler can turn them into vector instructions.
+    constexpr size_t N = packetSize;
+    Scalar origin[3][N];
+    Scalar direction[3][N];
+    Scalar inv[3][N];
+    Scalar distance[N];
+    for (size_t lane = 0; lane < N; ++lane)
+    {
+        const bool active = lane < count;
+        for (size_t i = 0; i < 3; ++i)
+        {
+            origin[i][lane] = active ? rays[lane].origin[i] : 0;
+            direction[i][lane] = active ? rays[lane].direction[i] : 0;
+            inv[i][lane] = active ? inverse(rays[lane].direction[i]) : 1;
+        }
+        // inactive lanes never pass the slab test
+        distance[lane] = active ? rays[lane].maxDistance : -1;
+    }
+    size_t done = N - std::min(count, N);
+    uint32_t stack[stackSize];
+    size_t top = 0;
+    stack[top++] = 0;
+    while (top > 0)
+    {
+        const Node& node = nodes[stack[--top]];
+        Scalar tNear[N];
+        Scalar tFar[N];
+        for (size_t lane = 0; lane < N; ++lane)
+        {
+            tNear[lane] = 0;
+            tFar[lane] = distance[lane];
+        }
+        for (size_t i = 0; i < 3; ++i)
+        {
+            for (size_t lane = 0; lane < N; ++lane)
+            {
+                const Scalar t0 = (node.min[i] - origin[i][lane]) * inv[i][lane];
+                const Scalar t1 = (node.max[i] - origin[i][lane]) * inv[i][lane];
+                tNear[lane] = std::max(tNear[lane], std::min(t0, t1));
+                tFar[lane] = std::min(tFar[lane], std::max(t0, t1));
+            }
+        }
+        unsigned mask = 0;
+        for (size_t lane = 0; lane < N; ++lane)
+        {
+            mask |= (tNear[lane] <= tFar[lane] ? 1u : 0u) << lane;
+        }
+        if (mask == 0)
+        {
+            continue;
+        }
+        if (node.count > 0)
+        {
+            for (uint32_t i = node.offset; i < node.offset + node.count; ++i)
+            {
+                // Moller-Trumbore for all lanes at once
+                const Triangle& t = triangles[i];
+                Scalar h[N];
+                Scalar hu[N];
+                Scalar hv[N];
+                for (size_t lane = 0; lane < N; ++lane)
+                {
+                    const Scalar px = direction[1][lane] * t.e2.z - direction[2][lane] * t.e2.y;
+                    const Scalar py = direction[2][lane] * t.e2.x - direction[0][lane] * t.e2.z;
+                    const Scalar pz = direction[0][lane] * t.e2.y - direction[1][lane] * t.e2.x;
+                    const Scalar det = t.e1.x * px + t.e1.y * py + t.e1.z * pz;
+                    const Scalar inv = det != 0 ? 1 / det : 0;
+                    const Scalar sx = origin[0][lane] - t.v0.x;
+                    const Scalar sy = origin[1][lane] - t.v0.y;
+                    const Scalar sz = origin[2][lane] - t.v0.z;
+                    const Scalar qx = sy * t.e1.z - sz * t.e1.y;
+                    const Scalar qy = sz * t.e1.x - sx * t.e1.z;
+                    const Scalar qz = sx * t.e1.y - sy * t.e1.x;
+                    hu[lane] = (sx * px + sy * py + sz * pz) * inv;
+                    hv[lane] = (direction[0][lane] * qx + direction[1][lane] * qy + direction[2][lane] * qz) * inv;
+                    h[lane] = (t.e2.x * qx + t.e2.y * qy + t.e2.z * qz) * inv;
+                }
+                unsigned hitMask = 0;
+                for (size_t lane = 0; lane < N; ++lane)
+                {
+                    const bool hit = hu[lane] >= 0 && hv[lane] >= 0 && hu[lane] + hv[lane] <= 1 && h[lane] > 0 && h[lane] < distance[lane];
+                    hitMask |= (hit ? 1u : 0u) << lane;
+                }
+                hitMask &= mask;
+                for (size_t lane = 0; hitMask != 0; ++lane, hitMask >>= 1)
+                {
+                    if ((hitMask & 1) == 0)
+                    {
+                        continue;
+                    }
+                    RayHit& hit = hits[lane];
+                    hit.face = t.face;
+                    hit.triangle = t.triangle;
+                    hit.distance = h[lane];
+                    hit.u = hu[lane];
+                    hit.v = hv[lane];
+                    distance[lane] = h[lane];
+                    if (ANYHIT)
+                    {
+                        // retire the lane
+                        distance[lane] = -1;
+                        mask &= ~(1u << lane);
+                        ++done;
+                    }
+                }
+                if (ANYHIT && done == N)
+                {
+                    return;
+                }
+            }
+        }
+        else
+        {
+            // visit the near child of the first active ray first
+            size_t first = 0;
+            while ((mask & (1u << first)) == 0)
+            {
+                ++first;
+            }
+            const bool lowFirst = direction[node.axis][first] >= 0;
+            stack[top++] = node.offset + (lowFirst ? 1 : 0);
+            stack[top++] = node.offset + (lowFirst ? 0 : 1);
+        }
+    }
+}
@@ -0,0 +1,140 @@
+﻿#include <cmath>
+#include <stdexcept>
+
+#include "internal/generic/Parallel.h"
+
+#include "internal/geometry/BoundingBox.h"
+#include "internal/geometry/QuantizedVertices.h"
+
+namespace
+{
+    constexpr uint64_t mask21 = (uint64_t(1) << 21) - 1;
+}
+
+QuantizedVertices::QuantizedVertices()
+    : precision(Precision::Bits16)
+{}
+
+QuantizedVertices::QuantizedVertices(const Vertices& vertices, const Precision precision)
+    : precision(precision)
+{
+    if (vertices.empty())
+    {
+        return;
+    }
+    const BoundingBox box(vertices);
+    const Scalar levels = (Scalar)((uint64_t(1) << (size_t)precision) - 1);
+    origin = box.min;
+    Vertex scale;
+    for (size_t i = 0; i < 3; ++i)
+    {
+        const Scalar extent = box.max[i] - box.min[i];
+        if (!std::isfinite(extent))
+        {
+            throw std::invalid_argument("vertices with a non finite coordinate can't be quantized");
+        }
+        // a flat box keeps all coordinates at the origin
+        step[i] = (extent > 0) ? extent / levels : 0;
+        scale[i] = (extent > 0) ? levels / extent : 0;
+    }
+    auto quantize = [&](const Vertex& vertex, const size_t i)
+    {
+        return (uint64_t)std::min(levels, std::round((vertex[i] - origin[i]) * scale[i]));
+    };
+    if (precision == Precision::Bits16)
+    {
+        coordinates16.resize(3 * vertices.size());
+        Parallel::For(vertices.size(), [&](const size_t index)
+            {
+                for (size_t i = 0; i < 3; ++i)
+                {
+                    coordinates16[3 * index + i] = (uint16_t)quantize(vertices[index], i);
+                }
+            });
+    }
+    else
+    {
+        coordinates21.resize(vertices.size());
+        Parallel::For(vertices.size(), [&](const size_t index)
+            {
+                const Vertex& vertex = vertices[index];
+                coordinates21[index] = quantize(vertex, 0) | (quantize(vertex, 1) << 21) | (quantize(vertex, 2) << 42);
+            });
+    }
+}
+
+size_t QuantizedVertices::size() const
+{
+    return (precision == Precision::Bits16) ? coordinates16.size() / 3 : coordinates21.size();
+}
+
+bool QuantizedVertices::empty() const
+{
+    return size() == 0;
+}
+
+QuantizedVertices::Precision QuantizedVertices::getPrecision() const
+{
+    return precision;
+}
+
+size_t QuantizedVertices::getMemorySize() const
+{
+    return coordinates16.size() * sizeof(uint16_t) + coordinates21.size() * sizeof(uint64_t);
+}
+
+Vertex QuantizedVertices::getMaxError() const
+{
+    return step / 2;
+}
+
+void QuantizedVertices::coordinates(const size_t index, uint32_t (&q)[3]) const
+{
+    if (precision == Precision::Bits16)
+    {
+        const uint16_t* c = &coordinates16[3 * index];
+        q[0] = c[0];
+        q[1] = c[1];
+        q[2] = c[2];
+    }
+    else
+    {
+        const uint64_t c = coordinates21[index];
+        q[0] = (uint32_t)(c & mask21);
+        q[1] = (uint32_t)((c >> 21) & mask21);
+        q[2] = (uint32_t)((c >> 42) & mask21);
+    }
+}
+
+Vertex QuantizedVertices::decode(const size_t index) const
+{
+    if (index >= size())
+    {
+        throw std::out_of_range("vertex index out of range");
+    }
+    uint32_t q[3];
+    coordinates(index, q);
+    return Vertex(origin.x + q[0] * step.x, origin.y + q[1] * step.y, origin.z + q[2] * step.z);
+}
+
+Vertices QuantizedVertices::decode() const
+{
+    return decode(Transformation());
+}
+
+Vertices QuantizedVertices::decode(const Transformation& transformation) const
+{
+    // transformation * (origin + q * step) = base + q.x * axisX + q.y * axisY + q.z * axisZ
+    const Vertex base = transformation * origin;
+    const Vertex axisX = transformation.rotate(Vertex(step.x, 0, 0));
+    const Vertex axisY = transformation.rotate(Vertex(0, step.y, 0));
+    const Vertex axisZ = transformation.rotate(Vertex(0, 0, step.z));
+    Vertices res(size());
+    Parallel::For(res.size(), [&](const size_t index)
+        {
+            uint32_t q[3];
+            coordinates(index, q);
+            res[index] = base + axisX * (Scalar)q[0] + axisY * (Scalar)q[1] + axisZ * (Scalar)q[2];
+        });
+    return res;
+}
@@ -1,94 +1,257 @@
-﻿#include <map>
+﻿#include <cmath>
 #include <numeric>
-#include <tuple>
+#include <unordered_map>
+
+#include "internal/generic/Parallel.h"
 
 #include "internal/geometry/Shape.h"
 
+Shape::Geometry::Geometry()
+{
+    verticesReady.set();
+}
+
+Shape::Geometry::Geometry(const Vertices& vertices, const Faces& faces)
+    : faces(faces)
+    , vertices(vertices)
+{
+    verticesReady.set();
+}
+
+Shape::Geometry::Geometry(Vertices&& vertices, Faces&& faces)
+    : faces(std::move(faces))
+    , vertices(std::move(vertices))
+{
+    verticesReady.set();
+}
+
+Shape::Geometry::Geometry(const QuantizedVertices& quantized, const Faces& faces)
+    : faces(faces)
+    , quantized(quantized)
+{}
+
+Shape::Geometry::Geometry(VerticesF&& singleVertices, Faces&& faces)
+    : faces(std::move(faces))
+    , singleVertices(std::move(singleVertices))
+{}
+
+// Volatile data is only copied when ready, other instances may be computing it
+Shape::Geometry::Geometry(const Geometry& other)
+    : faces(other.faces)
+    , quantized(other.quantized)
+    , singleVertices(other.singleVertices)
+{
+    if (other.verticesReady.isSet())
+    {
+        vertices = other.vertices;
+        verticesReady.set();
+    }
+    if (other.normalsReady.isSet())
+    {
+        normals = other.normals;
+        normalsReady.set();
+    }
+    if (other.surfaceAreasReady.isSet())
+    {
+        surfaceAreas = other.surfaceAreas;
+        surfaceAreasReady.set();
+    }
+    if (other.edgesReady.isSet())
+    {
+        edges = other.edges;
+        vertexEdges = other.vertexEdges;
+        edgesReady.set();
+    }
+    if (other.convexReady.isSet())
+    {
+        convex = other.convex;
+        convexReady.set();
+    }
+    if (other.faceTreeReady.isSet())
+    {
+        faceTree = other.faceTree;
+        faceTreeReady.set();
+    }
+}
+
+const std::shared_ptr<Shape::Geometry>& Shape::EmptyGeometry()
+{
+    static const std::shared_ptr<Geometry> empty = std::make_shared<Geometry>();
+    return empty;
+}
+
+Shape::Geometry& Shape::modifyGeometry()
+{
+    requireVertices();
+    if (geometry.use_count() > 1)
+    {
+        geometry = std::make_shared<Geometry>(*geometry);
+    }
+    // the compact vertices no longer match after the change
+    geometry->quantized = QuantizedVertices();
+    VerticesF().swap(geometry->singleVertices);
+    return *geometry;
+}
+
 Shape::Shape()
-    : vertices()
-    , faces()
+    : geometry(EmptyGeometry())
     , transformation()
-    , normals()
-    , edges()
-    , surfaceAreas()
     , bounds()
 {}
 
-Shape::Shape(const Vertices & vertices, const Faces & faces)
-    : vertices(vertices)
-    , faces(faces)
+Shape::Shape(const Vertices & vertices, const Faces & faces, const bool weldVertices)
+    : geometry(std::make_shared<Geometry>(vertices, faces))
     , transformation()
-    , normals()
-    , edges()
-    , surfaceAreas()
     , bounds()
 {
-    optimize();
+    if (weldVertices)
+    {
+        weld();
+    }
+    else
+    {
+        optimize();
+    }
+}
+
+Shape::Shape(Vertices && vertices, Faces && faces, const bool weldVertices)
+    : geometry(std::make_shared<Geometry>(std::move(vertices), std::move(faces)))
+    , transformation()
+    , bounds()
+{
+    if (weldVertices)
+    {
+        weld();
+    }
+    else
+    {
+        optimize();
+    }
 }
 
+Shape::Shape(const QuantizedVertices& vertices, const Faces& faces)
+    : geometry(std::make_shared<Geometry>(vertices, faces))
+    , transformation()
+    , bounds()
+{
+    removeUnusedCompactVertices(vertices.size());
+}
+
+void Shape::setSingleVertices(VerticesF&& vertices, Faces&& faces)
+{
+    geometry = std::make_shared<Geometry>(std::move(vertices), std::move(faces));
+    removeUnusedCompactVertices(geometry->singleVertices.size());
+}
+
+// Unused vertices are removed as by the other constructors, which needs the
+// converted vertices. Shapes stored compactly normally use them all.
+void Shape::removeUnusedCompactVertices(const size_t vertexCount)
+{
+    std::vector<bool> used(vertexCount, false);
+    for (const auto& face : geometry->faces)
+    {
+        for (const auto& point : face)
+        {
+            used.at(point) = true;
+        }
+    }
+    if (std::find(used.begin(), used.end(), false) != used.end())
+    {
+        optimize();
+    }
+}
+
+// The world space data of the copy is computed when needed
 Shape::Shape(const Shape& other)
-    : vertices(other.vertices)
-    , faces(other.faces)
+    : geometry(other.geometry)
     , transformation(other.transformation)
-    , normals(other.normals)
-    , edges(other.edges)
-    , surfaceAreas(other.surfaceAreas)
-    , bounds(other.bounds)
-{}
+    , bounds()
+{
+    if (other.boundsReady.isSet())
+    {
+        bounds = other.bounds;
+        boundsReady.set();
+    }
+    if (other.levelsOfDetailReady.isSet())
+    {
+        levelsOfDetail = std::vector<Shape>(other.levelsOfDetail);
+        levelsOfDetailReady.set();
+    }
+}
 
+// The moved from shape is left empty
 Shape::Shape(Shape&& other) noexcept
-    : vertices(std::move(other.vertices))
-    , faces(std::move(other.faces))
+    : geometry(std::move(other.geometry))
     , transformation(std::move(other.transformation))
-    , normals(std::move(other.normals))
-    , edges(std::move(other.edges))
-    , surfaceAreas(std::move(other.surfaceAreas))
+    , transformedVertices(std::move(other.transformedVertices))
+    , transformedVerticesReady(other.transformedVerticesReady)
+    , transformedNormals(std::move(other.transformedNormals))
+    , transformedNormalsReady(other.transformedNormalsReady)
     , bounds(std::move(other.bounds))
-{}
+    , boundsReady(other.boundsReady)
+    , levelsOfDetail(std::move(other.levelsOfDetail))
+    , levelsOfDetailReady(other.levelsOfDetailReady)
+{
+    other.geometry = EmptyGeometry();
+    other.invalidateBounds();
+    other.invalidateLevelsOfDetail();
+    other.invalidateTransformedNormals();
+    other.invalidateTransformedVertices();
+}
 
 void Shape::scale(const double& factor)
 {
-    for (auto& vertex : vertices)
+    modifyGeometry();
+    for (auto& vertex : geometry->vertices)
     {
         vertex *= factor;
     }
     // update affected volatile data if present
-    if(bounds) bounds.scale(factor);
-    if (!transformedVertices.empty())
+    if (boundsReady.isSet()) bounds.scale(factor);
+    if (transformedVerticesReady.isSet())
     {
         for (auto& vertex : transformedVertices)
         {
             vertex *= factor;
         }
     }
+    for (auto& levelOfDetail : levelsOfDetail)
+    {
+        levelOfDetail.scale(factor);
+    }
+    // a negative factor turns the shape inside out
+    invalidateConvexity();
+    invalidateFaceTree();
     invalidateSurfaceAreas();
 }
 
-void Shape::optimize()
+void Shape::optimize(const bool improveLocality)
 {
-    bool optimizationNeeded = false;
-    std::vector<size_t> counts(vertices.size(), 0);
-    for (const auto& face : faces)
+    requireVertices();
+    std::vector<size_t> counts(geometry->vertices.size(), 0);
+    for (const auto& face : geometry->faces)
     {
         for (const auto& point : face)
         {
-            optimizationNeeded |= (++counts[point]) > 1;
+            ++counts[point];
         }
     }
+    bool optimizationNeeded = std::find(counts.begin(), counts.end(), 0) != counts.end();
     if (optimizationNeeded)
     {
+        modifyGeometry();
         size_t j = 0;
-        std::vector<Index> mapping(vertices.size(), 0);
+        std::vector<Index> mapping(geometry->vertices.size(), 0);
         for (size_t i = 0; i < counts.size(); ++i)
         {
             if (counts[i] != 0)
             {
-                vertices[i].swap(vertices[j]);
+                geometry->vertices[i].swap(geometry->vertices[j]);
                 mapping[i] = (Index)j++;
             }
         }
-        vertices.resize(j);
-        for (auto& face : faces)
+        geometry->vertices.resize(j);
+        for (auto& face : geometry->faces)
         {
             for (auto& point : face)
             {
@@ -97,12 +260,293 @@ void Shape::optimize()
         }
         // update affected volatile data
         invalidateBounds();
+        invalidateFaceTree();
         invalidateTransformedVertices();
     }
+    if (improveLocality)
+    {
+        reorderFaces();
+        reorderVertices();
+    }
+}
+
+// Tipsify, see "Fast Triangle Reordering for Vertex Locality and Reduced 
+// Overdraw" (Sander, Nehab, Barczak 2007).
+// Walks the mesh fanning around a vertex, emitting all its unused faces, then
+// continues with a neighbouring vertex which is still in the (simulated) cache.
+void Shape::reorderFaces()
+{
+    modifyGeometry();
+    const size_t cacheSize = 16;
+    const size_t vertexCount = geometry->vertices.size();
+    const Index none = std::numeric_limits<Index>::max();
+    // vertex => faces adjacency (compressed rows)
+    std::vector<size_t> offsets(vertexCount + 1, 0);
+    for (const auto& face : geometry->faces)
+    {
+        for (const auto& point : face)
+        {
+            ++offsets[point + 1];
+        }
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    std::vector<size_t> adjacency(offsets.back());
+    std::vector<size_t> live(vertexCount);
+    {
+        auto fill = offsets;
+        for (size_t i = 0; i < geometry->faces.size(); ++i)
+        {
+            for (const auto& point : geometry->faces[i])
+            {
+                adjacency[fill[point]++] = i;
+            }
+        }
+        for (size_t i = 0; i < vertexCount; ++i)
+        {
+            live[i] = offsets[i + 1] - offsets[i];
+        }
+    }
+    std::vector<size_t> timestamps(vertexCount, 0);
+    std::vector<bool> emitted(geometry->faces.size(), false);
+    std::vector<Index> deadEnds;
+    std::vector<Index> candidates;
+    std::vector<size_t> order;
+    order.reserve(geometry->faces.size());
+    size_t time = cacheSize + 1;
+    size_t cursor = 0;
+    // next vertex with live faces: from the dead end stack, or the next in input order
+    auto skipDeadEnd = [&]()
+    {
+        while (!deadEnds.empty())
+        {
+            Index vertex = deadEnds.back();
+            deadEnds.pop_back();
+            if (live[vertex] > 0)
+            {
+                return vertex;
+            }
+        }
+        for (; cursor < vertexCount; ++cursor)
+        {
+            if (live[cursor] > 0)
+            {
+                return (Index)cursor;
+            }
+        }
+        return none;
+    };
+    Index fanning = skipDeadEnd();
+    while (fanning != none)
+    {
+        candidates.clear();
+        for (size_t i = offsets[fanning]; i < offsets[fanning + 1]; ++i)
+        {
+            const size_t faceIdx = adjacency[i];
+            if (!emitted[faceIdx])
+            {
+                for (const auto& point : geometry->faces[faceIdx])
+                {
+                    deadEnds.emplace_back(point);
+                    candidates.emplace_back(point);
+                    --live[point];
+                    if (time - timestamps[point] > cacheSize)
+                    {
+                        timestamps[point] = time++;
+                    }
+                }
+                emitted[faceIdx] = true;
+                order.emplace_back(faceIdx);
+            }
+        }
+        // prefer the candidate which entered the cache first, as long as 
+        // its remaining faces will still find it in the cache
+        Index next = none;
+        size_t bestPriority = 0;
+        for (const auto& candidate : candidates)
+        {
+            if (live[candidate] > 0)
+            {
+                size_t priority = 1;
+                if (time - timestamps[candidate] + 2 * live[candidate] <= cacheSize)
+                {
+                    priority += time - timestamps[candidate];
+                }
+                if (priority > bestPriority)
+                {
+                    bestPriority = priority;
+                    next = candidate;
+                }
+            }
+        }
+        fanning = (next == none) ? skipDeadEnd() : next;
+    }
+    Faces reordered;
+    reordered.reserve(geometry->faces.size());
+    for (const auto& faceIdx : order)
+    {
+        reordered.emplace_back(std::move(geometry->faces[faceIdx]));
+    }
+    geometry->faces.swap(reordered);
+    // update affected volatile data
+    invalidateEdges();
+    invalidateFaceTree();
+    invalidateNormals();
+    invalidateTransformedNormals();
+    invalidateSurfaceAreas();
+}
+
+// Renumber the vertices in order of first use by the faces
+void Shape::reorderVertices()
+{
+    modifyGeometry();
+    // counted in 32 bits, all Index values can be in use
+    const uint32_t none = std::numeric_limits<uint32_t>::max();
+    std::vector<uint32_t> mapping(geometry->vertices.size(), none);
+    uint32_t count = 0;
+    for (auto& face : geometry->faces)
+    {
+        for (auto& point : face)
+        {
+            if (mapping[point] == none)
+            {
+                mapping[point] = count++;
+            }
+            point = (Index)mapping[point];
+        }
+    }
+    Vertices reordered(count);
+    for (size_t i = 0; i < mapping.size(); ++i)
+    {
+        if (mapping[i] != none)
+        {
+            reordered[mapping[i]].swap(geometry->vertices[i]);
+        }
+    }
+    geometry->vertices.swap(reordered);
+    // update affected volatile data
+    invalidateEdges();
+    invalidateFaceTree();
+    invalidateTransformedVertices();
+}
+
+void Shape::weld(const Scalar& tolerance)
+{
+    // Uniform grid spatial hash. With a cell size of at least the tolerance,
+    // all candidates for a vertex are in the 27 cells around its own cell.
+    // The cell size is kept large enough for the cell coordinates to fit in 
+    // 64 bits, a larger cell only means more candidates per cell.
+    requireVertices();
+    Scalar maxCoordinate = 0;
+    for (const auto& vertex : geometry->vertices)
+    {
+        maxCoordinate = std::max({ maxCoordinate, std::abs(vertex.x), std::abs(vertex.y), std::abs(vertex.z) });
+    }
+    const Scalar cellSize = std::max({ tolerance, maxCoordinate * std::ldexp((Scalar)1, -40), std::numeric_limits<Scalar>::min() });
+    auto cell = [&cellSize](const Scalar& value) 
+    { 
+        return (int64_t)std::floor(value / cellSize); 
+    };
+    auto hash = [](const int64_t x, const int64_t y, const int64_t z) 
+    { 
+        return (size_t)((uint64_t)x * 73856093u ^ (uint64_t)y * 19349663u ^ (uint64_t)z * 83492791u); 
+    };
+    // Cells with the same hash share one chain of representatives. The
+    // vertices are counted in 32 bits, there can be more than Index holds.
+    const uint32_t none = std::numeric_limits<uint32_t>::max();
+    std::unordered_map<size_t, uint32_t> chains;
+    chains.reserve(geometry->vertices.size());
+    std::vector<uint32_t> next(geometry->vertices.size(), none);
+    std::vector<uint32_t> mapping(geometry->vertices.size(), none);
+    bool welded = false;
+    for (size_t i = 0; i < geometry->vertices.size(); ++i)
+    {
+        const auto& vertex = geometry->vertices[i];
+        const int64_t x = cell(vertex.x);
+        const int64_t y = cell(vertex.y);
+        const int64_t z = cell(vertex.z);
+        for (int64_t dx = -1; dx <= 1 && mapping[i] == none; ++dx)
+        {
+            for (int64_t dy = -1; dy <= 1 && mapping[i] == none; ++dy)
+            {
+                for (int64_t dz = -1; dz <= 1 && mapping[i] == none; ++dz)
+                {
+                    auto iter = chains.find(hash(x + dx, y + dy, z + dz));
+                    for (uint32_t j = (iter == chains.end() ? none : iter->second); j != none; j = next[j])
+                    {
+                        const auto& other = geometry->vertices[j];
+                        if (Numerics::Equal(vertex.x, other.x, tolerance)
+                         && Numerics::Equal(vertex.y, other.y, tolerance)
+                         && Numerics::Equal(vertex.z, other.z, tolerance))
+                        {
+                            mapping[i] = j;
+                            welded = true;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+        if (mapping[i] == none)
+        {
+            // new representative
+            mapping[i] = (uint32_t)i;
+            auto& chain = chains.try_emplace(hash(x, y, z), none).first->second;
+            next[i] = chain;
+            chain = (uint32_t)i;
+        }
+    }
+    if (welded)
+    {
+        modifyGeometry();
+        // remap the faces in place, remove collapsed points and faces
+        std::vector<Index> points;
+        size_t j = 0;
+        for (size_t i = 0; i < geometry->faces.size(); ++i)
+        {
+            auto& face = geometry->faces[i];
+            points.clear();
+            for (auto& point : face)
+            {
+                // a vertex only maps to one before it, so the index still fits
+                point = (Index)mapping[point];
+                if (points.empty() || points.back() != point)
+                {
+                    points.emplace_back(point);
+                }
+            }
+            while (points.size() > 1 && points.front() == points.back())
+            {
+                points.pop_back();
+            }
+            if (points.size() != face.size())
+            {
+                face.set(points);
+            }
+            if (face.size() > 2)
+            {
+                geometry->faces[j++].swap(face);
+            }
+        }
+        geometry->faces.resize(j);
+        // update affected volatile data
+        invalidateConvexity();
+        invalidateEdges();
+        invalidateFaceTree();
+        invalidateLevelsOfDetail();
+        invalidateNormals();
+        invalidateTransformedNormals();
+        invalidateSurfaceAreas();
+    }
+    // drop the vertices which are no longer used
+    optimize();
 }
 
 void Shape::translate(const Vertex& translation)
 {
+    for (auto& levelOfDetail : levelsOfDetail)
+    {
+        levelOfDetail.translate(translation);
+    }
     transformation *= Transformation(translation);
     invalidateBounds();
     invalidateTransformedNormals();
@@ -111,6 +555,10 @@ void Shape::translate(const Vertex& translation)
 
 void Shape::rotate(const Normal& axis, const Scalar& angle)
 {
+    for (auto& levelOfDetail : levelsOfDetail)
+    {
+        levelOfDetail.rotate(axis, angle);
+    }
     transformation *= Transformation(axis, angle);
     invalidateBounds();
     invalidateTransformedNormals();
@@ -121,12 +569,13 @@ Scalar Shape::calculateSurfaceArea() const
 {
     // Make required volatile data available
     requireSurfaceAreas();
-    return std::accumulate(surfaceAreas.begin(), surfaceAreas.end(), 0.0);
+    return std::accumulate(geometry->surfaceAreas.begin(), geometry->surfaceAreas.end(), 0.0);
 }
 
 Scalar Shape::calculateVolume() const
 {
     // Make required volatile data available
+    requireVertices();
     requireNormals();
     requireSurfaceAreas();
     // iterate over the faces
@@ -137,18 +586,103 @@ Scalar Shape::calculateVolume() const
         // is it really neccesairy to do this for all vertices?
         for (const auto i : face)
         {
-            volume += surface * vertices[i].innerProduct(normal);
+            volume += surface * geometry->vertices[i].innerProduct(normal);
         }
         return volume / (3 * face.size());
     };
     Scalar res = 0;
-    for (size_t i = 0; i < faces.size(); ++i)
+    for (size_t i = 0; i < geometry->faces.size(); ++i)
     {
-        res += faceVolume(faces[i],normals[i],surfaceAreas[i]);
+        res += faceVolume(geometry->faces[i],geometry->normals[i],geometry->surfaceAreas[i]);
     }
     return res;
 }
 
+RayHit Shape::raycast(const Ray& ray) const
+{
+    // Make required volatile data available
+    requireFaceTree();
+    const auto inverse = transformation.inverted();
+    return geometry->faceTree.intersect(Ray(inverse * ray.origin, inverse.rotate(ray.direction), ray.maxDistance), false);
+}
+
+RayHit Shape::raycastAny(const Ray& ray) const
+{
+    // Make required volatile data available
+    requireFaceTree();
+    const auto inverse = transformation.inverted();
+    return geometry->faceTree.intersect(Ray(inverse * ray.origin, inverse.rotate(ray.direction), ray.maxDistance), true);
+}
+
+std::vector<RayHit> Shape::raycast(const std::vector<Ray>& rays) const
+{
+    return raycast(rays, false);
+}
+
+std::vector<RayHit> Shape::raycastAny(const std::vector<Ray>& rays) const
+{
+    return raycast(rays, true);
+}
+
+std::vector<RayHit> Shape::raycast(const std::vector<Ray>& rays, const bool anyHit) const
+{
+    // Make required volatile data available (before going parallel)
+    requireFaceTree();
+    const auto inverse = transformation.inverted();
+    constexpr size_t packetSize = FaceTree::packetSize;
+    std::vector<RayHit> hits(rays.size());
+    const size_t packets = (rays.size() + packetSize - 1) / packetSize;
+    Parallel::ForRanges(packets, [&](const size_t begin, const size_t end)
+        {
+            Ray local[packetSize];
+            for (size_t packet = begin; packet < end; ++packet)
+            {
+                const size_t first = packet * packetSize;
+                const size_t count = std::min(packetSize, rays.size() - first);
+                for (size_t i = 0; i < count; ++i)
+                {
+                    const Ray& ray = rays[first + i];
+                    local[i] = Ray(inverse * ray.origin, inverse.rotate(ray.direction), ray.maxDistance);
+                }
+                geometry->faceTree.intersect(local, &hits[first], count, anyHit);
+            }
+        }, 64);
+    return hits;
+}
+
+bool Shape::contains(const Vertex& point) const
+{
+    // Make required volatile data available
+    requireBounds();
+    if (!bounds.contains(point))
+    {
+        return false;
+    }
+    requireFaceTree();
+    return geometry->faceTree.winding(transformation.inverted() * point) != 0;
+}
+
+void Shape::contains(const Vertices& points, std::vector<bool>& inside) const
+{
+    // Make required volatile data available (before going parallel)
+    requireBounds();
+    requireFaceTree();
+    const auto inverse = transformation.inverted();
+    inside.assign(points.size(), false);
+    // Threads work on blocks of 64 points, so they never write to the same
+    // word of the bit vector
+    constexpr size_t blockSize = 64;
+    const size_t blocks = (points.size() + blockSize - 1) / blockSize;
+    Parallel::ForRanges(blocks, [&](const size_t begin, const size_t end)
+        {
+            const size_t last = std::min(points.size(), end * blockSize);
+            for (size_t i = begin * blockSize; i < last; ++i)
+            {
+                inside[i] = bounds.contains(points[i]) && geometry->faceTree.winding(inverse * points[i]) != 0;
+            }
+        }, 4);
+}
+
 bool Shape::detectCollision(const Shape& other) const
 {
     // Make required volatile data available
@@ -158,9 +692,15 @@ bool Shape::detectCollision(const Shape& other) const
     {
         return false;
     }
+    if (isConvex() && other.isConvex())
+    {
+        return overlapConvex(other);
+    }
     // Make required volatile data available
 //    requireEdges();
 //    other.requireEdges();
+    requireVertices();
+    other.requireVertices();
     requireTransformedVertices();
     other.requireTransformedVertices();
     // check faces using eventline
@@ -179,7 +719,7 @@ bool Shape::detectCollision(const Shape& other) const
             vertices.reserve(face.size());
             for (const auto& i : face)
             {
-                vertices.emplace_back(shape.vertices[i]);
+                vertices.emplace_back(shape.geometry->vertices[i]);
             }
             std::sort(vertices.begin(), vertices.end(), MaxVertex());
             max = vertices.front();
@@ -196,12 +736,12 @@ bool Shape::detectCollision(const Shape& other) const
         }
     };
     std::vector<Event> events;
-    events.reserve(faces.size() + other.faces.size());
-    for (const auto& face : faces)
+    events.reserve(geometry->faces.size() + other.geometry->faces.size());
+    for (const auto& face : geometry->faces)
     {
         events.emplace_back(*this, face);
     }
-    for (const auto& face : other.faces)
+    for (const auto& face : other.geometry->faces)
     {
         events.emplace_back(other, face);
     }
@@ -213,7 +753,8 @@ bool Shape::detectCollision(const Shape& other) const
 
 const Vertices& Shape::getVertices() const
 {
-    return vertices;
+    requireVertices();
+    return geometry->vertices;
 }
 
 const Vertices& Shape::getTransformedVertices() const
@@ -222,10 +763,16 @@ const Vertices& Shape::getTransformedVertices() const
     return transformedVertices;
 }
 
+const Edges& Shape::getEdges() const
+{
+    requireEdges();
+    return geometry->edges;
+}
+
 const Normals& Shape::getNormals() const
 {
     requireNormals();
-    return normals;
+    return geometry->normals;
 }
 
 const Normals& Shape::getTransformedNormals() const
@@ -236,97 +783,180 @@ const Normals& Shape::getTransformedNormals() const
 
 const Faces& Shape::getRawFaces() const
 {
-    return faces;
+    return geometry->faces;
 }
 
 const Face& Shape::getRawFace(const size_t& index) const
 {
-    return faces.at(index);
+    return geometry->faces.at(index);
 }
 
 FaceVisitor Shape::getFace(const size_t& index) const
 {
+    requireVertices();
     requireNormals();
-    return FaceVisitor(faces.at(index), vertices, normals.at(index));
+    return FaceVisitor(geometry->faces.at(index), geometry->vertices, geometry->normals.at(index));
 }
 
 FaceVisitor Shape::getTransformedFace(const size_t& index) const
 {
     requireTransformedVertices();
     requireTransformedNormals();
-    return FaceVisitor(faces.at(index), transformedVertices, transformedNormals.at(index));
+    return FaceVisitor(geometry->faces.at(index), transformedVertices, transformedNormals.at(index));
 }
 
 void Shape::invalidateBounds() const
 {
+    boundsReady.reset();
     bounds.invalidate();
 }
 
+void Shape::invalidateConvexity() const
+{
+    geometry->convexReady.reset();
+    geometry->convex.reset();
+}
+
 void Shape::invalidateEdges() const
 {
-    edges.clear();
+    geometry->edgesReady.reset();
+    geometry->edges.clear();
+    geometry->vertexEdges.clear();
+}
+
+void Shape::invalidateFaceTree() const
+{
+    geometry->faceTreeReady.reset();
+    geometry->faceTree.clear();
+}
+
+void Shape::invalidateLevelsOfDetail() const
+{
+    levelsOfDetailReady.reset();
+    levelsOfDetail.clear();
 }
 
 void Shape::invalidateNormals() const
 {
-    normals.clear();
+    geometry->normalsReady.reset();
+    geometry->normals.clear();
 }
 
 void Shape::invalidateTransformedNormals() const
 {
+    transformedNormalsReady.reset();
     transformedNormals.clear();
 }
 
 void Shape::invalidateSurfaceAreas() const
 {
-    surfaceAreas.clear();
+    geometry->surfaceAreasReady.reset();
+    geometry->surfaceAreas.clear();
 }
 
 void Shape::invalidateTransformedVertices() const
 {
+    transformedVerticesReady.reset();
     transformedVertices.clear();
 }
 
 void Shape::requireBounds() const
 {
     requireTransformedVertices();
-    if (!bounds)
-    {
-        bounds.create(transformedVertices);
-    }
+    boundsReady.call([&]()
+        {
+            bounds.create(transformedVertices);
+        });
+}
+
+void Shape::requireConvexity() const
+{
+    geometry->convexReady.call([&]()
+        {
+            requireVertices();
+            requireEdges();
+            requireNormals();
+            // closed, no holes (Euler characteristic 2), and at every edge the
+            // neighbouring face bends away from the face plane
+            const long long euler = (long long)geometry->vertices.size() - (long long)geometry->edges.size() / 2 + (long long)geometry->faces.size();
+            bool res = !geometry->faces.empty() && euler == 2;
+            Scalar size = 0;
+            for (const auto& vertex : geometry->vertices)
+            {
+                size = std::max({ size, std::abs(vertex.x), std::abs(vertex.y), std::abs(vertex.z) });
+            }
+            const Scalar tolerance = size * 1e-9;
+            for (size_t i = 0; res && i < geometry->edges.size(); ++i)
+            {
+                const auto& edge = geometry->edges[i];
+                if (edge.mirrorEdge == Edge::none)
+                {
+                    res = false;
+                    break;
+                }
+                const Index neighbour = geometry->edges[geometry->edges[edge.mirrorEdge].nextEdge].endVertex;
+                res = geometry->normals[edge.face].innerProduct(geometry->vertices[neighbour] - geometry->vertices[edge.startVertex]) <= tolerance;
+            }
+            geometry->convex = res;
+        });
 }
 
 void Shape::requireEdges() const
 {
-    if (edges.empty())
-    {
-        // [start point, end point] => [face,pre start point,after end point,edgeIdx]
-        std::map<std::tuple<Index, Index>, std::tuple<Index,Index,Index,Index>> edgesMap;
-        for (Index faceIdx = 0; faceIdx < faces.size(); ++faceIdx)
+    geometry->edgesReady.call([&]()
         {
-            const auto& face = faces[faceIdx];
-            Index prev = face[face.size() - 2];
-            Index start = face[face.size() - 1];
-            for (Index end = 0; end < face.size(); ++end)
+            requireVertices();
+            size_t count = 0;
+            for (const auto& face : geometry->faces)
             {
-                Index next = (end + 1) % face.size();
-                edgesMap[std::make_tuple(start,end)] = std::make_tuple(faceIdx,prev,next,(Index)edgesMap.size());
-                prev = start;
-                start = end;
+                count += face.size();
             }
-        }
-        edges.resize(edgesMap.size());
-        for (auto& edgeData : edgesMap)
-        {
-            auto& edge = edges[std::get<3>(edgeData.second)];
-            edge.startVertex = std::get<0>(edgeData.first);
-            edge.endVertex = std::get<1>(edgeData.first);
-            edge.face = std::get<0>(edgeData.second);
-            edge.mirrorEdge = std::get<3>(edgesMap[std::make_tuple(edge.endVertex, edge.startVertex)]);
-            edge.prevEdge = std::get<3>(edgesMap[std::make_tuple(std::get<1>(edgeData.second), edge.startVertex)]);
-            edge.nextEdge = std::get<3>(edgesMap[std::make_tuple(edge.endVertex, std::get<2>(edgeData.second))]);
-        }
-    }
+            geometry->edges.resize(count);
+            geometry->vertexEdges.assign(geometry->vertices.size(), Edge::none);
+            // [start point, end point] => edgeIdx
+            std::unordered_map<uint32_t, uint32_t> edgesMap;
+            edgesMap.reserve(count);
+            auto key = [](const Index start, const Index end)
+            {
+                return ((uint32_t)start << (8 * sizeof(Index))) | end;
+            };
+            uint32_t first = 0;
+            for (size_t faceIdx = 0; faceIdx < geometry->faces.size(); ++faceIdx)
+            {
+                const auto& face = geometry->faces[faceIdx];
+                const uint32_t size = face.size();
+                for (uint32_t i = 0; i < size; ++i)
+                {
+                    auto& edge = geometry->edges[first + i];
+                    edge.face = (uint32_t)faceIdx;
+                    edge.startVertex = face[i];
+                    edge.endVertex = face[(i + 1) % size];
+                    edge.nextEdge = first + (i + 1) % size;
+                    edge.prevEdge = first + (i + size - 1) % size;
+                    edge.mirrorEdge = Edge::none;
+                    edgesMap[key(edge.startVertex, edge.endVertex)] = first + i;
+                    geometry->vertexEdges[edge.startVertex] = first + i;
+                }
+                first += size;
+            }
+            for (auto& edge : geometry->edges)
+            {
+                auto iter = edgesMap.find(key(edge.endVertex, edge.startVertex));
+                if (iter != edgesMap.end())
+                {
+                    edge.mirrorEdge = iter->second;
+                }
+            }
+        });
+}
+
+void Shape::requireFaceTree() const
+{
+    geometry->faceTreeReady.call([&]()
+        {
+            requireVertices();
+            geometry->faceTree.build(geometry->vertices, geometry->faces);
+        });
 }
 
 // Helper for requireNoemal and requireTransformedNormal
@@ -334,7 +964,7 @@ Normal faceNormal(const Face& face, const Vertices & vertices)
 {
     assert(face.size() > 2); // degenerative face, no normal
     Vertex s0;
-    Vertex s1 = vertices.at(face[face.size() - 2]) - vertices.at(face[face.size() - 1]);
+    Vertex s1 = vertices.at(face[face.size() - 1]) - vertices.at(face[face.size() - 2]);
     Normal n;
     for (Index i = 0, j = face.size() - 1; i < face.size(); j = i, ++i)
     {
@@ -347,27 +977,28 @@ Normal faceNormal(const Face& face, const Vertices & vertices)
 
 void Shape::requireNormals() const
 {
-    if (normals.empty())
-    {
-        normals.reserve(faces.size());
-        for (const auto& face : faces)
+    geometry->normalsReady.call([&]()
         {
-            normals.emplace_back(faceNormal(face, vertices));
-        }
-    }
+            requireVertices();
+            geometry->normals.reserve(geometry->faces.size());
+            for (const auto& face : geometry->faces)
+            {
+                geometry->normals.emplace_back(faceNormal(face, geometry->vertices));
+            }
+        });
 }
 
 void Shape::requireTransformedNormals() const
 {
-    if (transformedNormals.empty())
-    {
-        requireTransformedVertices();
-        transformedNormals.reserve(faces.size());
-        for (const auto& face : faces)
+    transformedNormalsReady.call([&]()
         {
-            transformedNormals.emplace_back(faceNormal(face, transformedVertices));
-        }
-    }
+            requireTransformedVertices();
+            transformedNormals.reserve(geometry->faces.size());
+            for (const auto& face : geometry->faces)
+            {
+                transformedNormals.emplace_back(faceNormal(face, transformedVertices));
+            }
+        });
 }
 
 void Shape::requireSurfaceAreas() const
@@ -377,30 +1008,63 @@ void Shape::requireSurfaceAreas() const
         assert(face.size() > 2); // degenerative face, no surface area
         Vertex area(0, 0, 0);
         Vertex s0;
-        const Vertex& v0 = vertices.at(face[0]);
-        Vertex s1 = vertices.at(face[1]) - v0;
+        const Vertex& v0 = geometry->vertices.at(face[0]);
+        Vertex s1 = geometry->vertices.at(face[1]) - v0;
         for (Index i = 2; i < face.size(); ++i)
         {
             s0 = s1;
-            s1 = vertices.at(face[i]) - v0;
+            s1 = geometry->vertices.at(face[i]) - v0;
             area += s0.crossProduct(s1);
         }
         return area.length() / 2;
     };
-    if (surfaceAreas.empty())
-    {
-        surfaceAreas.reserve(faces.size());
-        for (const auto& face : faces)
+    geometry->surfaceAreasReady.call([&]()
         {
-            surfaceAreas.emplace_back(faceSurfaceArea(face));
-        }
-    }
+            requireVertices();
+            geometry->surfaceAreas.reserve(geometry->faces.size());
+            for (const auto& face : geometry->faces)
+            {
+                geometry->surfaceAreas.emplace_back(faceSurfaceArea(face));
+            }
+        });
 }
 
 void Shape::requireTransformedVertices() const
 {
-    if (transformedVertices.empty())
-    {
-        transformedVertices = transformation * vertices;
-    }
+    transformedVerticesReady.call([&]()
+        {
+            // compact vertices are converted and transformed in one pass
+            if (!geometry->quantized.empty())
+            {
+                transformedVertices = geometry->quantized.decode(transformation);
+            }
+            else if (!geometry->singleVertices.empty())
+            {
+                transformedVertices.clear();
+                transformedVertices.reserve(geometry->singleVertices.size());
+                for (const auto& vertex : geometry->singleVertices)
+                {
+                    transformedVertices.emplace_back(transformation * Vertex(vertex));
+                }
+            }
+            else
+            {
+                transformedVertices = transformation * geometry->vertices;
+            }
+        });
+}
+
+void Shape::requireVertices() const
+{
+    geometry->verticesReady.call([&]()
+        {
+            if (!geometry->singleVertices.empty())
+            {
+                geometry->vertices = ConvertVertices<Vertex>(geometry->singleVertices);
+            }
+            else
+            {
+                geometry->vertices = geometry->quantized.decode();
+            }
+        });
 }
@@ -0,0 +1,673 @@
+﻿#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "internal/generic/Parallel.h"
+#include "internal/geometry/FaceTree.h"
+#include "internal/geometry/ShapeFactory.h"
+
+//
+// Boolean operations on closed shapes, in four stages:
+// - find the intersection segments of the overlapping triangle pairs, with a
+//   face tree over the second shape (in parallel over the first shape)
+// - split every triangle along the lines through its segments, so no piece
+//   crosses the surface of the other shape
+// - keep the pieces inside or outside of the other shape, tested at the
+//   piece centers. Pieces in a face of the other shape are kept once or
+//   dropped, depending on the direction of the two faces
+// - weld the pieces and repair the T-junctions left by the splits, by adding
+//   the points on an edge to the faces on the other side
+//
+namespace
+{
+    enum class Operation
+    {
+        Union,
+        Intersection,
+        Difference,
+    };
+
+    typedef std::vector<Vertex> Polygon;
+
+    struct Segment
+    {
+        Vertex start;
+        Vertex end;
+    };
+
+    // Shape in world space, split in triangles
+    struct Mesh
+    {
+        Vertices vertices;
+        std::vector<std::array<Index, 3>> triangles;
+        // unit normals, zero for degenerate triangles
+        Vertices normals;
+        // the triangles as faces, for the face tree
+        Faces faces;
+
+        Mesh(const Shape& shape)
+            : vertices(shape.getTransformedVertices())
+        {
+            for (const auto& face : shape.getRawFaces())
+            {
+                for (Index i = 1; i + 1 < face.size(); ++i)
+                {
+                    triangles.push_back({ face[0], face[i], face[i + 1] });
+                }
+            }
+            normals.reserve(triangles.size());
+            faces.reserve(triangles.size());
+            for (const auto& triangle : triangles)
+            {
+                Vertex normal = (vertices[triangle[1]] - vertices[triangle[0]]).crossProduct(vertices[triangle[2]] - vertices[triangle[0]]);
+                const Scalar length = normal.length();
+                normals.emplace_back(length > 0 ? normal / length : Vertex(0, 0, 0));
+                faces.emplace_back(triangle.data(), (Index)3);
+            }
+        }
+
+        std::array<Vertex, 3> corners(const size_t& triangle) const
+        {
+            const auto& t = triangles[triangle];
+            return { vertices[t[0]], vertices[t[1]], vertices[t[2]] };
+        }
+    };
+
+    // The part of the triangle in the plane (normal, offset).
+    // False when the triangle is on one side of the plane, touches it, or lies in it.
+    bool PlaneCrossing(const std::array<Vertex, 3>& t, const Vertex& normal, const Scalar& offset, const Scalar& epsilon, Vertex& start, Vertex& end)
+    {
+        Scalar d[3];
+        size_t above = 0, below = 0;
+        for (size_t i = 0; i < 3; ++i)
+        {
+            d[i] = normal.innerProduct(t[i]) - offset;
+            if (d[i] > epsilon) ++above;
+            else if (d[i] < -epsilon) ++below;
+            else d[i] = 0;
+        }
+        if (above == 3 || below == 3 || above + below == 0)
+        {
+            return false;
+        }
+        Vertex found[3];
+        size_t count = 0;
+        for (size_t i = 0; i < 3 && count < 3; ++i)
+        {
+            const size_t j = (i + 1) % 3;
+            if (d[i] == 0)
+            {
+                found[count++] = t[i];
+            }
+            else if (d[i] * d[j] < 0)
+            {
+                found[count++] = t[i] + (t[j] - t[i]) * (d[i] / (d[i] - d[j]));
+            }
+        }
+        if (count < 2)
+        {
+            return false;
+        }
+        start = found[0];
+        end = found[1];
+        return true;
+    }
+
+    // Intersection segment of two triangles, false if they don't cross
+    bool Intersect(const std::array<Vertex, 3>& a, const Vertex& normalA, const std::array<Vertex, 3>& b, const Vertex& normalB, const Scalar& epsilon, Segment& segment)
+    {
+        Vertex startA, endA, startB, endB;
+        if (!PlaneCrossing(a, normalB, normalB.innerProduct(b[0]), epsilon, startA, endA) ||
+            !PlaneCrossing(b, normalA, normalA.innerProduct(a[0]), epsilon, startB, endB))
+        {
+            return false;
+        }
+        // both parts are on the line where the planes meet, overlap them
+        const Vertex direction = normalA.crossProduct(normalB);
+        Scalar a0 = direction.innerProduct(startA), a1 = direction.innerProduct(endA);
+        Scalar b0 = direction.innerProduct(startB), b1 = direction.innerProduct(endB);
+        if (a0 > a1)
+        {
+            std::swap(a0, a1);
+            std::swap(startA, endA);
+        }
+        if (b0 > b1)
+        {
+            std::swap(b0, b1);
+        }
+        const Scalar low = std::max(a0, b0);
+        const Scalar high = std::min(a1, b1);
+        if (high - low <= epsilon * direction.length())
+        {
+            return false;
+        }
+        auto at = [&](const Scalar& t)
+        {
+            return startA + (endA - startA) * ((t - a0) / (a1 - a0));
+        };
+        segment = { at(low), at(high) };
+        return true;
+    }
+
+    // True if both triangles lie in the same plane
+    bool Coplanar(const std::array<Vertex, 3>& a, const Vertex& normalA, const std::array<Vertex, 3>& b, const Vertex& normalB, const Scalar& epsilon)
+    {
+        if (normalA.innerProduct(normalA) == 0 || normalB.innerProduct(normalB) == 0)
+        {
+            return false;
+        }
+        for (size_t i = 0; i < 3; ++i)
+        {
+            if (std::abs(normalB.innerProduct(a[i] - b[0])) > epsilon ||
+                std::abs(normalA.innerProduct(b[i] - a[0])) > epsilon)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // True if point, in the plane of triangle t, is inside t or within epsilon of it
+    bool InTriangle(const Vertex& point, const std::array<Vertex, 3>& t, const Vertex& normal, const Scalar& epsilon)
+    {
+        for (size_t k = 0; k < 3; ++k)
+        {
+            const Vertex edge = t[(k + 1) % 3] - t[k];
+            if (normal.crossProduct(edge).innerProduct(point - t[k]) < -epsilon * edge.length())
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // The part of segment inside triangle t, both in the plane of t.
+    // False if there is no such part or only a point.
+    bool ClipToTriangle(const Segment& segment, const std::array<Vertex, 3>& t, const Vertex& normal, const Scalar& epsilon, Segment& clipped)
+    {
+        const Vertex direction = segment.end - segment.start;
+        Scalar low = 0;
+        Scalar high = 1;
+        for (size_t k = 0; k < 3; ++k)
+        {
+            Vertex inward = normal.crossProduct(t[(k + 1) % 3] - t[k]);
+            const Scalar length = inward.length();
+            if (length == 0)
+            {
+                return false;
+            }
+            inward /= length;
+            // distance to the edge, positive inside, is start + rate * s at s
+            const Scalar start = inward.innerProduct(segment.start - t[k]) + epsilon;
+            const Scalar rate = inward.innerProduct(direction);
+            if (rate == 0)
+            {
+                if (start < 0)
+                {
+                    return false;
+                }
+            }
+            else if (rate > 0)
+            {
+                low = std::max(low, -start / rate);
+            }
+            else
+            {
+                high = std::min(high, -start / rate);
+            }
+        }
+        if ((high - low) * direction.length() <= epsilon)
+        {
+            return false;
+        }
+        clipped = { segment.start + direction * low, segment.start + direction * high };
+        return true;
+    }
+
+    // Split convex pieces of a triangle by the plane through segment, perpendicular to the triangle
+    void Split(std::vector<Polygon>& pieces, const Vertex& normal, const Segment& segment, const Scalar& epsilon)
+    {
+        Vertex cut = normal.crossProduct(segment.end - segment.start);
+        const Scalar length = cut.length();
+        if (length == 0)
+        {
+            return;
+        }
+        cut /= length;
+        const Scalar offset = cut.innerProduct(segment.start);
+        std::vector<Scalar> d;
+        const size_t count = pieces.size();
+        for (size_t i = 0; i < count; ++i)
+        {
+            const Polygon& piece = pieces[i];
+            const size_t n = piece.size();
+            d.resize(n);
+            bool above = false, below = false;
+            for (size_t k = 0; k < n; ++k)
+            {
+                d[k] = cut.innerProduct(piece[k]) - offset;
+                if (d[k] > epsilon) above = true;
+                else if (d[k] < -epsilon) below = true;
+                else d[k] = 0;
+            }
+            if (!above || !below)
+            {
+                continue;
+            }
+            Polygon front, back;
+            for (size_t k = 0; k < n; ++k)
+            {
+                const size_t j = (k + 1) % n;
+                if (d[k] >= 0) front.push_back(piece[k]);
+                if (d[k] <= 0) back.push_back(piece[k]);
+                if (d[k] * d[j] < 0)
+                {
+                    const Vertex crossing = piece[k] + (piece[j] - piece[k]) * (d[k] / (d[k] - d[j]));
+                    front.push_back(crossing);
+                    back.push_back(crossing);
+                }
+            }
+            pieces[i].swap(front);
+            pieces.emplace_back(std::move(back));
+        }
+    }
+
+    // Merges points within tolerance (per coordinate) with a uniform grid, see Shape::weld
+    class Welder
+    {
+    public:
+        Welder(const Scalar& tolerance)
+            : tolerance(tolerance)
+        {}
+
+        uint32_t add(const Vertex& vertex)
+        {
+            const int64_t x = (int64_t)std::floor(vertex.x / tolerance);
+            const int64_t y = (int64_t)std::floor(vertex.y / tolerance);
+            const int64_t z = (int64_t)std::floor(vertex.z / tolerance);
+            for (int64_t dx = -1; dx <= 1; ++dx)
+            {
+                for (int64_t dy = -1; dy <= 1; ++dy)
+                {
+                    for (int64_t dz = -1; dz <= 1; ++dz)
+                    {
+                        auto iter = cells.find(hash(x + dx, y + dy, z + dz));
+                        for (uint32_t i = (iter == cells.end() ? none : iter->second); i != none; i = next[i])
+                        {
+                            const Vertex& other = vertices[i];
+                            if (std::abs(other.x - vertex.x) <= tolerance &&
+                                std::abs(other.y - vertex.y) <= tolerance &&
+                                std::abs(other.z - vertex.z) <= tolerance)
+                            {
+                                return i;
+                            }
+                        }
+                    }
+                }
+            }
+            const uint32_t index = (uint32_t)vertices.size();
+            vertices.push_back(vertex);
+            auto inserted = cells.emplace(hash(x, y, z), index);
+            next.push_back(inserted.second ? none : inserted.first->second);
+            inserted.first->second = index;
+            return index;
+        }
+
+        Vertices vertices;
+    private:
+        static constexpr uint32_t none = std::numeric_limits<uint32_t>::max();
+
+        static uint64_t hash(const int64_t x, const int64_t y, const int64_t z)
+        {
+            return (uint64_t)x * 73856093u ^ (uint64_t)y * 19349663u ^ (uint64_t)z * 83492791u;
+        }
+
+        Scalar tolerance;
+        // last vertex added per cell hash, chained through next
+        std::unordered_map<uint64_t, uint32_t> cells;
+        std::vector<uint32_t> next;
+    };
+
+    // Edges without a counterpart in the opposite direction end at a vertex
+    // which lies on the edge on the other side. Add those vertices to the
+    // faces, so every edge has a mirror again.
+    void RepairTJunctions(const Vertices& vertices, std::vector<std::vector<uint32_t>>& polygons, const Scalar& tolerance)
+    {
+        auto key = [](const uint32_t a, const uint32_t b)
+        {
+            return ((uint64_t)a << 32) | b;
+        };
+        std::unordered_set<uint64_t> edges;
+        for (const auto& polygon : polygons)
+        {
+            for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++)
+            {
+                edges.insert(key(polygon[j], polygon[i]));
+            }
+        }
+        struct OpenEdge
+        {
+            uint32_t polygon;
+            uint32_t corner;
+        };
+        std::vector<OpenEdge> open;
+        std::vector<uint32_t> candidates;
+        std::vector<bool> isCandidate(vertices.size(), false);
+        for (uint32_t p = 0; p < polygons.size(); ++p)
+        {
+            const auto& polygon = polygons[p];
+            for (uint32_t i = 0; i < polygon.size(); ++i)
+            {
+                const uint32_t a = polygon[i];
+                const uint32_t b = polygon[(i + 1) % polygon.size()];
+                if (edges.count(key(b, a)) == 0)
+                {
+                    open.push_back({ p, i });
+                    for (const auto& v : { a, b })
+                    {
+                        if (!isCandidate[v])
+                        {
+                            isCandidate[v] = true;
+                            candidates.push_back(v);
+                        }
+                    }
+                }
+            }
+        }
+        if (open.empty())
+        {
+            return;
+        }
+        // candidates sorted on x, each edge only looks at its own x range
+        std::sort(candidates.begin(), candidates.end(), [&](const uint32_t a, const uint32_t b) { return vertices[a].x < vertices[b].x; });
+        struct Insertion
+        {
+            uint32_t corner;
+            Scalar t;
+            uint32_t vertex;
+            bool operator < (const Insertion& other) const
+            {
+                return corner < other.corner || (corner == other.corner && t < other.t);
+            }
+        };
+        std::unordered_map<uint32_t, std::vector<Insertion>> insertions;
+        for (const auto& edge : open)
+        {
+            const auto& polygon = polygons[edge.polygon];
+            const uint32_t a = polygon[edge.corner];
+            const uint32_t b = polygon[(edge.corner + 1) % polygon.size()];
+            const Vertex& va = vertices[a];
+            const Vertex ab = vertices[b] - va;
+            const Scalar length2 = ab.innerProduct(ab);
+            if (length2 == 0)
+            {
+                continue;
+            }
+            const Scalar minX = std::min(va.x, vertices[b].x) - tolerance;
+            const Scalar maxX = std::max(va.x, vertices[b].x) + tolerance;
+            auto first = std::lower_bound(candidates.begin(), candidates.end(), minX, [&](const uint32_t v, const Scalar& x) { return vertices[v].x < x; });
+            for (auto iter = first; iter != candidates.end() && vertices[*iter].x <= maxX; ++iter)
+            {
+                const uint32_t c = *iter;
+                if (c == a || c == b)
+                {
+                    continue;
+                }
+                const Scalar t = (vertices[c] - va).innerProduct(ab) / length2;
+                if (t <= 0 || t >= 1)
+                {
+                    continue;
+                }
+                if ((va + ab * t - vertices[c]).length() <= tolerance)
+                {
+                    insertions[edge.polygon].push_back({ edge.corner, t, c });
+                }
+            }
+        }
+        for (auto& entry : insertions)
+        {
+            auto& polygon = polygons[entry.first];
+            auto& inserted = entry.second;
+            std::sort(inserted.begin(), inserted.end());
+            std::vector<uint32_t> repaired;
+            repaired.reserve(polygon.size() + inserted.size());
+            auto iter = inserted.begin();
+            for (uint32_t i = 0; i < polygon.size(); ++i)
+            {
+                repaired.push_back(polygon[i]);
+                for (; iter != inserted.end() && iter->corner == i; ++iter)
+                {
+                    repaired.push_back(iter->vertex);
+                }
+            }
+            polygon.swap(repaired);
+        }
+    }
+
+    Shape Boolean(const Shape& a, const Shape& b, const Operation operation)
+    {
+        const Mesh meshes[2] = { Mesh(a), Mesh(b) };
+        Scalar extent = 1;
+        for (const auto& mesh : meshes)
+        {
+            for (const auto& vertex : mesh.vertices)
+            {
+                extent = std::max({ extent, std::abs(vertex.x), std::abs(vertex.y), std::abs(vertex.z) });
+            }
+        }
+        const Scalar epsilon = extent * 1e-10;
+        const Scalar tolerance = extent * 1e-9;
+
+        // intersection segments of all triangle pairs
+        FaceTree tree;
+        tree.build(meshes[1].vertices, meshes[1].faces);
+        const size_t countA = meshes[0].triangles.size();
+        // a segment which splits triangle i of a, triangle other of b or both
+        struct Crossing
+        {
+            uint32_t other;
+            Segment segment;
+            bool splitsA;
+            bool splitsB;
+        };
+        std::vector<std::vector<Crossing>> crossings(countA);
+        // triangles of the other shape in the same plane, per triangle
+        std::vector<std::vector<uint32_t>> coplanar[2];
+        coplanar[0].resize(countA);
+        coplanar[1].resize(meshes[1].triangles.size());
+        Parallel::ForRanges(countA, [&](const size_t begin, const size_t end)
+            {
+                std::vector<uint32_t> found;
+                for (size_t i = begin; i < end; ++i)
+                {
+                    const auto corners = meshes[0].corners(i);
+                    Vertex min = corners[0], max = corners[0];
+                    for (const auto& corner : corners)
+                    {
+                        for (size_t axis = 0; axis < 3; ++axis)
+                        {
+                            min[axis] = std::min(min[axis], corner[axis] - epsilon);
+                            max[axis] = std::max(max[axis], corner[axis] + epsilon);
+                        }
+                    }
+                    tree.overlapping(min, max, found);
+                    for (const auto& other : found)
+                    {
+                        const auto otherCorners = meshes[1].corners(other);
+                        const Vertex& normal = meshes[0].normals[i];
+                        const Vertex& otherNormal = meshes[1].normals[other];
+                        Segment segment;
+                        if (Coplanar(corners, normal, otherCorners, otherNormal, epsilon))
+                        {
+                            // split each triangle along the edges of the other one
+                            coplanar[0][i].push_back(other);
+                            for (size_t k = 0; k < 3; ++k)
+                            {
+                                if (ClipToTriangle({ otherCorners[k], otherCorners[(k + 1) % 3] }, corners, normal, epsilon, segment))
+                                {
+                                    crossings[i].push_back({ other, segment, true, false });
+                                }
+                                if (ClipToTriangle({ corners[k], corners[(k + 1) % 3] }, otherCorners, otherNormal, epsilon, segment))
+                                {
+                                    crossings[i].push_back({ other, segment, false, true });
+                                }
+                            }
+                        }
+                        else if (Intersect(corners, normal, otherCorners, otherNormal, epsilon, segment))
+                        {
+                            crossings[i].push_back({ other, segment, true, true });
+                        }
+                    }
+                }
+            }, 64);
+        std::vector<std::vector<Segment>> segments[2];
+        segments[0].resize(countA);
+        segments[1].resize(meshes[1].triangles.size());
+        for (uint32_t i = 0; i < countA; ++i)
+        {
+            for (const auto& crossing : crossings[i])
+            {
+                if (crossing.splitsA)
+                {
+                    segments[0][i].push_back(crossing.segment);
+                }
+                if (crossing.splitsB)
+                {
+                    segments[1][crossing.other].push_back(crossing.segment);
+                }
+            }
+            for (const auto& other : coplanar[0][i])
+            {
+                coplanar[1][other].push_back(i);
+            }
+        }
+        crossings.clear();
+
+        // split the triangles, classify and keep the pieces
+        Welder welder(tolerance);
+        std::vector<std::vector<uint32_t>> polygons;
+        for (size_t m = 0; m < 2; ++m)
+        {
+            const Mesh& mesh = meshes[m];
+            const Mesh& otherMesh = meshes[1 - m];
+            const Shape& other = m == 0 ? b : a;
+            std::vector<std::vector<Polygon>> split(mesh.triangles.size());
+            Parallel::For(mesh.triangles.size(), [&](const size_t i)
+                {
+                    const auto corners = mesh.corners(i);
+                    split[i].emplace_back(corners.begin(), corners.end());
+                    for (const auto& segment : segments[m][i])
+                    {
+                        Split(split[i], mesh.normals[i], segment, epsilon);
+                    }
+                }, 64);
+            std::vector<Polygon> pieces;
+            std::vector<uint32_t> sources;
+            for (uint32_t i = 0; i < split.size(); ++i)
+            {
+                for (auto& piece : split[i])
+                {
+                    pieces.emplace_back(std::move(piece));
+                    sources.push_back(i);
+                }
+            }
+            split.clear();
+            Vertices centers;
+            centers.reserve(pieces.size());
+            for (const auto& piece : pieces)
+            {
+                Vertex center;
+                for (const auto& corner : piece)
+                {
+                    center += corner;
+                }
+                centers.emplace_back(center / (Scalar)piece.size());
+            }
+            std::vector<bool> inside;
+            other.contains(centers, inside);
+            // pieces in a face of the other shape, 1 if the faces point the same way, -1 if not
+            std::vector<int8_t> onFace(pieces.size(), 0);
+            Parallel::For(pieces.size(), [&](const size_t i)
+                {
+                    for (const auto& face : coplanar[m][sources[i]])
+                    {
+                        if (InTriangle(centers[i], otherMesh.corners(face), otherMesh.normals[face], epsilon))
+                        {
+                            onFace[i] = mesh.normals[sources[i]].innerProduct(otherMesh.normals[face]) > 0 ? 1 : -1;
+                            break;
+                        }
+                    }
+                }, 256);
+            // union: both outsides, intersection: both insides,
+            // difference: outside of a and the inside of b turned inside out
+            const bool keepInside = operation == Operation::Intersection || (operation == Operation::Difference && m == 1);
+            const bool reverse = operation == Operation::Difference && m == 1;
+            // shared faces are kept once (from a) when both shapes are on the
+            // same side (union, intersection) or on opposite sides (difference)
+            const int8_t keepOnFace = operation == Operation::Difference ? -1 : 1;
+            for (size_t i = 0; i < pieces.size(); ++i)
+            {
+                if (onFace[i] != 0 ? (m == 1 || onFace[i] != keepOnFace) : inside[i] != keepInside)
+                {
+                    continue;
+                }
+                std::vector<uint32_t> polygon;
+                for (const auto& corner : pieces[i])
+                {
+                    const uint32_t index = welder.add(corner);
+                    if (polygon.empty() || polygon.back() != index)
+                    {
+                        polygon.push_back(index);
+                    }
+                }
+                while (polygon.size() > 1 && polygon.front() == polygon.back())
+                {
+                    polygon.pop_back();
+                }
+                if (polygon.size() > 2)
+                {
+                    if (reverse)
+                    {
+                        std::reverse(polygon.begin(), polygon.end());
+                    }
+                    polygons.emplace_back(std::move(polygon));
+                }
+            }
+        }
+        RepairTJunctions(welder.vertices, polygons, tolerance);
+
+        if (welder.vertices.size() > std::numeric_limits<Index>::max())
+        {
+            throw std::length_error("too many vertices in the result of the boolean operation");
+        }
+        Faces faces;
+        faces.reserve(polygons.size());
+        std::vector<Index> points;
+        for (const auto& polygon : polygons)
+        {
+            points.assign(polygon.begin(), polygon.end());
+            faces.emplace_back(points.data(), (Index)points.size());
+        }
+        return Shape(std::move(welder.vertices), std::move(faces));
+    }
+}
+
+Shape ShapeFactory::Union(const Shape& a, const Shape& b)
+{
+    return Boolean(a, b, Operation::Union);
+}
+
+Shape ShapeFactory::Intersection(const Shape& a, const Shape& b)
+{
+    return Boolean(a, b, Operation::Intersection);
+}
+
+Shape ShapeFactory::Difference(const Shape& a, const Shape& b)
+{
+    return Boolean(a, b, Operation::Difference);
+}
@@ -0,0 +1,723 @@
+﻿#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#include "internal/geometry/ShapeCodec.h"
+
+namespace
+{
+    constexpr uint8_t magic[4] = { 'S', 'H', 'P', 'C' };
+    constexpr uint8_t version = 1;
+    constexpr size_t headerSize = sizeof(magic) + 2 + 2 * 4 + 6 * 8;
+    constexpr uint32_t none = std::numeric_limits<uint32_t>::max();
+
+    // Probability of a 0 bit in 1/2048, adapted after every bit
+    typedef uint16_t Probability;
+    constexpr uint32_t probabilityBits = 11;
+    constexpr Probability probabilityInit = 1 << (probabilityBits - 1);
+    constexpr uint32_t adaptShift = 5;
+    constexpr uint32_t topValue = 1 << 24;
+
+    template<size_t BITS>
+    struct BitTreeModel
+    {
+        Probability probabilities[1 << BITS];
+        BitTreeModel()
+        {
+            std::fill(std::begin(probabilities), std::end(probabilities), probabilityInit);
+        }
+    };
+
+    // Values v coded as the bit length of v+1 (adaptive), then the bits below
+    // the leading one (direct). Small values take few bits, v < 2^31.
+    typedef BitTreeModel<5> ExpGolombModel;
+
+    class RangeEncoder
+    {
+    public:
+        RangeEncoder(std::vector<uint8_t>& data)
+            : data(data)
+        {}
+
+        void encode(Probability& probability, const bool bit)
+        {
+            const uint32_t bound = (range >> probabilityBits) * probability;
+            if (!bit)
+            {
+                range = bound;
+                probability += ((1 << probabilityBits) - probability) >> adaptShift;
+            }
+            else
+            {
+                low += bound;
+                range -= bound;
+                probability -= probability >> adaptShift;
+            }
+            normalize();
+        }
+
+        // Up to 8 bits per step, the range stays above 2^16
+        void encodeDirect(const uint32_t value, uint32_t bits)
+        {
+            while (bits > 0)
+            {
+                const uint32_t count = std::min<uint32_t>(bits, 8);
+                bits -= count;
+                range >>= count;
+                low += (uint64_t)((value >> bits) & ((1u << count) - 1)) * range;
+                normalize();
+            }
+        }
+
+        template<size_t BITS>
+        void encode(BitTreeModel<BITS>& model, const uint32_t value)
+        {
+            uint32_t node = 1;
+            for (size_t i = BITS; i-- > 0;)
+            {
+                const bool bit = (value >> i) & 1;
+                encode(model.probabilities[node], bit);
+                node = (node << 1) | (uint32_t)bit;
+            }
+        }
+
+        void encodeExpGolomb(ExpGolombModel& model, const uint32_t value)
+        {
+            assert(value < (1u << 31));
+            const uint32_t v = value + 1;
+            uint32_t length = 0;
+            while ((v >> (length + 1)) != 0)
+            {
+                ++length;
+            }
+            encode(model, length);
+            encodeDirect(v & ((1u << length) - 1), length);
+        }
+
+        void flush()
+        {
+            for (size_t i = 0; i < 5; ++i)
+            {
+                shiftLow();
+            }
+        }
+
+    private:
+        void normalize()
+        {
+            while (range < topValue)
+            {
+                range <<= 8;
+                shiftLow();
+            }
+        }
+
+        // Bytes are held back while a carry can still change them
+        void shiftLow()
+        {
+            if ((uint32_t)low < 0xFF000000u || (low >> 32) != 0)
+            {
+                const uint8_t carry = (uint8_t)(low >> 32);
+                uint8_t byte = cache;
+                do
+                {
+                    data.push_back((uint8_t)(byte + carry));
+                    byte = 0xFF;
+                } while (--cacheSize != 0);
+                cache = (uint8_t)(low >> 24);
+            }
+            ++cacheSize;
+            low = (low & 0x00FFFFFF) << 8;
+        }
+
+        std::vector<uint8_t>& data;
+        uint64_t low = 0;
+        uint32_t range = 0xFFFFFFFF;
+        uint8_t cache = 0;
+        uint64_t cacheSize = 1;
+    };
+
+    class RangeDecoder
+    {
+    public:
+        RangeDecoder(const uint8_t* begin, const uint8_t* end)
+            : position(begin)
+            , end(end)
+        {
+            for (size_t i = 0; i < 5; ++i)
+            {
+                code = (code << 8) | next();
+            }
+        }
+
+        bool decode(Probability& probability)
+        {
+            const uint32_t bound = (range >> probabilityBits) * probability;
+            bool bit;
+            if (code < bound)
+            {
+                range = bound;
+                probability += ((1 << probabilityBits) - probability) >> adaptShift;
+                bit = false;
+            }
+            else
+            {
+                code -= bound;
+                range -= bound;
+                probability -= probability >> adaptShift;
+                bit = true;
+            }
+            normalize();
+            return bit;
+        }
+
+        uint32_t decodeDirect(uint32_t bits)
+        {
+            uint32_t value = 0;
+            while (bits > 0)
+            {
+                const uint32_t count = std::min<uint32_t>(bits, 8);
+                bits -= count;
+                range >>= count;
+                const uint32_t part = code / range;
+                if (part >> count)
+                {
+                    throw std::invalid_argument("invalid shape data");
+                }
+                code -= part * range;
+                value = (value << count) | part;
+                normalize();
+            }
+            return value;
+        }
+
+        template<size_t BITS>
+        uint32_t decode(BitTreeModel<BITS>& model)
+        {
+            uint32_t node = 1;
+            for (size_t i = 0; i < BITS; ++i)
+            {
+                node = (node << 1) | (uint32_t)decode(model.probabilities[node]);
+            }
+            return node - (1 << BITS);
+        }
+
+        uint32_t decodeExpGolomb(ExpGolombModel& model)
+        {
+            const uint32_t length = decode(model);
+            return ((1u << length) | decodeDirect(length)) - 1;
+        }
+
+    private:
+        void normalize()
+        {
+            while (range < topValue)
+            {
+                range <<= 8;
+                code = (code << 8) | next();
+            }
+        }
+
+        // Past the end zeros are read, a few of those are part of the flushed tail
+        uint8_t next()
+        {
+            if (position < end)
+            {
+                return *position++;
+            }
+            if (++overrun > 8)
+            {
+                throw std::invalid_argument("shape data is truncated");
+            }
+            return 0;
+        }
+
+        const uint8_t* position;
+        const uint8_t* end;
+        size_t overrun = 0;
+        uint32_t range = 0xFFFFFFFF;
+        uint32_t code = 0;
+    };
+
+    // Edges of the coded faces whose mirror edge wasn't seen yet, stored at
+    // their end vertex (newest first, the oldest is dropped when full).
+    // The next corner after p is likely the start of an open edge ending at p.
+    class OpenEdges
+    {
+    public:
+        static constexpr uint32_t capacity = 8;
+
+        struct Edge
+        {
+            uint32_t start;
+            // the corner after the end vertex in the face of the edge
+            uint32_t opposite;
+        };
+
+        OpenEdges(const size_t vertexCount)
+            : edges(vertexCount * capacity)
+            , counts(vertexCount, 0)
+        {}
+
+        int find(const uint32_t end, const uint32_t start) const
+        {
+            const Edge* list = &edges[end * capacity];
+            for (uint32_t i = 0; i < counts[end]; ++i)
+            {
+                if (list[i].start == start)
+                {
+                    return (int)i;
+                }
+            }
+            return -1;
+        }
+
+        uint32_t count(const uint32_t end) const
+        {
+            return counts[end];
+        }
+
+        const Edge& get(const uint32_t end, const uint32_t index) const
+        {
+            return edges[end * capacity + index];
+        }
+
+        void add(const uint32_t end, const uint32_t start, const uint32_t opposite)
+        {
+            Edge* list = &edges[end * capacity];
+            const uint32_t count = std::min<uint32_t>(counts[end], capacity - 1);
+            std::copy_backward(list, list + count, list + count + 1);
+            list[0] = { start, opposite };
+            counts[end] = (uint8_t)(count + 1);
+        }
+
+        void remove(const uint32_t end, const uint32_t index)
+        {
+            Edge* list = &edges[end * capacity];
+            std::copy(list + index + 1, list + counts[end], list + index);
+            --counts[end];
+        }
+
+    private:
+        std::vector<Edge> edges;
+        std::vector<uint8_t> counts;
+    };
+
+    // Recently used vertices, most recent first
+    class RecentVertices
+    {
+    public:
+        static constexpr uint32_t capacity = 16;
+
+        int find(const uint32_t vertex) const
+        {
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                if (vertices[i] == vertex)
+                {
+                    return (int)i;
+                }
+            }
+            return -1;
+        }
+
+        uint32_t get(const uint32_t index) const
+        {
+            return vertices[index];
+        }
+
+        void use(const uint32_t vertex)
+        {
+            const int index = find(vertex);
+            const uint32_t last = (index >= 0) ? (uint32_t)index : std::min(count, capacity - 1);
+            std::copy_backward(vertices, vertices + last, vertices + last + 1);
+            vertices[0] = vertex;
+            count = std::max(count, last + 1);
+        }
+
+        uint32_t size() const
+        {
+            return count;
+        }
+
+    private:
+        uint32_t vertices[capacity];
+        uint32_t count = 0;
+    };
+
+    enum Prediction
+    {
+        Parallelogram,
+        PreviousCorner,
+        PreviousVertex,
+        PredictionCount
+    };
+
+    // Everything the encoder and the decoder keep in sync
+    struct State
+    {
+        State(const size_t vertexCount, const uint32_t levels)
+            : open(vertexCount)
+            , coordinates(3 * vertexCount, 0)
+            , levels(levels)
+        {}
+
+        OpenEdges open;
+        RecentVertices recent;
+        // quantized coordinates, in order of first use
+        std::vector<uint32_t> coordinates;
+        uint32_t levels;
+        // number of vertices seen so far
+        uint32_t vertexCount = 0;
+
+        Probability sameSize = probabilityInit;
+        ExpGolombModel size;
+        // [number of open edges - 1, at most 3]
+        Probability openHit[3] = { probabilityInit, probabilityInit, probabilityInit };
+        BitTreeModel<3> openIndex;
+        // [first corner of a face, other corners]
+        Probability isNew[2] = { probabilityInit, probabilityInit };
+        Probability recentHit[2] = { probabilityInit, probabilityInit };
+        BitTreeModel<4> recentIndex[2];
+        ExpGolombModel vertexDistance;
+        ExpGolombModel residual[PredictionCount][3];
+
+        // Predicted coordinates of a new vertex at corner index of the face
+        Prediction predict(const uint32_t* corners, const size_t index, int64_t (&prediction)[3]) const
+        {
+            if (index >= 2)
+            {
+                // across the edge q-p, onto the face which has the mirror edge
+                const uint32_t q = corners[index - 2];
+                const uint32_t p = corners[index - 1];
+                const int mirror = open.find(q, p);
+                if (mirror >= 0)
+                {
+                    const uint32_t o = open.get(q, (uint32_t)mirror).opposite;
+                    for (size_t i = 0; i < 3; ++i)
+                    {
+                        const int64_t value = (int64_t)coordinates[3 * q + i] + coordinates[3 * p + i] - coordinates[3 * o + i];
+                        prediction[i] = std::min<int64_t>(std::max<int64_t>(value, 0), levels);
+                    }
+                    return Parallelogram;
+                }
+            }
+            const uint32_t* from = (index >= 1) ? &coordinates[3 * corners[index - 1]] : (vertexCount > 0 ? &coordinates[3 * (vertexCount - 1)] : nullptr);
+            for (size_t i = 0; i < 3; ++i)
+            {
+                prediction[i] = from ? from[i] : levels / 2;
+            }
+            return (index >= 1) ? PreviousCorner : PreviousVertex;
+        }
+
+        // Open the edges of a coded face, or close them against their mirror
+        void finishFace(const uint32_t* corners, const size_t count)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                const uint32_t start = corners[i];
+                const uint32_t end = corners[(i + 1) % count];
+                const int mirror = open.find(start, end);
+                if (mirror >= 0)
+                {
+                    open.remove(start, (uint32_t)mirror);
+                }
+                else
+                {
+                    open.add(end, start, corners[(i + 2) % count]);
+                }
+            }
+        }
+    };
+
+    uint32_t ZigZag(const int64_t value)
+    {
+        return (uint32_t)(((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+    }
+
+    int64_t UnZigZag(const uint32_t value)
+    {
+        return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+    }
+
+    void Write32(std::vector<uint8_t>& data, const uint32_t value)
+    {
+        for (size_t i = 0; i < 4; ++i)
+        {
+            data.push_back((uint8_t)(value >> (8 * i)));
+        }
+    }
+
+    void WriteScalar(std::vector<uint8_t>& data, const double value)
+    {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        Write32(data, (uint32_t)bits);
+        Write32(data, (uint32_t)(bits >> 32));
+    }
+
+    uint32_t Read32(const uint8_t* data)
+    {
+        return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+    }
+
+    double ReadScalar(const uint8_t* data)
+    {
+        const uint64_t bits = (uint64_t)Read32(data) | ((uint64_t)Read32(data + 4) << 32);
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+}
+
+std::vector<uint8_t> ShapeCodec::Encode(const Shape& shape, const QuantizedVertices::Precision precision)
+{
+    const Faces& faces = shape.getRawFaces();
+    const QuantizedVertices quantized(shape.getVertices(), precision);
+    std::vector<bool> used(quantized.size(), false);
+    uint32_t usedCount = 0;
+    for (const auto& face : faces)
+    {
+        for (const auto point : face)
+        {
+            usedCount += used[point] ? 0 : 1;
+            used[point] = true;
+        }
+    }
+    // vertices are renumbered in order of first use
+    std::vector<uint32_t> ids(quantized.size(), none);
+
+    std::vector<uint8_t> data(std::begin(magic), std::end(magic));
+    data.push_back(version);
+    data.push_back((uint8_t)precision);
+    Write32(data, usedCount);
+    Write32(data, (uint32_t)faces.size());
+    for (size_t i = 0; i < 3; ++i)
+    {
+        WriteScalar(data, quantized.origin[i]);
+    }
+    for (size_t i = 0; i < 3; ++i)
+    {
+        WriteScalar(data, quantized.step[i]);
+    }
+
+    State state(usedCount, (uint32_t)((uint64_t(1) << (size_t)precision) - 1));
+    RangeEncoder encoder(data);
+    std::vector<uint32_t> corners;
+    size_t previousSize = 0;
+    for (const auto& face : faces)
+    {
+        const size_t size = face.size();
+        encoder.encode(state.sameSize, size != previousSize);
+        if (size != previousSize)
+        {
+            encoder.encodeExpGolomb(state.size, (uint32_t)size);
+        }
+        previousSize = size;
+        corners.resize(size);
+        for (size_t i = 0; i < size; ++i)
+        {
+            const Index point = face[i];
+            uint32_t id = ids[point];
+            const size_t first = (i == 0) ? 0 : 1;
+            // without open edges at the previous corner there's nothing to code,
+            // with one there's no index
+            const uint32_t openCount = (i > 0) ? state.open.count(corners[i - 1]) : 0;
+            if (openCount > 0)
+            {
+                const int open = (id == none) ? -1 : state.open.find(corners[i - 1], id);
+                encoder.encode(state.openHit[std::min<uint32_t>(openCount, 3) - 1], open >= 0);
+                if (open >= 0)
+                {
+                    if (openCount > 1)
+                    {
+                        encoder.encode(state.openIndex, (uint32_t)open);
+                    }
+                    corners[i] = id;
+                    state.recent.use(id);
+                    continue;
+                }
+            }
+            encoder.encode(state.isNew[first], id == none);
+            if (id == none)
+            {
+                id = ids[point] = state.vertexCount;
+                int64_t prediction[3];
+                const Prediction kind = state.predict(corners.data(), i, prediction);
+                uint32_t q[3];
+                quantized.coordinates(point, q);
+                for (size_t j = 0; j < 3; ++j)
+                {
+                    encoder.encodeExpGolomb(state.residual[kind][j], ZigZag((int64_t)q[j] - prediction[j]));
+                    state.coordinates[3 * id + j] = q[j];
+                }
+                ++state.vertexCount;
+            }
+            else
+            {
+                const int recent = state.recent.find(id);
+                encoder.encode(state.recentHit[first], recent >= 0);
+                if (recent >= 0)
+                {
+                    encoder.encode(state.recentIndex[first], (uint32_t)recent);
+                }
+                else
+                {
+                    encoder.encodeExpGolomb(state.vertexDistance, state.vertexCount - 1 - id);
+                }
+            }
+            corners[i] = id;
+            state.recent.use(id);
+        }
+        state.finishFace(corners.data(), size);
+    }
+    encoder.flush();
+    return data;
+}
+
+Shape ShapeCodec::Decode(const std::vector<uint8_t>& data)
+{
+    return Decode(data.data(), data.size());
+}
+
+Shape ShapeCodec::Decode(const uint8_t* data, const size_t size)
+{
+    if (size < headerSize || !std::equal(std::begin(magic), std::end(magic), data))
+    {
+        throw std::invalid_argument("not shape data");
+    }
+    if (data[4] != version)
+    {
+        throw std::invalid_argument("unsupported shape data version");
+    }
+    QuantizedVertices quantized;
+    if (data[5] == (uint8_t)QuantizedVertices::Precision::Bits16 || data[5] == (uint8_t)QuantizedVertices::Precision::Bits21)
+    {
+        quantized.precision = (QuantizedVertices::Precision)data[5];
+    }
+    else
+    {
+        throw std::invalid_argument("invalid shape data");
+    }
+    const uint32_t vertexCount = Read32(data + 6);
+    const uint32_t faceCount = Read32(data + 10);
+    // every face takes a few bits at least, so larger counts are corrupt data
+    // (and would take long to decode)
+    const uint64_t maxCount = (uint64_t)size * 8 * 64;
+    if (vertexCount > (uint32_t)std::numeric_limits<Index>::max() + 1 || faceCount > maxCount)
+    {
+        throw std::invalid_argument("invalid shape data");
+    }
+    for (size_t i = 0; i < 3; ++i)
+    {
+        quantized.origin[i] = ReadScalar(data + 14 + 8 * i);
+        quantized.step[i] = ReadScalar(data + 38 + 8 * i);
+        if (!std::isfinite(quantized.origin[i]) || !std::isfinite(quantized.step[i]) || quantized.step[i] < 0)
+        {
+            throw std::invalid_argument("invalid shape data");
+        }
+    }
+
+    State state(vertexCount, (uint32_t)((uint64_t(1) << (size_t)quantized.precision) - 1));
+    RangeDecoder decoder(data + headerSize, data + size);
+    Faces faces;
+    faces.reserve(faceCount);
+    std::vector<uint32_t> corners;
+    std::vector<Index> points;
+    uint64_t cornerCount = 0;
+    size_t faceSize = 0;
+    for (uint32_t f = 0; f < faceCount; ++f)
+    {
+        if (decoder.decode(state.sameSize))
+        {
+            faceSize = decoder.decodeExpGolomb(state.size);
+        }
+        cornerCount += faceSize;
+        if (faceSize == 0 || faceSize > std::numeric_limits<Index>::max() || cornerCount > maxCount)
+        {
+            throw std::invalid_argument("invalid shape data");
+        }
+        corners.resize(faceSize);
+        points.resize(faceSize);
+        for (size_t i = 0; i < faceSize; ++i)
+        {
+            const size_t first = (i == 0) ? 0 : 1;
+            uint32_t id;
+            const uint32_t openCount = (i > 0) ? state.open.count(corners[i - 1]) : 0;
+            if (openCount > 0 && decoder.decode(state.openHit[std::min<uint32_t>(openCount, 3) - 1]))
+            {
+                const uint32_t open = (openCount > 1) ? decoder.decode(state.openIndex) : 0;
+                if (open >= openCount)
+                {
+                    throw std::invalid_argument("invalid shape data");
+                }
+                id = state.open.get(corners[i - 1], open).start;
+            }
+            else if (decoder.decode(state.isNew[first]))
+            {
+                if (state.vertexCount >= vertexCount)
+                {
+                    throw std::invalid_argument("invalid shape data");
+                }
+                id = state.vertexCount;
+                int64_t prediction[3];
+                const Prediction kind = state.predict(corners.data(), i, prediction);
+                for (size_t j = 0; j < 3; ++j)
+                {
+                    const int64_t value = prediction[j] + UnZigZag(decoder.decodeExpGolomb(state.residual[kind][j]));
+                    if (value < 0 || value > state.levels)
+                    {
+                        throw std::invalid_argument("invalid shape data");
+                    }
+                    state.coordinates[3 * id + j] = (uint32_t)value;
+                }
+                ++state.vertexCount;
+            }
+            else if (decoder.decode(state.recentHit[first]))
+            {
+                const uint32_t recent = decoder.decode(state.recentIndex[first]);
+                if (recent >= state.recent.size())
+                {
+                    throw std::invalid_argument("invalid shape data");
+                }
+                id = state.recent.get(recent);
+            }
+            else
+            {
+                const uint32_t distance = decoder.decodeExpGolomb(state.vertexDistance);
+                if (distance >= state.vertexCount)
+                {
+                    throw std::invalid_argument("invalid shape data");
+                }
+                id = state.vertexCount - 1 - distance;
+            }
+            corners[i] = id;
+            points[i] = (Index)id;
+            state.recent.use(id);
+        }
+        state.finishFace(corners.data(), faceSize);
+        faces.emplace_back(points.data(), (Index)faceSize);
+    }
+    if (state.vertexCount != vertexCount)
+    {
+        throw std::invalid_argument("invalid shape data");
+    }
+
+    if (quantized.precision == QuantizedVertices::Precision::Bits16)
+    {
+        quantized.coordinates16.assign(state.coordinates.begin(), state.coordinates.end());
+    }
+    else
+    {
+        quantized.coordinates21.resize(vertexCount);
+        for (size_t i = 0; i < vertexCount; ++i)
+        {
+            const uint32_t* q = &state.coordinates[3 * i];
+            quantized.coordinates21[i] = (uint64_t)q[0] | ((uint64_t)q[1] << 21) | ((uint64_t)q[2] << 42);
+        }
+    }
+    return Shape(quantized, faces);
+}
@@ -0,0 +1,557 @@
+﻿#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+
+#include "internal/generic/Predicates.h"
+#include "internal/geometry/Shape.h"
+
+//
+// Distance and penetration of convex shapes on the Minkowski difference
+// A - B, which contains the origin when the shapes overlap.
+// GJK: "A Fast Procedure for Computing the Distance Between Complex Objects
+// in Three-Dimensional Space" (Gilbert, Johnson, Keerthi 1988).
+// EPA: "Proximity Queries and Penetration Depth Computation on 3D Game
+// Objects" (van den Bergen 2001).
+// The shapes are only accessed through support points, so the number of
+// iterations doesn't depend on the face count.
+//
+namespace
+{
+    constexpr size_t maxIterations = 64;
+    constexpr size_t maxPolytopeIterations = 128;
+    // relative convergence tolerance (on squared distances)
+    constexpr Scalar tolerance = 1e-12;
+
+    // Point of A - B, with the points of A and B it came from
+    struct SupportPoint
+    {
+        Vertex w;
+        Vertex a;
+        Vertex b;
+    };
+
+    // Indices of the simplex points spanning a vertex, edge or triangle
+    struct Feature
+    {
+        std::array<size_t, 3> indices = {};
+        size_t size = 0;
+
+        Feature() = default;
+        Feature(const std::initializer_list<size_t> list)
+        {
+            for (const auto i : list)
+            {
+                indices[size++] = i;
+            }
+        }
+    };
+
+    struct Simplex
+    {
+        std::array<SupportPoint, 4> points;
+        size_t size = 0;
+
+        void add(const SupportPoint& point)
+        {
+            points[size++] = point;
+        }
+        void keep(const Feature& feature)
+        {
+            std::array<SupportPoint, 4> kept;
+            for (size_t i = 0; i < feature.size; ++i)
+            {
+                kept[i] = points[feature.indices[i]];
+            }
+            points = kept;
+            size = feature.size;
+        }
+        bool contains(const Vertex& w) const
+        {
+            for (size_t i = 0; i < size; ++i)
+            {
+                if (points[i].w == w)
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+    };
+
+    // Closest point to the origin on triangle p[ia] p[ib] p[ic], see "Real-Time
+    // Collision Detection" (Ericson 2005) 5.1.5. Returns the point and the
+    // triangle points which span the feature it lies on in used.
+    Vertex closestOnTriangle(const Simplex& simplex, const size_t ia, const size_t ib, const size_t ic, Feature& used)
+    {
+        const Vertex& a = simplex.points[ia].w;
+        const Vertex& b = simplex.points[ib].w;
+        const Vertex& c = simplex.points[ic].w;
+        const Vertex ab = b - a;
+        const Vertex ac = c - a;
+        const Scalar d1 = -ab.innerProduct(a);
+        const Scalar d2 = -ac.innerProduct(a);
+        if (d1 <= 0 && d2 <= 0)
+        {
+            used = { ia };
+            return a;
+        }
+        const Scalar d3 = -ab.innerProduct(b);
+        const Scalar d4 = -ac.innerProduct(b);
+        if (d3 >= 0 && d4 <= d3)
+        {
+            used = { ib };
+            return b;
+        }
+        const Scalar vc = d1 * d4 - d3 * d2;
+        if (vc <= 0 && d1 >= 0 && d3 <= 0)
+        {
+            used = { ia, ib };
+            return a + ab * (d1 / (d1 - d3));
+        }
+        const Scalar d5 = -ab.innerProduct(c);
+        const Scalar d6 = -ac.innerProduct(c);
+        if (d6 >= 0 && d5 <= d6)
+        {
+            used = { ic };
+            return c;
+        }
+        const Scalar vb = d5 * d2 - d1 * d6;
+        if (vb <= 0 && d2 >= 0 && d6 <= 0)
+        {
+            used = { ia, ic };
+            return a + ac * (d2 / (d2 - d6));
+        }
+        const Scalar va = d3 * d6 - d5 * d4;
+        if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0)
+        {
+            used = { ib, ic };
+            return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+        }
+        const Scalar denominator = va + vb + vc;
+        if (denominator == 0)
+        {
+            // degenerate triangle, use its longest edge
+            used = { ia, ib };
+            return ab.innerProduct(ab) >= ac.innerProduct(ac) ? a + ab * std::clamp(d1 / ab.innerProduct(ab), 0.0, 1.0) : a + ac * std::clamp(d2 / ac.innerProduct(ac), 0.0, 1.0);
+        }
+        used = { ia, ib, ic };
+        return a + ab * (vb / denominator) + ac * (vc / denominator);
+    }
+
+    // Closest point to the origin on the simplex, the simplex is reduced to
+    // the points spanning the feature the closest point lies on.
+    // Sets inside when the origin is inside the tetrahedron.
+    Vertex closestOnSimplex(Simplex& simplex, bool& inside)
+    {
+        inside = false;
+        Feature used;
+        switch (simplex.size)
+        {
+        case 1:
+            return simplex.points[0].w;
+        case 2:
+        {
+            const Vertex& a = simplex.points[0].w;
+            const Vertex ab = simplex.points[1].w - a;
+            const Scalar length2 = ab.innerProduct(ab);
+            const Scalar t = length2 > 0 ? -a.innerProduct(ab) / length2 : 0;
+            if (t <= 0)
+            {
+                simplex.keep({ 0 });
+                return a;
+            }
+            if (t >= 1)
+            {
+                simplex.keep({ 1 });
+                return simplex.points[0].w;
+            }
+            return a + ab * t;
+        }
+        case 3:
+        {
+            const Vertex v = closestOnTriangle(simplex, 0, 1, 2, used);
+            if (used.size < 3)
+            {
+                simplex.keep(used);
+            }
+            return v;
+        }
+        default:
+        {
+            // Ericson 5.1.6, only the faces with the origin on the outside can hold the closest point
+            static const size_t tetrahedronFaces[4][4] = { {0,1,2,3}, {0,2,3,1}, {0,3,1,2}, {1,3,2,0} };
+            Scalar best = Limits<Scalar>::MaxValue;
+            Vertex res;
+            Feature bestUsed;
+            bool outside = false;
+            for (const auto& f : tetrahedronFaces)
+            {
+                const Vertex& a = simplex.points[f[0]].w;
+                const Vertex& b = simplex.points[f[1]].w;
+                const Vertex& c = simplex.points[f[2]].w;
+                const Scalar signOrigin = Predicates::Orient3D(a, b, c, Vertex(0, 0, 0));
+                const Scalar signOpposite = Predicates::Orient3D(a, b, c, simplex.points[f[3]].w);
+                // a flat tetrahedron has the origin outside of all faces
+                if (signOrigin * signOpposite < 0 || signOpposite == 0)
+                {
+                    outside = true;
+                    const Vertex v = closestOnTriangle(simplex, f[0], f[1], f[2], used);
+                    const Scalar distance2 = v.innerProduct(v);
+                    if (distance2 < best)
+                    {
+                        best = distance2;
+                        res = v;
+                        bestUsed = used;
+                    }
+                }
+            }
+            if (!outside)
+            {
+                inside = true;
+                return Vertex(0, 0, 0);
+            }
+            simplex.keep(bestUsed);
+            return res;
+        }
+        }
+    }
+
+    enum class Query
+    {
+        Overlap,
+        Distance,
+    };
+
+    // GJK, returns the distance and leaves the final simplex.
+    // For Query::Overlap it stops as soon as a separating direction is found.
+    template<typename SUPPORT>
+    Scalar Gjk(SUPPORT&& support, Simplex& simplex, const Query query)
+    {
+        simplex.size = 0;
+        simplex.add(support(Vertex(1, 0, 0)));
+        Vertex v = simplex.points[0].w;
+        Scalar scale = v.innerProduct(v);
+        for (size_t iteration = 0; iteration < maxIterations; ++iteration)
+        {
+            const Scalar vv = v.innerProduct(v);
+            if (vv <= tolerance * tolerance * std::max<Scalar>(scale, 1))
+            {
+                return 0;
+            }
+            const SupportPoint point = support(-v);
+            scale = std::max(scale, point.w.innerProduct(point.w));
+            const Scalar vw = v.innerProduct(point.w);
+            if (query == Query::Overlap && vw > 0)
+            {
+                // separating axis
+                return std::sqrt(vv);
+            }
+            if (vv - vw <= tolerance * vv || simplex.contains(point.w))
+            {
+                return std::sqrt(vv);
+            }
+            simplex.add(point);
+            bool inside;
+            v = closestOnSimplex(simplex, inside);
+            if (inside)
+            {
+                return 0;
+            }
+            if (v.innerProduct(v) >= vv)
+            {
+                // no more progress
+                return std::sqrt(v.innerProduct(v));
+            }
+        }
+        return v.length();
+    }
+
+    // EPA on a simplex which encloses the origin. Returns the depth and the direction.
+    template<typename SUPPORT>
+    Scalar Epa(SUPPORT&& support, Simplex& simplex, Normal& direction)
+    {
+        // grow the simplex into a tetrahedron, if the difference is flat there is no penetration
+        static const Vertex axes[6] = { {1,0,0}, {-1,0,0}, {0,1,0}, {0,-1,0}, {0,0,1}, {0,0,-1} };
+        Scalar scale = 0;
+        for (size_t i = 0; i < simplex.size; ++i)
+        {
+            scale = std::max(scale, simplex.points[i].w.length());
+        }
+        auto grow = [&](const Vertex& d)
+        {
+            const SupportPoint point = support(d);
+            scale = std::max(scale, point.w.length());
+            const Scalar minimum = 1e-9 * std::max<Scalar>(scale, 1);
+            bool useful = false;
+            switch (simplex.size)
+            {
+            case 1:
+                useful = (point.w - simplex.points[0].w).length() > minimum;
+                break;
+            case 2:
+            {
+                const Vertex ab = simplex.points[1].w - simplex.points[0].w;
+                useful = ab.crossProduct(point.w - simplex.points[0].w).length() > minimum * ab.length();
+                break;
+            }
+            case 3:
+            {
+                const Vertex& a = simplex.points[0].w;
+                const Vertex n = (simplex.points[1].w - a).crossProduct(simplex.points[2].w - a);
+                useful = std::abs(n.innerProduct(point.w - a)) > minimum * n.length();
+                break;
+            }
+            }
+            if (useful)
+            {
+                simplex.add(point);
+            }
+            return useful;
+        };
+        for (const auto& axis : axes)
+        {
+            if (simplex.size == 1) grow(axis);
+        }
+        if (simplex.size == 2)
+        {
+            const Vertex ab = simplex.points[1].w - simplex.points[0].w;
+            for (const auto& axis : axes)
+            {
+                const Vertex d = ab.crossProduct(axis);
+                if (d.innerProduct(d) > 0 && grow(d)) break;
+            }
+        }
+        if (simplex.size == 3)
+        {
+            const Vertex& a = simplex.points[0].w;
+            const Vertex n = (simplex.points[1].w - a).crossProduct(simplex.points[2].w - a);
+            if (!grow(n)) grow(-n);
+        }
+        if (simplex.size < 4)
+        {
+            direction = Normal(Vertex(1, 0, 0));
+            return 0;
+        }
+
+        std::vector<SupportPoint> points(simplex.points.begin(), simplex.points.end());
+        struct Triangle
+        {
+            size_t a, b, c;
+            Vertex normal;
+            Scalar distance;
+        };
+        std::vector<Triangle> triangles;
+        auto addTriangle = [&](const size_t a, const size_t b, const size_t c)
+        {
+            Vertex n = (points[b].w - points[a].w).crossProduct(points[c].w - points[a].w);
+            const Scalar length = n.length();
+            if (length == 0)
+            {
+                return;
+            }
+            n /= length;
+            triangles.push_back({ a, b, c, n, n.innerProduct(points[a].w) });
+        };
+        // orient the tetrahedron so the faces point outwards
+        if ((points[1].w - points[0].w).crossProduct(points[2].w - points[0].w).innerProduct(points[3].w - points[0].w) > 0)
+        {
+            std::swap(points[1], points[2]);
+        }
+        addTriangle(0, 1, 2);
+        addTriangle(0, 3, 1);
+        addTriangle(0, 2, 3);
+        addTriangle(1, 3, 2);
+        // all faces degenerate, keep the estimate of the flat case
+        if (triangles.empty())
+        {
+            direction = Normal(Vertex(1, 0, 0));
+            return 0;
+        }
+
+        Triangle closest = triangles.front();
+        std::vector<std::pair<size_t, size_t>> horizon;
+        for (size_t iteration = 0; iteration < maxPolytopeIterations && !triangles.empty(); ++iteration)
+        {
+            closest = *std::min_element(triangles.begin(), triangles.end(),
+                [](const Triangle& a, const Triangle& b) { return a.distance < b.distance; });
+            const SupportPoint point = support(closest.normal);
+            const Scalar distance = closest.normal.innerProduct(point.w);
+            if (distance - closest.distance <= 1e-9 * std::max<Scalar>(scale, 1))
+            {
+                break;
+            }
+            // remove the triangles seen from the new point, keep their outline (horizon)
+            points.push_back(point);
+            const size_t p = points.size() - 1;
+            horizon.clear();
+            auto addEdge = [&](const size_t a, const size_t b)
+            {
+                auto reverse = std::find(horizon.begin(), horizon.end(), std::make_pair(b, a));
+                if (reverse != horizon.end())
+                {
+                    horizon.erase(reverse);
+                }
+                else
+                {
+                    horizon.emplace_back(a, b);
+                }
+            };
+            for (size_t i = 0; i < triangles.size();)
+            {
+                const auto& t = triangles[i];
+                if (t.normal.innerProduct(point.w - points[t.a].w) > 0)
+                {
+                    addEdge(t.a, t.b);
+                    addEdge(t.b, t.c);
+                    addEdge(t.c, t.a);
+                    triangles[i] = triangles.back();
+                    triangles.pop_back();
+                }
+                else
+                {
+                    ++i;
+                }
+            }
+            for (const auto& edge : horizon)
+            {
+                addTriangle(edge.first, edge.second, p);
+            }
+        }
+        direction = Normal(closest.normal);
+        return std::max<Scalar>(closest.distance, 0);
+    }
+
+    // World space support point of A - B, warm started from the previous result
+    struct MinkowskiSupport
+    {
+        MinkowskiSupport(const Shape& a, const Shape& b, const Transformation& transformationA, const Transformation& transformationB)
+            : a(a)
+            , b(b)
+            , transformationA(transformationA)
+            , transformationB(transformationB)
+            , inverseA(transformationA.inverted())
+            , inverseB(transformationB.inverted())
+            , lastA(0)
+            , lastB(0)
+        {}
+
+        template<typename SUPPORT>
+        SupportPoint operator()(const Vertex& direction, SUPPORT&& support)
+        {
+            lastA = support(a, inverseA.rotate(direction), lastA);
+            lastB = support(b, inverseB.rotate(-direction), lastB);
+            const Vertex pa = transformationA * a.getVertices()[lastA];
+            const Vertex pb = transformationB * b.getVertices()[lastB];
+            return { pa - pb, pa, pb };
+        }
+
+        const Shape& a;
+        const Shape& b;
+        const Transformation& transformationA;
+        const Transformation& transformationB;
+        const Transformation inverseA;
+        const Transformation inverseB;
+        Index lastA;
+        Index lastB;
+    };
+}
+
+Index Shape::support(const Vertex& direction, const Index start) const
+{
+    requireVertices();
+    Index best = start;
+    Scalar bestValue = geometry->vertices[best].innerProduct(direction);
+    if (!isConvex())
+    {
+        // counted in size_t, all Index values can be in use
+        size_t bestIndex = best;
+        for (size_t i = 0; i < geometry->vertices.size(); ++i)
+        {
+            const Scalar value = geometry->vertices[i].innerProduct(direction);
+            if (value > bestValue)
+            {
+                bestIndex = i;
+                bestValue = value;
+            }
+        }
+        return (Index)bestIndex;
+    }
+    // on a convex shape every local maximum is a global one
+    requireEdges();
+    bool improved = true;
+    while (improved)
+    {
+        improved = false;
+        const uint32_t first = geometry->vertexEdges[best];
+        uint32_t edge = first;
+        do
+        {
+            const Index neighbour = geometry->edges[edge].endVertex;
+            const Scalar value = geometry->vertices[neighbour].innerProduct(direction);
+            if (value > bestValue)
+            {
+                best = neighbour;
+                bestValue = value;
+                improved = true;
+                break;
+            }
+            // next edge around the start vertex
+            edge = geometry->edges[geometry->edges[edge].prevEdge].mirrorEdge;
+        } while (edge != first);
+    }
+    return best;
+}
+
+bool Shape::isConvex() const
+{
+    // Make required volatile data available
+    requireConvexity();
+    return *geometry->convex;
+}
+
+bool Shape::overlapConvex(const Shape& other) const
+{
+    MinkowskiSupport minkowski(*this, other, transformation, other.transformation);
+    auto support = [&](const Vertex& direction)
+    {
+        return minkowski(direction, [](const Shape& shape, const Vertex& localDirection, const Index start) { return shape.support(localDirection, start); });
+    };
+    Simplex simplex;
+    return Gjk(support, simplex, Query::Overlap) == 0;
+}
+
+Scalar Shape::calculateDistance(const Shape& other) const
+{
+    if (getVertices().empty() || other.getVertices().empty())
+    {
+        return Limits<Scalar>::MaxValue;
+    }
+    MinkowskiSupport minkowski(*this, other, transformation, other.transformation);
+    auto support = [&](const Vertex& direction)
+    {
+        return minkowski(direction, [](const Shape& shape, const Vertex& localDirection, const Index start) { return shape.support(localDirection, start); });
+    };
+    Simplex simplex;
+    return Gjk(support, simplex, Query::Distance);
+}
+
+Scalar Shape::calculatePenetration(const Shape& other, Normal& direction) const
+{
+    direction = Normal(Vertex(1, 0, 0));
+    if (getVertices().empty() || other.getVertices().empty())
+    {
+        return 0;
+    }
+    MinkowskiSupport minkowski(*this, other, transformation, other.transformation);
+    auto support = [&](const Vertex& towards)
+    {
+        return minkowski(towards, [](const Shape& shape, const Vertex& localDirection, const Index start) { return shape.support(localDirection, start); });
+    };
+    Simplex simplex;
+    if (Gjk(support, simplex, Query::Distance) > 0)
+    {
+        return 0;
+    }
+    return Epa(support, simplex, direction);
+}
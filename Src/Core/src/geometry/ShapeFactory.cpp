@@ -1,9 +1,422 @@
+﻿
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
 
+#include "internal/generic/Constants.h"
+#include "internal/generic/Limits.h"
+#include "internal/generic/Parallel.h"
 #include "internal/generic/Vertices.h"
 
 #include "internal/geometry/Faces.h"
 #include "internal/geometry/ShapeFactory.h"
 
+namespace
+{
+    const uint32_t none = std::numeric_limits<uint32_t>::max();
+
+    // Check if a vertex count still fits in Index
+    void requireIndexRange(const size_t& count)
+    {
+        if (count > std::numeric_limits<Index>::max())
+        {
+            throw std::length_error("vertex count exceeds the Index range");
+        }
+    }
+
+    // Check the circle resolution of the round shapes
+    void requireSegments(const size_t& segments)
+    {
+        if (segments < 3)
+        {
+            throw std::invalid_argument("at least 3 segments are required");
+        }
+    }
+
+    void requireRings(const size_t& rings, const size_t& minimum)
+    {
+        if (rings < minimum)
+        {
+            throw std::invalid_argument("not enough rings");
+        }
+    }
+
+    // cos and sin of start + i * 2pi / count for consecutive i, using a
+    // rotation recurrence instead of a table or trigonometry per vertex
+    struct CircleSteps
+    {
+        CircleSteps(const size_t& count, const Scalar& start = 0)
+            : stepCos(cos(2 * Constants::Pi / count))
+            , stepSin(sin(2 * Constants::Pi / count))
+            , c(cos(start))
+            , s(sin(start))
+        {}
+        void next()
+        {
+            const Scalar t = c * stepCos - s * stepSin;
+            s = s * stepCos + c * stepSin;
+            c = t;
+        }
+        const Scalar stepCos;
+        const Scalar stepSin;
+        Scalar c;
+        Scalar s;
+    };
+
+    // Shape of revolution around the z axis with a pole at the top and the
+    // bottom and circles of latitude in between, from top to bottom.
+    // latitude(k) returns {radius, z} of circle k.
+    // Faces: triangle fans at the poles and quads between the circles.
+    template<typename LATITUDE>
+    Shape Lathe(const Vertex& center, const Scalar& top, const Scalar& bottom, const size_t& segments, const size_t& circles, LATITUDE&& latitude)
+    {
+        const size_t vertexCount = 2 + circles * segments;
+        requireIndexRange(vertexCount);
+        Vertices vertices(vertexCount);
+        Faces faces;
+        faces.reserve((circles + 1) * segments);
+        vertices.front() = Vertex(center.x, center.y, center.z + top);
+        vertices.back() = Vertex(center.x, center.y, center.z + bottom);
+        for (size_t k = 0; k < circles; ++k)
+        {
+            const auto rz = latitude(k);
+            CircleSteps step(segments);
+            for (size_t i = 0; i < segments; ++i, step.next())
+            {
+                vertices[1 + k * segments + i] = Vertex(center.x + rz.x * step.c, center.y + rz.x * step.s, center.z + rz.y);
+            }
+        }
+        const Index south = (Index)(vertexCount - 1);
+        const Index last = (Index)(1 + (circles - 1) * segments);
+        for (Index i = 0, j = (Index)(segments - 1); i < segments; j = i, ++i)
+        {
+            faces.emplace_back(Face{ 0, (Index)(1 + j), (Index)(1 + i) });
+        }
+        for (size_t k = 0; k + 1 < circles; ++k)
+        {
+            const Index upper = (Index)(1 + k * segments);
+            const Index lower = (Index)(upper + segments);
+            for (Index i = 0, j = (Index)(segments - 1); i < segments; j = i, ++i)
+            {
+                faces.emplace_back(Face{ (Index)(upper + j), (Index)(lower + j), (Index)(lower + i), (Index)(upper + i) });
+            }
+        }
+        for (Index i = 0, j = (Index)(segments - 1); i < segments; j = i, ++i)
+        {
+            faces.emplace_back(Face{ south, (Index)(last + i), (Index)(last + j) });
+        }
+        return Shape(std::move(vertices), std::move(faces));
+    }
+
+    //
+    // Polygon mesh in compressed rows, used for the intermediate levels of
+    // the subdivision so no Face objects are created per level.
+    // Every corner is also the half edge from its vertex to the next corner.
+    //
+    struct SubdivisionMesh
+    {
+        Vertices vertices;
+        std::vector<uint32_t> faceOffsets; // face => first corner, back() is the corner count
+        std::vector<Index> corners;        // corner => vertex
+
+        // connectivity, see connect()
+        std::vector<uint32_t> cornerFaces;   // corner => face
+        std::vector<uint32_t> mirrors;       // corner => opposite half edge or none
+        std::vector<uint32_t> cornerEdges;   // corner => edge
+        std::vector<uint32_t> edgeCorners;   // edge => a corner on the edge
+        std::vector<uint32_t> vertexOffsets; // vertex => first outgoing corner
+        std::vector<uint32_t> vertexCorners; // outgoing corners, grouped per vertex
+
+        size_t faceCount() const
+        {
+            return faceOffsets.size() - 1;
+        }
+        uint32_t next(const uint32_t corner) const
+        {
+            const uint32_t face = cornerFaces[corner];
+            return (corner + 1 == faceOffsets[face + 1]) ? faceOffsets[face] : corner + 1;
+        }
+        uint32_t prev(const uint32_t corner) const
+        {
+            const uint32_t face = cornerFaces[corner];
+            return (corner == faceOffsets[face]) ? faceOffsets[face + 1] - 1 : corner - 1;
+        }
+
+        // Build the vertex => outgoing corners rows, the mirror half edges and the edges
+        void connect()
+        {
+            const size_t cornerCount = corners.size();
+            cornerFaces.resize(cornerCount);
+            for (uint32_t face = 0; face < faceCount(); ++face)
+            {
+                std::fill(cornerFaces.begin() + faceOffsets[face], cornerFaces.begin() + faceOffsets[face + 1], face);
+            }
+            vertexOffsets.assign(vertices.size() + 1, 0);
+            for (const auto& vertex : corners)
+            {
+                ++vertexOffsets[vertex + 1];
+            }
+            std::partial_sum(vertexOffsets.begin(), vertexOffsets.end(), vertexOffsets.begin());
+            vertexCorners.resize(cornerCount);
+            {
+                auto fill = vertexOffsets;
+                for (uint32_t corner = 0; corner < cornerCount; ++corner)
+                {
+                    vertexCorners[fill[corners[corner]]++] = corner;
+                }
+            }
+            // the mirror of a->b is the outgoing half edge of b which ends in a
+            mirrors.resize(cornerCount);
+            Parallel::For(cornerCount, [&](const size_t corner)
+                {
+                    const Index start = corners[corner];
+                    const Index end = corners[next((uint32_t)corner)];
+                    mirrors[corner] = none;
+                    for (uint32_t i = vertexOffsets[end]; i < vertexOffsets[end + 1]; ++i)
+                    {
+                        if (corners[next(vertexCorners[i])] == start)
+                        {
+                            mirrors[corner] = vertexCorners[i];
+                            break;
+                        }
+                    }
+                });
+            cornerEdges.resize(cornerCount);
+            edgeCorners.clear();
+            edgeCorners.reserve(cornerCount);
+            for (uint32_t corner = 0; corner < cornerCount; ++corner)
+            {
+                if (mirrors[corner] == none || corner < mirrors[corner])
+                {
+                    cornerEdges[corner] = (uint32_t)edgeCorners.size();
+                    edgeCorners.emplace_back(corner);
+                }
+            }
+            for (uint32_t corner = 0; corner < cornerCount; ++corner)
+            {
+                if (mirrors[corner] != none && corner > mirrors[corner])
+                {
+                    cornerEdges[corner] = cornerEdges[mirrors[corner]];
+                }
+            }
+        }
+
+        // Neighbours along the open border of a vertex, false for inner vertices
+        bool borderNeighbours(const Index vertex, Index& before, Index& after) const
+        {
+            bool border = false;
+            for (uint32_t i = vertexOffsets[vertex]; i < vertexOffsets[vertex + 1]; ++i)
+            {
+                const uint32_t corner = vertexCorners[i];
+                if (mirrors[corner] == none)
+                {
+                    after = corners[next(corner)];
+                    border = true;
+                }
+                const uint32_t incoming = prev(corner);
+                if (mirrors[incoming] == none)
+                {
+                    before = corners[incoming];
+                    border = true;
+                }
+            }
+            return border;
+        }
+
+        static SubdivisionMesh FromShape(const Vertices& vertices, const Faces& faces)
+        {
+            SubdivisionMesh mesh;
+            mesh.vertices = vertices;
+            mesh.faceOffsets.reserve(faces.size() + 1);
+            mesh.faceOffsets.emplace_back(0);
+            for (const auto& face : faces)
+            {
+                mesh.faceOffsets.emplace_back(mesh.faceOffsets.back() + face.size());
+            }
+            mesh.corners.reserve(mesh.faceOffsets.back());
+            for (const auto& face : faces)
+            {
+                for (const auto& point : face)
+                {
+                    mesh.corners.emplace_back(point);
+                }
+            }
+            return mesh;
+        }
+
+        Faces toFaces() const
+        {
+            Faces faces;
+            faces.reserve(faceCount());
+            for (size_t face = 0; face < faceCount(); ++face)
+            {
+                faces.emplace_back(&corners[faceOffsets[face]], (Index)(faceOffsets[face + 1] - faceOffsets[face]));
+            }
+            return faces;
+        }
+    };
+
+    // One level of Loop subdivision, see "Smooth Subdivision Surfaces Based on 
+    // Triangles" (Loop 1987). New vertices: the old vertices, then one per edge.
+    // Without smooth the triangles are only split at the edge midpoints.
+    SubdivisionMesh LoopLevel(SubdivisionMesh& mesh, const bool smooth = true)
+    {
+        mesh.connect();
+        const size_t vertexCount = mesh.vertices.size();
+        const size_t edgeCount = mesh.edgeCorners.size();
+        const size_t faceCount = mesh.faceCount();
+        requireIndexRange(vertexCount + edgeCount);
+        SubdivisionMesh res;
+        res.vertices.resize(vertexCount + edgeCount);
+        res.faceOffsets.resize(faceCount * 4 + 1);
+        res.corners.resize(faceCount * 12);
+        const auto& v = mesh.vertices;
+        Parallel::For(vertexCount, [&](const size_t vertex)
+            {
+                Index before = 0;
+                Index after = 0;
+                if (!smooth)
+                {
+                    res.vertices[vertex] = v[vertex];
+                    return;
+                }
+                if (mesh.borderNeighbours((Index)vertex, before, after))
+                {
+                    res.vertices[vertex] = v[vertex] * (3.0 / 4) + (v[before] + v[after]) * (1.0 / 8);
+                    return;
+                }
+                Vertex sum;
+                const size_t n = mesh.vertexOffsets[vertex + 1] - mesh.vertexOffsets[vertex];
+                for (uint32_t i = mesh.vertexOffsets[vertex]; i < mesh.vertexOffsets[vertex + 1]; ++i)
+                {
+                    sum += v[mesh.corners[mesh.next(mesh.vertexCorners[i])]];
+                }
+                const Scalar beta = (5.0 / 8 - Numerics::Sqr(3.0 / 8 + cos(2 * Constants::Pi / n) / 4)) / n;
+                res.vertices[vertex] = v[vertex] * (1 - n * beta) + sum * beta;
+            });
+        Parallel::For(edgeCount, [&](const size_t edge)
+            {
+                const uint32_t corner = mesh.edgeCorners[edge];
+                const uint32_t mirror = mesh.mirrors[corner];
+                const Vertex& a = v[mesh.corners[corner]];
+                const Vertex& b = v[mesh.corners[mesh.next(corner)]];
+                if (mirror == none || !smooth)
+                {
+                    res.vertices[vertexCount + edge] = (a + b) / 2;
+                }
+                else
+                {
+                    const Vertex& c = v[mesh.corners[mesh.prev(corner)]];
+                    const Vertex& d = v[mesh.corners[mesh.prev(mirror)]];
+                    res.vertices[vertexCount + edge] = (a + b) * (3.0 / 8) + (c + d) * (1.0 / 8);
+                }
+            });
+        Parallel::For(faceCount, [&](const size_t face)
+            {
+                const uint32_t first = mesh.faceOffsets[face];
+                const Index a = mesh.corners[first];
+                const Index b = mesh.corners[first + 1];
+                const Index c = mesh.corners[first + 2];
+                const Index ab = (Index)(vertexCount + mesh.cornerEdges[first]);
+                const Index bc = (Index)(vertexCount + mesh.cornerEdges[first + 1]);
+                const Index ca = (Index)(vertexCount + mesh.cornerEdges[first + 2]);
+                const Index triangles[12] = { a, ab, ca,  b, bc, ab,  c, ca, bc,  ab, bc, ca };
+                std::copy_n(triangles, 12, res.corners.begin() + face * 12);
+                for (size_t i = 0; i < 4; ++i)
+                {
+                    res.faceOffsets[face * 4 + i] = (uint32_t)(face * 12 + i * 3);
+                }
+            });
+        res.faceOffsets.back() = (uint32_t)res.corners.size();
+        return res;
+    }
+
+    // One level of Catmull-Clark subdivision, see "Recursively generated 
+    // B-spline surfaces on arbitrary topological meshes" (Catmull, Clark 1978).
+    // New vertices: the old vertices, then one per edge, then one per face.
+    SubdivisionMesh CatmullClarkLevel(SubdivisionMesh& mesh)
+    {
+        mesh.connect();
+        const size_t vertexCount = mesh.vertices.size();
+        const size_t edgeCount = mesh.edgeCorners.size();
+        const size_t faceCount = mesh.faceCount();
+        const size_t cornerCount = mesh.corners.size();
+        requireIndexRange(vertexCount + edgeCount + faceCount);
+        SubdivisionMesh res;
+        res.vertices.resize(vertexCount + edgeCount + faceCount);
+        res.faceOffsets.resize(cornerCount + 1);
+        res.corners.resize(cornerCount * 4);
+        const auto& v = mesh.vertices;
+        const size_t facePoints = vertexCount + edgeCount;
+        Parallel::For(faceCount, [&](const size_t face)
+            {
+                Vertex sum;
+                for (uint32_t i = mesh.faceOffsets[face]; i < mesh.faceOffsets[face + 1]; ++i)
+                {
+                    sum += v[mesh.corners[i]];
+                }
+                res.vertices[facePoints + face] = sum / (Scalar)(mesh.faceOffsets[face + 1] - mesh.faceOffsets[face]);
+            });
+        Parallel::For(edgeCount, [&](const size_t edge)
+            {
+                const uint32_t corner = mesh.edgeCorners[edge];
+                const uint32_t mirror = mesh.mirrors[corner];
+                const Vertex& a = v[mesh.corners[corner]];
+                const Vertex& b = v[mesh.corners[mesh.next(corner)]];
+                if (mirror == none)
+                {
+                    res.vertices[vertexCount + edge] = (a + b) / 2;
+                }
+                else
+                {
+                    const Vertex& f0 = res.vertices[facePoints + mesh.cornerFaces[corner]];
+                    const Vertex& f1 = res.vertices[facePoints + mesh.cornerFaces[mirror]];
+                    res.vertices[vertexCount + edge] = (a + b + f0 + f1) / 4;
+                }
+            });
+        Parallel::For(vertexCount, [&](const size_t vertex)
+            {
+                Index before = 0;
+                Index after = 0;
+                if (mesh.borderNeighbours((Index)vertex, before, after))
+                {
+                    res.vertices[vertex] = v[vertex] * (3.0 / 4) + (v[before] + v[after]) * (1.0 / 8);
+                    return;
+                }
+                // (F + 2R + (n-3)P) / n, with F the average of the face points,
+                // R the average of the edge midpoints
+                Vertex faceSum;
+                Vertex neighbourSum;
+                const size_t n = mesh.vertexOffsets[vertex + 1] - mesh.vertexOffsets[vertex];
+                for (uint32_t i = mesh.vertexOffsets[vertex]; i < mesh.vertexOffsets[vertex + 1]; ++i)
+                {
+                    const uint32_t corner = mesh.vertexCorners[i];
+                    faceSum += res.vertices[facePoints + mesh.cornerFaces[corner]];
+                    neighbourSum += v[mesh.corners[mesh.next(corner)]];
+                }
+                const Vertex F = faceSum / (Scalar)n;
+                const Vertex R = (v[vertex] + neighbourSum / (Scalar)n) / 2;
+                res.vertices[vertex] = (F + R * 2 + v[vertex] * (Scalar)(n - 3)) / (Scalar)n;
+            });
+        // a quad per corner: corner, edge point, face point, edge point of the previous corner
+        Parallel::For(cornerCount, [&](const size_t corner)
+            {
+                const Index quad[4] = 
+                { 
+                    mesh.corners[corner], 
+                    (Index)(vertexCount + mesh.cornerEdges[corner]),
+                    (Index)(facePoints + mesh.cornerFaces[corner]),
+                    (Index)(vertexCount + mesh.cornerEdges[mesh.prev((uint32_t)corner)])
+                };
+                std::copy_n(quad, 4, res.corners.begin() + corner * 4);
+                res.faceOffsets[corner] = (uint32_t)(corner * 4);
+            });
+        res.faceOffsets.back() = (uint32_t)res.corners.size();
+        return res;
+    }
+}
+
 Shape ShapeFactory::Box(const Vertex& min, const Vertex& max)
 {
     Vertices vertices =
@@ -110,10 +523,17 @@ Shape ShapeFactory::Octahedron(const Vertex& center, const Scalar& radius)
         Face({2,5,3}),
         Face({3,5,4})
     };
+
+    for (auto & v : vertices)
+    {
+        v *= radius;
+        v += center;
+    }
+
     return Shape(vertices, faces);
 }
 
-Shape ShapeFactory::Extrusion(const Contour2D& contour, const Scalar& height)
+Shape ShapeFactory::Extrusion(const Contour2D& contour, const Scalar& height, const bool triangulateCaps)
 {
     Index s = (Index)contour.size();
     Vertices vertices;
@@ -134,7 +554,435 @@ Shape ShapeFactory::Extrusion(const Contour2D& contour, const Scalar& height)
         top.emplace_back(s+i);
         j = i;
     }
-    faces.push_back(Face(bottom));
-    faces.push_back(Face(top));
+    if (triangulateCaps)
+    {
+        for (const auto& triangle : contour.triangulate())
+        {
+            faces.push_back(Face({ (Index)triangle[2], (Index)triangle[1], (Index)triangle[0] }));
+            faces.push_back(Face({ (Index)(s + triangle[0]), (Index)(s + triangle[1]), (Index)(s + triangle[2]) }));
+        }
+    }
+    else
+    {
+        faces.push_back(Face(bottom));
+        faces.push_back(Face(top));
+    }
     return Shape(vertices, faces);
 }
+
+Shape ShapeFactory::Sweep(const Contour2D& profile, const Contour3D& path, const bool closedPath)
+{
+    const size_t m = profile.size();
+    const size_t n = path.size();
+    if (m < 3 || n < (closedPath ? 3u : 2u))
+    {
+        throw std::invalid_argument("a sweep needs a profile of 3 points and a path of 2 points, 3 when closed");
+    }
+    for (size_t i = 0; i < (closedPath ? n : n - 1); ++i)
+    {
+        if (path[i] == path[(i + 1) % n])
+        {
+            throw std::invalid_argument("consecutive path points must differ");
+        }
+    }
+    requireIndexRange(m * n);
+    auto direction = [](const Vertex& from, const Vertex& to)
+    {
+        const Vertex d = to - from;
+        const Scalar length = d.length();
+        return length > 0 ? d / length : d;
+    };
+    // tangents halfway the adjacent path segments
+    std::vector<Vertex> tangents(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        const size_t prev = closedPath ? (i + n - 1) % n : (i > 0 ? i - 1 : i);
+        const size_t next = closedPath ? (i + 1) % n : (i + 1 < n ? i + 1 : i);
+        const Vertex out = direction(path[i], path[next]);
+        const Vertex tangent = direction(path[prev], path[i]) + out;
+        const Scalar length = tangent.length();
+        tangents[i] = length > 1e-9 ? tangent / length : out;
+    }
+    // Rotation minimizing frames by double reflection, see "Computation of
+    // Rotation Minimizing Frames" (Wang, Juettler, Zheng, Liu 2008).
+    std::vector<Vertex> normals(n + 1);
+    const Vertex& t0 = tangents[0];
+    const Vertex axis = std::abs(t0.x) <= std::abs(t0.y) && std::abs(t0.x) <= std::abs(t0.z) ? Vertex(1, 0, 0) : (std::abs(t0.y) <= std::abs(t0.z) ? Vertex(0, 1, 0) : Vertex(0, 0, 1));
+    normals[0] = direction(Vertex(0, 0, 0), axis - t0 * t0.innerProduct(axis));
+    auto reflect = [](const Vertex& v, const Vertex& normal, const Scalar& c)
+    {
+        return v - normal * (2 * normal.innerProduct(v) / c);
+    };
+    const size_t frames = closedPath ? n + 1 : n;
+    for (size_t i = 0; i + 1 < frames; ++i)
+    {
+        const Vertex& t = tangents[i];
+        const Vertex& nextTangent = tangents[(i + 1) % n];
+        const Vertex v1 = path[(i + 1) % n] - path[i];
+        const Scalar c1 = v1.innerProduct(v1);
+        Vertex r = normals[i];
+        Vertex tL = t;
+        if (c1 > 0)
+        {
+            r = reflect(r, v1, c1);
+            tL = reflect(t, v1, c1);
+        }
+        const Vertex v2 = nextTangent - tL;
+        const Scalar c2 = v2.innerProduct(v2);
+        normals[i + 1] = c2 > 1e-24 ? reflect(r, v2, c2) : r;
+    }
+    if (closedPath)
+    {
+        // the frames don't meet after a full loop, unwind the difference gradually
+        const Scalar twist = atan2(normals[0].crossProduct(normals[n]).innerProduct(t0), normals[0].innerProduct(normals[n]));
+        for (size_t i = 1; i < n; ++i)
+        {
+            const Scalar a = -twist * i / n;
+            normals[i] = normals[i] * cos(a) + tangents[i].crossProduct(normals[i]) * sin(a);
+        }
+    }
+    const size_t rings = closedPath ? n : n - 1;
+    Vertices vertices(m * n);
+    Faces faces(rings * m + (closedPath ? 0 : 2));
+    const size_t minRange = std::max<size_t>(1, 4096 / m);
+    Parallel::ForRanges(n, [&](const size_t begin, const size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                const Vertex& r = normals[i];
+                const Vertex s = tangents[i].crossProduct(r);
+                for (size_t j = 0; j < m; ++j)
+                {
+                    vertices[i * m + j] = path[i] + r * profile[j].x + s * profile[j].y;
+                }
+            }
+        }, minRange);
+    Parallel::ForRanges(rings, [&](const size_t begin, const size_t end)
+        {
+            for (size_t k = begin; k < end; ++k)
+            {
+                const Index lower = (Index)(k * m);
+                const Index upper = (Index)(((k + 1) % n) * m);
+                for (Index i = 0, j = (Index)(m - 1); i < m; j = i, ++i)
+                {
+                    const Index quad[4] = { (Index)(lower + j), (Index)(lower + i), (Index)(upper + i), (Index)(upper + j) };
+                    faces[k * m + i].set(quad, 4);
+                }
+            }
+        }, minRange);
+    if (!closedPath)
+    {
+        // caps, the first one reversed
+        std::vector<Index> first(m), last(m);
+        for (size_t i = 0; i < m; ++i)
+        {
+            first[i] = (Index)(m - i - 1);
+            last[i] = (Index)((n - 1) * m + i);
+        }
+        faces[rings * m].set(first);
+        faces[rings * m + 1].set(last);
+    }
+    return Shape(std::move(vertices), std::move(faces));
+}
+
+Shape ShapeFactory::Revolve(const Contour2D& profile, const Vertex& axis, const size_t& segments)
+{
+    const size_t m = profile.size();
+    if (m < 3 || segments < 3)
+    {
+        throw std::invalid_argument("a revolve needs a profile of 3 points and 3 segments");
+    }
+    if (axis == Vertex(0, 0, 0))
+    {
+        throw std::invalid_argument("the axis of a revolve can't be zero");
+    }
+    const Vertex a = axis / axis.length();
+    const Vertex helper = std::abs(a.x) < 0.9 ? Vertex(1, 0, 0) : Vertex(0, 1, 0);
+    Vertex e1 = helper - a * a.innerProduct(helper);
+    e1 /= e1.length();
+    const Vertex e2 = a.crossProduct(e1);
+    // points on the axis get one vertex, the others a circle
+    Scalar extent = 0;
+    for (const auto& p : profile)
+    {
+        extent = std::max(extent, std::max(std::abs(p.x), std::abs(p.y)));
+    }
+    const Scalar onAxis = extent * Limits<Scalar>::CompareEpsilon;
+    std::vector<size_t> first(m + 1, 0);
+    for (size_t j = 0; j < m; ++j)
+    {
+        if (profile[j].x < -onAxis)
+        {
+            throw std::invalid_argument("the profile of a revolve can't cross the axis");
+        }
+        first[j + 1] = first[j] + (profile[j].x <= onAxis ? 1 : segments);
+    }
+    requireIndexRange(first[m]);
+    auto pole = [&](const size_t j) { return first[j + 1] - first[j] == 1; };
+    // faces per profile edge j-1 -> j
+    std::vector<size_t> firstFace(m + 1, 0);
+    for (size_t j = 0; j < m; ++j)
+    {
+        firstFace[j + 1] = firstFace[j] + (pole(j) && pole((j + m - 1) % m) ? 0 : segments);
+    }
+    Vertices vertices(first[m]);
+    Faces faces(firstFace[m]);
+    const size_t minRange = std::max<size_t>(1, 4096 / segments);
+    Parallel::ForRanges(m, [&](const size_t begin, const size_t end)
+        {
+            for (size_t j = begin; j < end; ++j)
+            {
+                const Point& p = profile[j];
+                if (pole(j))
+                {
+                    vertices[first[j]] = a * p.y;
+                    continue;
+                }
+                CircleSteps step(segments);
+                for (size_t k = 0; k < segments; ++k, step.next())
+                {
+                    vertices[first[j] + k] = (e1 * step.c + e2 * step.s) * p.x + a * p.y;
+                }
+            }
+        }, minRange);
+    Parallel::ForRanges(m, [&](const size_t begin, const size_t end)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                const size_t j = (i + m - 1) % m;
+                if (firstFace[i + 1] == firstFace[i])
+                {
+                    continue;
+                }
+                for (size_t k = 0; k < segments; ++k)
+                {
+                    const size_t l = (k + 1) % segments;
+                    auto& face = faces[firstFace[i] + k];
+                    if (pole(j))
+                    {
+                        const Index triangle[3] = { (Index)first[j], (Index)(first[i] + l), (Index)(first[i] + k) };
+                        face.set(triangle, 3);
+                    }
+                    else if (pole(i))
+                    {
+                        const Index triangle[3] = { (Index)(first[j] + k), (Index)(first[j] + l), (Index)first[i] };
+                        face.set(triangle, 3);
+                    }
+                    else
+                    {
+                        const Index quad[4] = { (Index)(first[j] + k), (Index)(first[j] + l), (Index)(first[i] + l), (Index)(first[i] + k) };
+                        face.set(quad, 4);
+                    }
+                }
+            }
+        }, minRange);
+    return Shape(std::move(vertices), std::move(faces));
+}
+
+Shape ShapeFactory::LoopSubdivision(const Shape& shape, const size_t& levels)
+{
+    for (const auto& face : shape.geometry->faces)
+    {
+        if (face.size() != 3)
+        {
+            throw std::invalid_argument("Loop subdivision needs a triangle shape");
+        }
+    }
+    auto mesh = SubdivisionMesh::FromShape(shape.getVertices(), shape.geometry->faces);
+    for (size_t level = 0; level < levels; ++level)
+    {
+        mesh = LoopLevel(mesh);
+    }
+    Shape res(std::move(mesh.vertices), mesh.toFaces());
+    res.transformation = shape.transformation;
+    return res;
+}
+
+Shape ShapeFactory::CatmullClarkSubdivision(const Shape& shape, const size_t& levels)
+{
+    auto mesh = SubdivisionMesh::FromShape(shape.getVertices(), shape.geometry->faces);
+    for (size_t level = 0; level < levels; ++level)
+    {
+        mesh = CatmullClarkLevel(mesh);
+    }
+    Shape res(std::move(mesh.vertices), mesh.toFaces());
+    res.transformation = shape.transformation;
+    return res;
+}
+
+size_t ShapeFactory::Segments(const Scalar& radius, const Scalar& tolerance)
+{
+    // the chord of a segment deviates radius * (1 - cos(pi / segments)) from the circle
+    if (tolerance <= 0 || radius <= 0)
+    {
+        throw std::invalid_argument("radius and tolerance must be positive");
+    }
+    if (tolerance >= radius)
+    {
+        return 3;
+    }
+    return std::max<size_t>(3, (size_t)std::ceil(Constants::Pi / std::acos(1 - tolerance / radius)));
+}
+
+Shape ShapeFactory::Sphere(const Vertex& center, const Scalar& radius, const size_t& segments, const size_t& rings)
+{
+    requireSegments(segments);
+    requireRings(rings, 2);
+    const Scalar step = Constants::Pi / rings;
+    return Lathe(center, radius, -radius, segments, rings - 1, [&](const size_t k)
+        {
+            const Scalar a = (k + 1) * step;
+            return Point(radius * sin(a), radius * cos(a));
+        });
+}
+
+Shape ShapeFactory::Icosphere(const Vertex& center, const Scalar& radius, const size_t& levels)
+{
+    const Scalar t = (1 + sqrt(5)) / 2;
+    SubdivisionMesh mesh;
+    mesh.vertices =
+    {
+        {-1,  t,  0}, { 1,  t,  0}, {-1, -t,  0}, { 1, -t,  0},
+        { 0, -1,  t}, { 0,  1,  t}, { 0, -1, -t}, { 0,  1, -t},
+        { t,  0, -1}, { t,  0,  1}, {-t,  0, -1}, {-t,  0,  1},
+    };
+    mesh.corners =
+    {
+        0, 11,  5,   0,  5,  1,   0,  1,  7,   0,  7, 10,   0, 10, 11,
+        1,  5,  9,   5, 11,  4,  11, 10,  2,  10,  7,  6,   7,  1,  8,
+        3,  9,  4,   3,  4,  2,   3,  2,  6,   3,  6,  8,   3,  8,  9,
+        4,  9,  5,   2,  4, 11,   6,  2, 10,   8,  6,  7,   9,  8,  1,
+    };
+    mesh.faceOffsets.resize(21);
+    for (uint32_t i = 0; i < mesh.faceOffsets.size(); ++i)
+    {
+        mesh.faceOffsets[i] = 3 * i;
+    }
+    for (size_t level = 0; level <= levels; ++level)
+    {
+        if (level > 0)
+        {
+            mesh = LoopLevel(mesh, false);
+        }
+        for (auto& vertex : mesh.vertices)
+        {
+            vertex /= vertex.length();
+        }
+    }
+    for (auto& vertex : mesh.vertices)
+    {
+        vertex *= radius;
+        vertex += center;
+    }
+    return Shape(std::move(mesh.vertices), mesh.toFaces());
+}
+
+Shape ShapeFactory::Cylinder(const Vertex& center, const Scalar& radius, const Scalar& height, const size_t& segments)
+{
+    requireSegments(segments);
+    requireIndexRange(2 * segments);
+    const Index n = (Index)segments;
+    Vertices vertices(2 * segments);
+    Faces faces;
+    faces.reserve(segments + 2);
+    CircleSteps step(segments);
+    for (Index i = 0; i < n; ++i, step.next())
+    {
+        const Scalar x = center.x + radius * step.c;
+        const Scalar y = center.y + radius * step.s;
+        vertices[i] = Vertex(x, y, center.z - height / 2);
+        vertices[n + i] = Vertex(x, y, center.z + height / 2);
+    }
+    for (Index i = 0, j = n - 1; i < n; j = i, ++i)
+    {
+        faces.emplace_back(Face{ j, i, (Index)(n + i), (Index)(n + j) });
+    }
+    // caps, bottom one reversed
+    std::vector<Index> points(n);
+    for (Index i = 0; i < n; ++i)
+    {
+        points[i] = n - i - 1;
+    }
+    faces.emplace_back(points);
+    for (Index i = 0; i < n; ++i)
+    {
+        points[i] = n + i;
+    }
+    faces.emplace_back(points);
+    return Shape(std::move(vertices), std::move(faces));
+}
+
+Shape ShapeFactory::Cone(const Vertex& center, const Scalar& radius, const Scalar& height, const size_t& segments)
+{
+    requireSegments(segments);
+    requireIndexRange(segments + 1);
+    const Index n = (Index)segments;
+    Vertices vertices(segments + 1);
+    Faces faces;
+    faces.reserve(segments + 1);
+    CircleSteps step(segments);
+    for (Index i = 0; i < n; ++i, step.next())
+    {
+        vertices[i] = Vertex(center.x + radius * step.c, center.y + radius * step.s, center.z);
+    }
+    vertices[n] = Vertex(center.x, center.y, center.z + height);
+    for (Index i = 0, j = n - 1; i < n; j = i, ++i)
+    {
+        faces.emplace_back(Face{ j, i, n });
+    }
+    // base, reversed
+    std::vector<Index> points(n);
+    for (Index i = 0; i < n; ++i)
+    {
+        points[i] = n - i - 1;
+    }
+    faces.emplace_back(points);
+    return Shape(std::move(vertices), std::move(faces));
+}
+
+Shape ShapeFactory::Torus(const Vertex& center, const Scalar& majorRadius, const Scalar& minorRadius, const size_t& majorSegments, const size_t& minorSegments)
+{
+    requireSegments(majorSegments);
+    requireSegments(minorSegments);
+    requireIndexRange(majorSegments * minorSegments);
+    Vertices vertices(majorSegments * minorSegments);
+    Faces faces;
+    faces.reserve(majorSegments * minorSegments);
+    CircleSteps major(majorSegments);
+    for (size_t i = 0; i < majorSegments; ++i, major.next())
+    {
+        CircleSteps minor(minorSegments);
+        for (size_t j = 0; j < minorSegments; ++j, minor.next())
+        {
+            const Scalar r = majorRadius + minorRadius * minor.c;
+            vertices[i * minorSegments + j] = Vertex(center.x + r * major.c, center.y + r * major.s, center.z + minorRadius * minor.s);
+        }
+    }
+    const Index m = (Index)minorSegments;
+    for (Index i = 0, pi = (Index)(majorSegments - 1); i < majorSegments; pi = i, ++i)
+    {
+        for (Index j = 0, pj = m - 1; j < m; pj = j, ++j)
+        {
+            faces.emplace_back(Face{ (Index)(pi * m + pj), (Index)(i * m + pj), (Index)(i * m + j), (Index)(pi * m + j) });
+        }
+    }
+    return Shape(std::move(vertices), std::move(faces));
+}
+
+Shape ShapeFactory::Capsule(const Vertex& center, const Scalar& radius, const Scalar& height, const size_t& segments, const size_t& rings)
+{
+    requireSegments(segments);
+    requireRings(rings, 1);
+    // rings circles per half sphere, the last one of each is the equator
+    const Scalar step = Constants::Pi / (2 * rings);
+    return Lathe(center, height / 2 + radius, -height / 2 - radius, segments, 2 * rings, [&](const size_t k)
+        {
+            if (k < rings)
+            {
+                const Scalar a = (k + 1) * step;
+                return Point(radius * sin(a), height / 2 + radius * cos(a));
+            }
+            const Scalar a = (2 * rings - k) * step;
+            return Point(radius * sin(a), -height / 2 - radius * cos(a));
+        });
+}
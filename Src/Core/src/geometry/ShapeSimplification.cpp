@@ -0,0 +1,389 @@
+﻿#include <algorithm>
+#include <array>
+#include <cmath>
+#include <queue>
+#include <vector>
+
+#include "internal/geometry/Shape.h"
+
+//
+// Quadric error edge collapse, see "Surface Simplification Using Quadric
+// Error Metrics" (Garland, Heckbert 1997).
+//
+// Every vertex gets a quadric: the sum of the squared distances to the
+// planes of its triangles. Collapsing an edge merges the quadrics of both
+// end points, the new vertex is placed where the merged quadric is minimal,
+// and the quadric value at that point is the cost of the collapse.
+// The cheapest collapse is done first.
+//
+namespace
+{
+    // Symmetric 4x4 matrix [a b c d]^T [a b c d] summed over planes
+    // ax + by + cz + d = 0, stored as the upper triangle.
+    struct Quadric
+    {
+        std::array<Scalar, 10> q = {};
+
+        void addPlane(const Vertex& n, const Scalar& d, const Scalar& weight)
+        {
+            q[0] += weight * n.x * n.x;
+            q[1] += weight * n.x * n.y;
+            q[2] += weight * n.x * n.z;
+            q[3] += weight * n.x * d;
+            q[4] += weight * n.y * n.y;
+            q[5] += weight * n.y * n.z;
+            q[6] += weight * n.y * d;
+            q[7] += weight * n.z * n.z;
+            q[8] += weight * n.z * d;
+            q[9] += weight * d * d;
+        }
+
+        Quadric& operator += (const Quadric& other)
+        {
+            for (size_t i = 0; i < q.size(); ++i)
+            {
+                q[i] += other.q[i];
+            }
+            return *this;
+        }
+
+        Quadric operator + (const Quadric& other) const
+        {
+            return Quadric(*this) += other;
+        }
+
+        // sum of the squared distances from v to the planes
+        Scalar error(const Vertex& v) const
+        {
+            return q[0] * v.x * v.x + 2 * q[1] * v.x * v.y + 2 * q[2] * v.x * v.z + 2 * q[3] * v.x
+                 + q[4] * v.y * v.y + 2 * q[5] * v.y * v.z + 2 * q[6] * v.y
+                 + q[7] * v.z * v.z + 2 * q[8] * v.z
+                 + q[9];
+        }
+
+        // Position with the minimal error, false if that is not unique
+        // (planes parallel, e.g. a flat region)
+        bool optimum(Vertex& v) const
+        {
+            // solve | q0 q1 q2 |       | q3 |
+            //       | q1 q4 q5 | v = - | q6 |
+            //       | q2 q5 q7 |       | q8 |
+            const Scalar c0 = q[4] * q[7] - q[5] * q[5];
+            const Scalar c1 = q[2] * q[5] - q[1] * q[7];
+            const Scalar c2 = q[1] * q[5] - q[2] * q[4];
+            const Scalar det = q[0] * c0 + q[1] * c1 + q[2] * c2;
+            const Scalar scale = std::max({ std::abs(q[0]), std::abs(q[4]), std::abs(q[7]) });
+            if (std::abs(det) <= 1e-9 * scale * scale * scale)
+            {
+                return false;
+            }
+            const Scalar c4 = q[0] * q[7] - q[2] * q[2];
+            const Scalar c5 = q[1] * q[2] - q[0] * q[5];
+            const Scalar c8 = q[0] * q[4] - q[1] * q[1];
+            // inverse is the adjugate / det, which is symmetric
+            v.x = -(c0 * q[3] + c1 * q[6] + c2 * q[8]) / det;
+            v.y = -(c1 * q[3] + c4 * q[6] + c5 * q[8]) / det;
+            v.z = -(c2 * q[3] + c5 * q[6] + c8 * q[8]) / det;
+            return true;
+        }
+    };
+
+    // Candidate collapse of edge keep-remove, remove is merged into keep
+    struct Collapse
+    {
+        Scalar cost;
+        Index keep;
+        Index remove;
+        uint32_t keepVersion;
+        uint32_t removeVersion;
+        Vertex position;
+
+        // reversed, so the priority queue returns the cheapest collapse first
+        bool operator < (const Collapse& other) const
+        {
+            return cost > other.cost;
+        }
+    };
+
+    // The planes of boundary edges are weighted more, so open borders stay in place
+    const Scalar boundaryWeight = 100;
+}
+
+Shape Shape::simplify(const size_t& targetFaceCount, const Scalar& maxError) const
+{
+    // Work on the triangulated shape, so requireEdges provides the triangle edges
+    size_t triangleCount = 0;
+    for (const auto& face : geometry->faces)
+    {
+        triangleCount += face.size() - 2;
+    }
+    Faces triangles;
+    triangles.reserve(triangleCount);
+    for (const auto& face : geometry->faces)
+    {
+        for (Index i = 1; i + 1 < face.size(); ++i)
+        {
+            triangles.emplace_back(std::vector<Index>{ face[0], face[i], face[i + 1] });
+        }
+    }
+    Shape work(getVertices(), triangles);
+    work.requireEdges();
+
+    Vertices positions = work.geometry->vertices;
+    std::vector<std::array<Index, 3>> corners(work.geometry->faces.size());
+    std::vector<bool> removedTriangles(corners.size(), false);
+    std::vector<std::vector<uint32_t>> vertexTriangles(positions.size());
+    std::vector<Quadric> quadrics(positions.size());
+    std::vector<bool> boundaryVertices(positions.size(), false);
+    std::vector<uint32_t> versions(positions.size(), 0);
+    for (uint32_t t = 0; t < corners.size(); ++t)
+    {
+        const auto& face = work.geometry->faces[t];
+        corners[t] = { face[0], face[1], face[2] };
+        Vertex n = (positions[face[1]] - positions[face[0]]).crossProduct(positions[face[2]] - positions[face[0]]);
+        Scalar length = n.length();
+        if (length > 0)
+        {
+            n /= length;
+            Scalar d = -n.innerProduct(positions[face[0]]);
+            for (const auto& point : face)
+            {
+                quadrics[point].addPlane(n, d, 1);
+            }
+        }
+        for (const auto& point : face)
+        {
+            vertexTriangles[point].emplace_back(t);
+        }
+    }
+    for (const auto& edge : work.geometry->edges)
+    {
+        if (edge.mirrorEdge == Edge::none)
+        {
+            // plane through the edge, perpendicular to the triangle
+            const auto& start = positions[edge.startVertex];
+            const auto& end = positions[edge.endVertex];
+            const auto& face = work.geometry->faces[edge.face];
+            Vertex n = (positions[face[1]] - positions[face[0]]).crossProduct(positions[face[2]] - positions[face[0]]);
+            Vertex m = (end - start).crossProduct(n);
+            Scalar length = m.length();
+            if (length > 0)
+            {
+                m /= length;
+                Scalar d = -m.innerProduct(start);
+                quadrics[edge.startVertex].addPlane(m, d, boundaryWeight);
+                quadrics[edge.endVertex].addPlane(m, d, boundaryWeight);
+            }
+            boundaryVertices[edge.startVertex] = true;
+            boundaryVertices[edge.endVertex] = true;
+        }
+    }
+
+    auto evaluate = [&](const Index keep, const Index remove)
+    {
+        Quadric q = quadrics[keep] + quadrics[remove];
+        Vertex position;
+        if (!q.optimum(position))
+        {
+            // pick the best of the end points and the midpoint
+            const Vertex options[3] = { positions[keep], positions[remove], (positions[keep] + positions[remove]) / 2 };
+            position = options[0];
+            for (const auto& option : options)
+            {
+                if (q.error(option) < q.error(position))
+                {
+                    position = option;
+                }
+            }
+        }
+        return Collapse{ std::max<Scalar>(0, q.error(position)), keep, remove, versions[keep], versions[remove], position };
+    };
+
+    std::priority_queue<Collapse> heap;
+    for (const auto& edge : work.geometry->edges)
+    {
+        if (edge.startVertex < edge.endVertex || edge.mirrorEdge == Edge::none)
+        {
+            heap.push(evaluate(edge.startVertex, edge.endVertex));
+        }
+    }
+
+    // Check if a collapse keeps the mesh manifold and doesn't fold any triangle over
+    std::vector<Index> keepNeighbours;
+    std::vector<Index> removeNeighbours;
+    auto neighbours = [&](const Index vertex, std::vector<Index>& result)
+    {
+        result.clear();
+        for (const auto& t : vertexTriangles[vertex])
+        {
+            if (!removedTriangles[t])
+            {
+                for (const auto& point : corners[t])
+                {
+                    if (point != vertex) result.emplace_back(point);
+                }
+            }
+        }
+        std::sort(result.begin(), result.end());
+        result.erase(std::unique(result.begin(), result.end()), result.end());
+    };
+    auto contains = [](const std::array<Index, 3>& triangle, const Index vertex)
+    {
+        return triangle[0] == vertex || triangle[1] == vertex || triangle[2] == vertex;
+    };
+    auto allowed = [&](const Collapse& collapse)
+    {
+        size_t shared = 0;
+        for (const auto& t : vertexTriangles[collapse.remove])
+        {
+            if (!removedTriangles[t] && contains(corners[t], collapse.keep)) ++shared;
+        }
+        if (shared == 0 || shared > 2)
+        {
+            return false; // edge no longer exists, or is non-manifold
+        }
+        if (shared == 2 && boundaryVertices[collapse.keep] && boundaryVertices[collapse.remove])
+        {
+            return false; // interior edge between two borders, would pinch the shape
+        }
+        // link condition: the end points may only share the opposite vertices
+        // of the triangles on the edge
+        neighbours(collapse.keep, keepNeighbours);
+        neighbours(collapse.remove, removeNeighbours);
+        std::vector<Index> common;
+        std::set_intersection(keepNeighbours.begin(), keepNeighbours.end(), removeNeighbours.begin(), removeNeighbours.end(), std::back_inserter(common));
+        if (common.size() != shared)
+        {
+            return false;
+        }
+        // no triangle may flip
+        for (const auto vertex : { collapse.keep, collapse.remove })
+        {
+            for (const auto& t : vertexTriangles[vertex])
+            {
+                const auto& triangle = corners[t];
+                if (removedTriangles[t] || (contains(triangle, collapse.keep) && contains(triangle, collapse.remove)))
+                {
+                    continue;
+                }
+                Vertex before[3];
+                Vertex after[3];
+                for (size_t i = 0; i < 3; ++i)
+                {
+                    before[i] = positions[triangle[i]];
+                    after[i] = (triangle[i] == vertex) ? collapse.position : before[i];
+                }
+                Vertex n0 = (before[1] - before[0]).crossProduct(before[2] - before[0]);
+                Vertex n1 = (after[1] - after[0]).crossProduct(after[2] - after[0]);
+                if (n0.innerProduct(n1) <= 0)
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    };
+
+    const Scalar maxCost = (maxError < Numerics::Sqrt(Limits<Scalar>::MaxValue)) ? Numerics::Sqr(maxError) : Limits<Scalar>::MaxValue;
+    size_t remaining = corners.size();
+    while (remaining > targetFaceCount && !heap.empty())
+    {
+        Collapse collapse = heap.top();
+        heap.pop();
+        if (collapse.keepVersion != versions[collapse.keep] || collapse.removeVersion != versions[collapse.remove])
+        {
+            continue; // outdated
+        }
+        if (collapse.cost > maxCost)
+        {
+            break;
+        }
+        if (!allowed(collapse))
+        {
+            continue;
+        }
+        // merge remove into keep
+        positions[collapse.keep] = collapse.position;
+        quadrics[collapse.keep] += quadrics[collapse.remove];
+        boundaryVertices[collapse.keep] = boundaryVertices[collapse.keep] || boundaryVertices[collapse.remove];
+        auto& keepTriangles = vertexTriangles[collapse.keep];
+        for (const auto& t : vertexTriangles[collapse.remove])
+        {
+            if (removedTriangles[t])
+            {
+                continue;
+            }
+            auto& triangle = corners[t];
+            if (contains(triangle, collapse.keep))
+            {
+                removedTriangles[t] = true;
+                --remaining;
+            }
+            else
+            {
+                std::replace(triangle.begin(), triangle.end(), collapse.remove, collapse.keep);
+                keepTriangles.emplace_back(t);
+            }
+        }
+        vertexTriangles[collapse.remove].clear();
+        keepTriangles.erase(std::remove_if(keepTriangles.begin(), keepTriangles.end(), [&](const uint32_t t) { return removedTriangles[t]; }), keepTriangles.end());
+        ++versions[collapse.keep];
+        ++versions[collapse.remove];
+        // new candidates around the merged vertex
+        neighbours(collapse.keep, keepNeighbours);
+        for (const auto& neighbour : keepNeighbours)
+        {
+            heap.push(evaluate(collapse.keep, neighbour));
+        }
+    }
+
+    Faces result;
+    result.reserve(remaining);
+    for (size_t t = 0; t < corners.size(); ++t)
+    {
+        if (!removedTriangles[t])
+        {
+            result.emplace_back(std::vector<Index>{ corners[t][0], corners[t][1], corners[t][2] });
+        }
+    }
+    Shape simplified(positions, result);
+    simplified.transformation = transformation;
+    return simplified;
+}
+
+const Shape& Shape::getLevelOfDetail(const size_t& level) const
+{
+    requireLevelsOfDetail();
+    const size_t available = std::min(level, levelsOfDetail.size());
+    return (available == 0) ? *this : levelsOfDetail[available - 1];
+}
+
+// All levels are built at once, each level costs about half of the previous
+// one, so this is at most twice the cost of the first level.
+void Shape::requireLevelsOfDetail() const
+{
+    levelsOfDetailReady.call([&]()
+        {
+            std::vector<Shape> levels;
+            for (;;)
+            {
+                const Shape& previous = levels.empty() ? *this : levels.back();
+                size_t triangleCount = 0;
+                for (const auto& face : previous.geometry->faces)
+                {
+                    triangleCount += face.size() - 2;
+                }
+                if (triangleCount < 8)
+                {
+                    break;
+                }
+                Shape next = previous.simplify(triangleCount / 2);
+                if (next.geometry->faces.size() >= triangleCount)
+                {
+                    break; // no further reduction possible
+                }
+                levels.emplace_back(std::move(next));
+            }
+            levelsOfDetail = std::move(levels);
+        });
+}
@@ -0,0 +1,51 @@
+﻿#include <algorithm>
+#include <stdexcept>
+
+#include "internal/utilities/OutputBuffer.h"
+
+OutputBuffer::OutputBuffer(Sink sink, const size_t capacity)
+    : sink(std::move(sink))
+    , data(std::max<size_t>(capacity, 64))
+    , used(0)
+    , precision(5)
+{
+}
+
+OutputBuffer::OutputBuffer(std::ostream& os, const size_t capacity)
+    : OutputBuffer([&os](const char* data, const size_t size) { os.write(data, size); }, capacity)
+{
+}
+
+OutputBuffer::OutputBuffer(std::FILE* file, const size_t capacity)
+    : OutputBuffer([file](const char* data, const size_t size)
+        {
+            if (std::fwrite(data, 1, size, file) != size)
+            {
+                throw std::runtime_error("writing the output failed");
+            }
+        }, capacity)
+{
+    std::setvbuf(file, nullptr, _IONBF, 0);
+}
+
+OutputBuffer::~OutputBuffer()
+{
+    try
+    {
+        flush();
+    }
+    catch (...)
+    {
+        // call flush() first to see the error
+    }
+}
+
+void OutputBuffer::flush()
+{
+    if (used > 0)
+    {
+        const size_t size = used;
+        used = 0;
+        sink(data.data(), size);
+    }
+}
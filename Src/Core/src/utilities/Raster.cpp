@@ -0,0 +1,350 @@
+﻿#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <stdexcept>
+
+#include "internal/generic/Limits.h"
+#include "internal/generic/Parallel.h"
+
+#include "internal/utilities/Raster.h"
+
+namespace
+{
+    uint32_t Pack(const Raster::RGB& color, const Scalar& shade)
+    {
+        auto channel = [shade](const int value)
+        {
+            return (uint32_t)std::clamp((int)std::lround(value * shade), 0, 255);
+        };
+        return channel(color.r) | (channel(color.g) << 8) | (channel(color.b) << 16);
+    }
+
+    // Twice the signed area of the triangle a, b, p
+    Scalar EdgeFunction(const Scalar& ax, const Scalar& ay, const Scalar& bx, const Scalar& by, const Scalar& px, const Scalar& py)
+    {
+        return (bx - ax) * (py - ay) - (by - ay) * (px - ax);
+    }
+
+    void AppendBigEndian(std::vector<uint8_t>& data, const uint32_t value)
+    {
+        data.emplace_back((uint8_t)(value >> 24));
+        data.emplace_back((uint8_t)(value >> 16));
+        data.emplace_back((uint8_t)(value >> 8));
+        data.emplace_back((uint8_t)value);
+    }
+
+    uint32_t UpdateCrc(uint32_t crc, const uint8_t* data, const size_t size)
+    {
+        static const auto table = []()
+        {
+            std::array<uint32_t, 256> table;
+            for (uint32_t n = 0; n < 256; ++n)
+            {
+                uint32_t c = n;
+                for (int k = 0; k < 8; ++k)
+                {
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                }
+                table[n] = c;
+            }
+            return table;
+        }();
+        for (size_t i = 0; i < size; ++i)
+        {
+            crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        }
+        return crc;
+    }
+
+    void WriteChunk(OutputBuffer& out, const char* type, const std::vector<uint8_t>& data)
+    {
+        std::vector<uint8_t> header;
+        AppendBigEndian(header, (uint32_t)data.size());
+        header.insert(header.end(), type, type + 4);
+        uint32_t crc = UpdateCrc(0xFFFFFFFFu, header.data() + 4, 4);
+        crc = UpdateCrc(crc, data.data(), data.size()) ^ 0xFFFFFFFFu;
+        std::vector<uint8_t> footer;
+        AppendBigEndian(footer, crc);
+        out.write((const char*)header.data(), header.size());
+        if (!data.empty())
+        {
+            out.write((const char*)data.data(), data.size());
+        }
+        out.write((const char*)footer.data(), footer.size());
+    }
+}
+
+Raster::Raster(const int width, const int height, const SVG::ViewBox& viewBox, const SVG::View& view)
+    : width(width)
+    , height(height)
+    , viewBox(viewBox)
+    , view(view)
+{
+    if (width <= 0 || height <= 0)
+    {
+        throw std::invalid_argument("the raster size should be positive");
+    }
+    clear();
+}
+
+void Raster::setView(const SVG::View& view)
+{
+    this->view = view;
+}
+
+void Raster::clear(const RGB& background)
+{
+    triangles.clear();
+    pixels.assign((size_t)width * height, Pack(background, 1));
+    depths.assign((size_t)width * height, std::numeric_limits<Scalar>::infinity());
+}
+
+void Raster::addShape(const Shape& shape, const RGB& color)
+{
+    const auto& transform = view.getTransformation();
+    // as in the SVG output, max of the view box is its size
+    const Scalar scaleX = width / viewBox.max.x;
+    const Scalar scaleY = height / viewBox.max.y;
+    auto toPixels = [&](const Vertex& vertex)
+    {
+        const Vertex display = transform * vertex;
+        return Vertex((display.x - viewBox.min.x) * scaleX, (display.y - viewBox.min.y) * scaleY, display.z);
+    };
+    for (const auto& face : shape.getTransformedFaces())
+    {
+        if (face.size() < 3)
+        {
+            continue;
+        }
+        // the view looks along the positive z axis after the transformation
+        const uint32_t shaded = Pack(color, 0.25 + 0.75 * std::abs(transform.rotate(face.getNormal()).z));
+        // faces are convex, so a fan covers them
+        const Vertex first = toPixels(face[0]);
+        Vertex previous = toPixels(face[1]);
+        for (Index i = 2; i < face.size(); ++i)
+        {
+            const Vertex current = toPixels(face[i]);
+            triangles.push_back({ { first.x, previous.x, current.x }, { first.y, previous.y, current.y }, { first.z, previous.z, current.z }, shaded });
+            previous = current;
+        }
+    }
+}
+
+void Raster::render()
+{
+    if (triangles.empty())
+    {
+        return;
+    }
+    const int tilesX = (width + tileSize - 1) / tileSize;
+    const int tilesY = (height + tileSize - 1) / tileSize;
+    std::vector<std::vector<uint32_t>> bins((size_t)tilesX * tilesY);
+    for (size_t i = 0; i < triangles.size(); ++i)
+    {
+        const auto& t = triangles[i];
+        const Scalar minX = std::min({ t.x[0], t.x[1], t.x[2] });
+        const Scalar maxX = std::max({ t.x[0], t.x[1], t.x[2] });
+        const Scalar minY = std::min({ t.y[0], t.y[1], t.y[2] });
+        const Scalar maxY = std::max({ t.y[0], t.y[1], t.y[2] });
+        if (maxX < 0 || maxY < 0 || minX >= width || minY >= height)
+        {
+            continue;
+        }
+        // clamped before the conversion, which is undefined out of the int range
+        const int firstX = (int)std::max<Scalar>(0, minX) / tileSize;
+        const int lastX = (int)std::min<Scalar>(width - 1, maxX) / tileSize;
+        const int firstY = (int)std::max<Scalar>(0, minY) / tileSize;
+        const int lastY = (int)std::min<Scalar>(height - 1, maxY) / tileSize;
+        for (int y = firstY; y <= lastY; ++y)
+        {
+            for (int x = firstX; x <= lastX; ++x)
+            {
+                bins[(size_t)y * tilesX + x].emplace_back((uint32_t)i);
+            }
+        }
+    }
+    // the bins keep the order of the triangles, so the result doesn't depend on the threads
+    Parallel::For(bins.size(), [&](const size_t i)
+        {
+            drawTile((int)(i % tilesX), (int)(i / tilesX), bins[i]);
+        }, 1);
+    triangles.clear();
+}
+
+void Raster::drawTile(const int tileX, const int tileY, const std::vector<uint32_t>& bin)
+{
+    const int tileMinX = tileX * tileSize;
+    const int tileMinY = tileY * tileSize;
+    const int tileMaxX = std::min(tileMinX + tileSize, width) - 1;
+    const int tileMaxY = std::min(tileMinY + tileSize, height) - 1;
+    for (const auto index : bin)
+    {
+        const auto& t = triangles[index];
+        // vertex order with a positive area
+        int b = 1;
+        int c = 2;
+        Scalar area = EdgeFunction(t.x[0], t.y[0], t.x[1], t.y[1], t.x[2], t.y[2]);
+        if (area < 0)
+        {
+            std::swap(b, c);
+            area = -area;
+        }
+        if (area <= Limits<Scalar>::CompareEpsilon)
+        {
+            continue;
+        }
+        const int minX = (int)std::floor(std::max<Scalar>(tileMinX, std::min({ t.x[0], t.x[1], t.x[2] })));
+        const int maxX = (int)std::ceil(std::min<Scalar>(tileMaxX, std::max({ t.x[0], t.x[1], t.x[2] })));
+        const int minY = (int)std::floor(std::max<Scalar>(tileMinY, std::min({ t.y[0], t.y[1], t.y[2] })));
+        const int maxY = (int)std::ceil(std::min<Scalar>(tileMaxY, std::max({ t.y[0], t.y[1], t.y[2] })));
+        if (minX > maxX || minY > maxY)
+        {
+            continue;
+        }
+        // the edge functions (and the depth) change linearly with x
+        const Scalar dx0 = t.y[b] - t.y[c];
+        const Scalar dx1 = t.y[c] - t.y[0];
+        const Scalar dx2 = t.y[0] - t.y[b];
+        const Scalar dzx = (dx0 * t.z[0] + dx1 * t.z[b] + dx2 * t.z[c]) / area;
+        const int span = maxX - minX + 1;
+        for (int y = minY; y <= maxY; ++y)
+        {
+            const Scalar px = minX + 0.5;
+            const Scalar py = y + 0.5;
+            const Scalar w0 = EdgeFunction(t.x[b], t.y[b], t.x[c], t.y[c], px, py);
+            const Scalar w1 = EdgeFunction(t.x[c], t.y[c], t.x[0], t.y[0], px, py);
+            const Scalar w2 = EdgeFunction(t.x[0], t.y[0], t.x[b], t.y[b], px, py);
+            const Scalar z = (w0 * t.z[0] + w1 * t.z[b] + w2 * t.z[c]) / area;
+            uint32_t* pixelRow = pixels.data() + (size_t)y * width + minX;
+            Scalar* depthRow = depths.data() + (size_t)y * width + minX;
+            // branch free, so the compiler can vectorize the span
+            for (int i = 0; i < span; ++i)
+            {
+                const bool covered = (w0 + i * dx0 >= 0) & (w1 + i * dx1 >= 0) & (w2 + i * dx2 >= 0) & (z + i * dzx < depthRow[i]);
+                depthRow[i] = covered ? z + i * dzx : depthRow[i];
+                pixelRow[i] = covered ? t.color : pixelRow[i];
+            }
+        }
+    }
+}
+
+Raster::RGB Raster::getPixel(const int x, const int y)
+{
+    if (x < 0 || y < 0 || x >= width || y >= height)
+    {
+        throw std::out_of_range("pixel outside the raster");
+    }
+    render();
+    const uint32_t pixel = pixels[(size_t)y * width + x];
+    return RGB(pixel & 0xFF, (pixel >> 8) & 0xFF, (pixel >> 16) & 0xFF);
+}
+
+void Raster::writeToBuffer(OutputBuffer& out, const Format format)
+{
+    render();
+    switch (format)
+    {
+    case Format::PPM: writePPM(out); break;
+    case Format::PNG: writePNG(out); break;
+    }
+}
+
+void Raster::writeToStream(std::ostream& os, const Format format)
+{
+    OutputBuffer out(os);
+    writeToBuffer(out, format);
+}
+
+void Raster::writeToFile(const std::string& filename, const Format format)
+{
+    std::FILE* file = std::fopen(filename.c_str(), "wb");
+    if (!file)
+    {
+        throw std::runtime_error("unable to open " + filename);
+    }
+    try
+    {
+        OutputBuffer out(file);
+        writeToBuffer(out, format);
+        out.flush();
+    }
+    catch (...)
+    {
+        std::fclose(file);
+        throw;
+    }
+    std::fclose(file);
+}
+
+void Raster::writePPM(OutputBuffer& out)
+{
+    out << "P6\n" << width << ' ' << height << "\n255\n";
+    std::vector<char> row((size_t)width * 3);
+    for (int y = 0; y < height; ++y)
+    {
+        const uint32_t* pixelRow = pixels.data() + (size_t)y * width;
+        for (int x = 0; x < width; ++x)
+        {
+            row[x * 3 + 0] = (char)(pixelRow[x] & 0xFF);
+            row[x * 3 + 1] = (char)((pixelRow[x] >> 8) & 0xFF);
+            row[x * 3 + 2] = (char)((pixelRow[x] >> 16) & 0xFF);
+        }
+        out.write(row.data(), row.size());
+    }
+}
+
+void Raster::writePNG(OutputBuffer& out)
+{
+    static const char signature[] = { (char)0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    out.write(signature, sizeof(signature));
+
+    std::vector<uint8_t> header;
+    AppendBigEndian(header, width);
+    AppendBigEndian(header, height);
+    // 8 bit RGB, deflate, no interlacing
+    header.insert(header.end(), { 8, 2, 0, 0, 0 });
+    WriteChunk(out, "IHDR", header);
+
+    // the scanlines, each starts with filter type 0
+    const size_t stride = (size_t)width * 3 + 1;
+    std::vector<uint8_t> raw(stride * height);
+    for (int y = 0; y < height; ++y)
+    {
+        uint8_t* row = raw.data() + y * stride;
+        const uint32_t* pixelRow = pixels.data() + (size_t)y * width;
+        row[0] = 0;
+        for (int x = 0; x < width; ++x)
+        {
+            row[1 + x * 3 + 0] = (uint8_t)(pixelRow[x] & 0xFF);
+            row[1 + x * 3 + 1] = (uint8_t)((pixelRow[x] >> 8) & 0xFF);
+            row[1 + x * 3 + 2] = (uint8_t)((pixelRow[x] >> 16) & 0xFF);
+        }
+    }
+    // zlib stream of stored deflate blocks of at most 65535 bytes
+    const size_t maxBlock = 65535;
+    std::vector<uint8_t> zlib;
+    zlib.reserve(raw.size() + (raw.size() / maxBlock + 1) * 5 + 6);
+    zlib.insert(zlib.end(), { 0x78, 0x01 });
+    size_t done = 0;
+    do
+    {
+        const size_t size = std::min(maxBlock, raw.size() - done);
+        const bool last = done + size == raw.size();
+        zlib.insert(zlib.end(), { (uint8_t)(last ? 1 : 0), (uint8_t)size, (uint8_t)(size >> 8), (uint8_t)~size, (uint8_t)(~size >> 8) });
+        zlib.insert(zlib.end(), raw.begin() + done, raw.begin() + done + size);
+        done += size;
+    } while (done < raw.size());
+    uint32_t a = 1;
+    uint32_t b = 0;
+    for (const auto value : raw)
+    {
+        a = (a + value) % 65521;
+        b = (b + a) % 65521;
+    }
+    AppendBigEndian(zlib, (b << 16) | a);
+    WriteChunk(out, "IDAT", zlib);
+
+    WriteChunk(out, "IEND", {});
+}
@@ -1,12 +1,12 @@
 ﻿#include <algorithm>
-#include <fstream>
-#include <iomanip>
+#include <cstdio>
 #include <iostream>
-#include <sstream>
+#include <stdexcept>
 #include <string>
 #include <variant>
 
 #include "internal/generic/Normal.h"
+#include "internal/generic/Parallel.h"
 #include "internal/generic/Points.h"
 
 #include "internal/utilities/svg.h"
@@ -24,6 +24,8 @@ SVG::SVG(const int width, const int height, const ViewBox& viewBox, const View&
     , height(height)
     , viewBox(viewBox)
     , view(view)
+    , hiddenSurface(HiddenSurface::Painter)
+    , mergeCoplanarFaces(false)
     , style()
     , styles()
     , objects()
@@ -44,73 +46,137 @@ void SVG::setView(const View& view)
     this->view = view;
 }
 
-void SVG::writeToStream(std::ostream& os)
+void SVG::setHiddenSurface(const HiddenSurface hiddenSurface)
+{
+    this->hiddenSurface = hiddenSurface;
+}
+
+void SVG::setMergeCoplanarFaces(const bool mergeCoplanarFaces)
+{
+    this->mergeCoplanarFaces = mergeCoplanarFaces;
+}
+
+namespace
+{
+    void writeObject(OutputBuffer& out, const SVG::Axis& axis, const Vertices&)
+    {
+        out << "<path d=\"M"
+            << axis.tail.x << ',' << axis.tail.y << ' '
+            << axis.head.x << ',' << axis.head.y << '"'
+            << " class=\"S" << axis.style << "\" />\n";
+    }
+
+    void writeObject(OutputBuffer& out, const SVG::Path& path, const Vertices& pathVertices)
+    {
+        if (path.count > 0)
+        {
+            out << "<path d=\"M";
+            for (size_t i = path.first; i < path.first + path.count; ++i)
+            {
+                out << pathVertices[i].x << ',' << pathVertices[i].y << ' ';
+            }
+            const auto& p = pathVertices[path.first];
+            out << p.x << ',' << p.y << '"'
+                << " class=\"S" << path.style << "\" />\n";
+        }
+    }
+
+    void writeObject(OutputBuffer& out, const SVG::Text& text, const Vertices&)
+    {
+        out << "<text x=\"" << text.point.x << "\" y=\"" << text.point.y
+            << "\" class=\"S" << text.style << "\">" << text.text << "</text>\n";
+    }
+}
+
+void SVG::writeToBuffer(OutputBuffer& out)
 {
     // header
-    os << "<svg xmlns = \"http://www.w3.org/2000/svg\"\n"
-          "     xmlns:xlink = \"http://www.w3.org/1999/xlink\"\n"
-          "     width = \"" << width << "\" height = \"" << height << "\" viewBox = \"" << viewBox << "\">\n";
+    out << "<svg xmlns = \"http://www.w3.org/2000/svg\"\n"
+           "     xmlns:xlink = \"http://www.w3.org/1999/xlink\"\n"
+           "     width = \"" << width << "\" height = \"" << height << "\" viewBox = \"" << viewBox << "\">\n";
     // write styles
-    os << "<style>\n";
+    out << "<style>\n";
     for (const auto& style : styles)
     {
-        os << style;
+        out << style;
     }
-    os << "</style>\n";
+    out << "</style>\n";
     // definitions for axis
-    os  << "<defs>\n"
-        << "  <marker id = \"arrowTip\"\n"
-        << "          markerHeight = \"6.155\"\n"
-        << "          markerWidth = \"5.324\"\n"
-        << "          orient = \"auto-start-reverse\"\n"
-        << "          preserveAspectRatio = \"xMidYMid\"\n"
-        << "          refX = \"0\"\n"
-        << "          refY = \"0\"\n"
-        << "          style = \"overflow:visible\"\n"
-        << "          viewBox = \"0 0 5.324 6.155\">\n"
-        << "    <path d = \"m5.77 0-8.65 5V-5Z\"\n"
-        << "          class = \"S0\"\n"
-        << "          transform = \"scale(.5)\" />\n"
-        << "  </marker>\n"
-        << "</defs>\n";
-    // sort the objects by depth
-    std::sort(objects.begin(), objects.end(), [](auto const& a, auto const& b)
-        {
-            return std::visit([](auto const& lhs, auto const& rhs) { return lhs.z < rhs.z; }, a, b);
-        });
-    // write all objects
-    for (const auto& object : objects)
+    out << "<defs>\n"
+           "  <marker id = \"arrowTip\"\n"
+           "          markerHeight = \"6.155\"\n"
+           "          markerWidth = \"5.324\"\n"
+           "          orient = \"auto-start-reverse\"\n"
+           "          preserveAspectRatio = \"xMidYMid\"\n"
+           "          refX = \"0\"\n"
+           "          refY = \"0\"\n"
+           "          style = \"overflow:visible\"\n"
+           "          viewBox = \"0 0 5.324 6.155\">\n"
+           "    <path d = \"m5.77 0-8.65 5V-5Z\"\n"
+           "          class = \"S0\"\n"
+           "          transform = \"scale(.5)\" />\n"
+           "  </marker>\n"
+           "</defs>\n";
+    // write all objects in drawing order
+    Vertices vertices;
+    for (const auto& object : orderObjects(vertices))
     {
-        std::visit([&os](auto& arg) { os << arg; }, object);
+        std::visit([&](auto& arg) { writeObject(out, arg, vertices); }, object);
     }
     // footer
-    os << "</svg>\n";
+    out << "</svg>\n";
+}
+
+void SVG::writeToStream(std::ostream& os)
+{
+    OutputBuffer out(os);
+    writeToBuffer(out);
 }
 
 void SVG::writeToFile(const std::string& filename)
 {
-    std::fstream f(filename, std::fstream::out | std::fstream::trunc);
-    writeToStream(f);
+    std::FILE* file = std::fopen(filename.c_str(), "wb");
+    if (!file)
+    {
+        throw std::runtime_error("unable to open " + filename);
+    }
+    try
+    {
+        OutputBuffer out(file);
+        writeToBuffer(out);
+        out.flush();
+    }
+    catch (...)
+    {
+        std::fclose(file);
+        throw;
+    }
+    std::fclose(file);
 }
 
 std::string SVG::writeToString()
 {
-    std::stringstream s;
-    writeToStream(s);
-    return s.str();
+    std::string s;
+    {
+        OutputBuffer out([&s](const char* data, const size_t size) { s.append(data, size); });
+        writeToBuffer(out);
+    }
+    return s;
 }
 
-void SVG::setStyleId(Style& style)
+size_t SVG::setStyleId(Style& style)
 {
     auto iter = std::find(styles.rbegin(), styles.rend(), style);
     if (iter==styles.rend())
     {
         style.id = "S" + std::to_string(styles.size());
         styles.emplace_back(style);
+        return styles.size() - 1;
     }
     else
     {
         style.id = iter->id;
+        return std::distance(iter, styles.rend()) - 1;
     }
 }
 
@@ -118,7 +184,7 @@ void SVG::addAxis(const Vertex& center, const double length)
 {
     auto axisStyle = style;
     axisStyle.custom = "marker-end: url(#arrowTip)";
-    setStyleId(axisStyle);
+    const size_t axisStyleIndex = setStyleId(axisStyle);
     Vertex axis[6] =
     {
         // X
@@ -137,7 +203,7 @@ void SVG::addAxis(const Vertex& center, const double length)
         Vertex tail = project(axis[i * 2]);
         Vertex head = project(axis[i * 2 + 1]);
         if (!i) z = tail.z;
-        objects.emplace_back(SVG::Axis(axisStyle.id, { tail.x, tail.y }, { head.x,head.y }, z));
+        objects.emplace_back(SVG::Axis(axisStyleIndex, { tail.x, tail.y }, { head.x,head.y }, z));
         // TODO: make this optional
         style.fill = axisStyle.fill;
         style.stroke = Color::Predefined::None;
@@ -145,32 +211,258 @@ void SVG::addAxis(const Vertex& center, const double length)
     }
 }
 
-void SVG::addShape(const Shape& shape, const Vertex& center)
+void SVG::addShape(const Shape& shape, const Vertex& center, const bool cullBackFaces)
 {
-    setStyleId(style);
-    auto transform = view.getTransformation();
+    size_t styleIndex;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        styleIndex = setStyleId(style);
+    }
+    Objects shapeObjects;
+    Vertices shapeVertices;
+    projectShape(shape, styleIndex, cullBackFaces, shapeObjects, shapeVertices);
+    std::lock_guard<std::mutex> lock(mutex);
+    appendObjects(shapeObjects, shapeVertices);
+}
+
+void SVG::addShapes(const std::vector<Shape>& shapes, const bool cullBackFaces)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    const size_t styleIndex = setStyleId(style);
+    // one buffer per shape, merged in order afterwards
+    std::vector<Objects> shapeObjects(shapes.size());
+    std::vector<Vertices> shapeVertices(shapes.size());
+    Parallel::For(shapes.size(), [&](const size_t i)
+        {
+            projectShape(shapes[i], styleIndex, cullBackFaces, shapeObjects[i], shapeVertices[i]);
+        }, 16);
+    for (size_t i = 0; i < shapes.size(); ++i)
+    {
+        appendObjects(shapeObjects[i], shapeVertices[i]);
+    }
+}
+
+void SVG::projectShape(const Shape& shape, const size_t styleIndex, const bool cullBackFaces, Objects& shapeObjects, Vertices& shapeVertices) const
+{
+    if (mergeCoplanarFaces)
+    {
+        projectMergedShape(shape, styleIndex, cullBackFaces, shapeObjects, shapeVertices);
+        return;
+    }
+    const auto& transform = view.getTransformation();
+    shapeObjects.reserve(shape.getRawFaces().size());
     for (const auto& face : shape.getTransformedFaces())
     {
-        Points points;
-        points.reserve(face.size());
+        // the view looks along the positive z axis after the transformation
+        if (cullBackFaces && transform.rotate(face.getNormal()).z > 0)
+        {
+            continue;
+        }
+        const size_t first = shapeVertices.size();
         Scalar z = 0;
         for (const auto& vertex : face)
         {
             auto display = transform * vertex;
-            points.emplace_back(display.x, display.y);
+            shapeVertices.emplace_back(display);
             z += display.z;
         }
-        objects.emplace_back(SVG::Path(style.id, points, z / face.size()));
+        shapeObjects.emplace_back(SVG::Path(styleIndex, first, face.size(), z / face.size()));
+    }
+}
+
+namespace
+{
+    uint32_t FindGroup(std::vector<uint32_t>& groups, uint32_t face)
+    {
+        while (groups[face] != face)
+        {
+            groups[face] = groups[groups[face]];
+            face = groups[face];
+        }
+        return face;
+    }
+
+    // b is on the line from a to c, between them
+    bool Between(const Vertex& a, const Vertex& b, const Vertex& c)
+    {
+        const Vertex ab = b - a;
+        const Vertex bc = c - b;
+        const Scalar tolerance = 1e-9 * ab.length() * bc.length();
+        return ab.crossProduct(bc).length() <= tolerance && ab.innerProduct(bc) > 0;
+    }
+
+    // Remove the points on the line between their neighbours
+    void RemoveStraightPoints(Vertices& loop)
+    {
+        Vertices kept;
+        kept.reserve(loop.size());
+        for (const auto& point : loop)
+        {
+            while (kept.size() >= 2 && Between(kept[kept.size() - 2], kept.back(), point))
+            {
+                kept.pop_back();
+            }
+            kept.emplace_back(point);
+        }
+        size_t begin = 0;
+        bool changed = true;
+        while (changed && kept.size() - begin >= 3)
+        {
+            changed = false;
+            if (Between(kept[kept.size() - 2], kept.back(), kept[begin]))
+            {
+                kept.pop_back();
+                changed = true;
+            }
+            else if (Between(kept.back(), kept[begin], kept[begin + 1]))
+            {
+                ++begin;
+                changed = true;
+            }
+        }
+        loop.assign(kept.begin() + begin, kept.end());
     }
 }
 
+void SVG::projectMergedShape(const Shape& shape, const size_t styleIndex, const bool cullBackFaces, Objects& shapeObjects, Vertices& shapeVertices) const
+{
+    const auto& transform = view.getTransformation();
+    const auto& faces = shape.getRawFaces();
+    const auto& edges = shape.getEdges();
+    const auto& normals = shape.getTransformedNormals();
+    const auto& vertices = shape.getTransformedVertices();
+
+    // group the faces over the edges between faces in the same plane
+    std::vector<uint32_t> groups(faces.size());
+    std::vector<uint32_t> firstEdges(faces.size());
+    uint32_t first = 0;
+    for (uint32_t face = 0; face < faces.size(); ++face)
+    {
+        groups[face] = face;
+        firstEdges[face] = first;
+        first += faces[face].size();
+    }
+    for (const auto& edge : edges)
+    {
+        if (edge.mirrorEdge != Edge::none)
+        {
+            const uint32_t other = edges[edge.mirrorEdge].face;
+            if (normals[edge.face].innerProduct(normals[other]) >= 1 - 1e-9)
+            {
+                const uint32_t a = FindGroup(groups, edge.face);
+                const uint32_t b = FindGroup(groups, other);
+                groups[std::max(a, b)] = std::min(a, b);
+            }
+        }
+    }
+    std::vector<std::vector<uint32_t>> members(faces.size());
+    for (uint32_t face = 0; face < faces.size(); ++face)
+    {
+        groups[face] = FindGroup(groups, face);
+        members[groups[face]].emplace_back(face);
+    }
+    // edges between faces of one group are left out
+    auto inside = [&](const uint32_t edge)
+    {
+        const uint32_t mirror = edges[edge].mirrorEdge;
+        return mirror != Edge::none && groups[edges[mirror].face] == groups[edges[edge].face];
+    };
+
+    auto addPath = [&](const Vertices& loop, const Normal& normal)
+    {
+        // the view looks along the positive z axis after the transformation
+        if (loop.size() < 3 || (cullBackFaces && transform.rotate(normal).z > 0))
+        {
+            return;
+        }
+        const size_t start = shapeVertices.size();
+        Scalar z = 0;
+        for (const auto& vertex : loop)
+        {
+            auto display = transform * vertex;
+            shapeVertices.emplace_back(display);
+            z += display.z;
+        }
+        shapeObjects.emplace_back(SVG::Path(styleIndex, start, loop.size(), z / loop.size()));
+    };
+
+    std::vector<bool> used(edges.size(), false);
+    Vertices loop;
+    for (uint32_t group = 0; group < faces.size(); ++group)
+    {
+        const auto& groupFaces = members[group];
+        if (groupFaces.empty())
+        {
+            continue;
+        }
+        // walk the outline, around the end point of each edge until the next outer edge
+        size_t loops = 0;
+        bool valid = true;
+        loop.clear();
+        for (const auto face : groupFaces)
+        {
+            for (uint32_t start = firstEdges[face]; valid && start < firstEdges[face] + faces[face].size(); ++start)
+            {
+                if (used[start] || inside(start))
+                {
+                    continue;
+                }
+                ++loops;
+                size_t steps = 0;
+                uint32_t edge = start;
+                do
+                {
+                    used[edge] = true;
+                    loop.emplace_back(vertices[edges[edge].startVertex]);
+                    edge = edges[edge].nextEdge;
+                    while (inside(edge) && ++steps <= edges.size())
+                    {
+                        edge = edges[edges[edge].mirrorEdge].nextEdge;
+                    }
+                    valid = ++steps <= edges.size() && (edge == start || !used[edge]);
+                } while (valid && edge != start);
+            }
+        }
+        if (groupFaces.size() > 1 && valid && loops == 1)
+        {
+            RemoveStraightPoints(loop);
+            addPath(loop, normals[group]);
+            continue;
+        }
+        // holes or a broken outline, keep the faces
+        for (const auto face : groupFaces)
+        {
+            loop.clear();
+            for (const auto index : faces[face])
+            {
+                loop.emplace_back(vertices[index]);
+            }
+            addPath(loop, normals[face]);
+        }
+    }
+}
+
+void SVG::appendObjects(Objects& newObjects, const Vertices& newVertices)
+{
+    const size_t offset = pathVertices.size();
+    for (auto& object : newObjects)
+    {
+        if (auto path = std::get_if<Path>(&object))
+        {
+            path->first += offset;
+        }
+    }
+    objects.insert(objects.end(), std::make_move_iterator(newObjects.begin()), std::make_move_iterator(newObjects.end()));
+    pathVertices.insert(pathVertices.end(), newVertices.begin(), newVertices.end());
+}
+
 void SVG::addText(const std::string& text, const Vertex& start)
 {
     auto textStyle = style;
     textStyle.custom = "text-anchor: \"start\";\n  font: italic 13px sans-serif;";
-    setStyleId(textStyle);
+    const size_t textStyleIndex = setStyleId(textStyle);
     Vertex p = project(start);
-    objects.emplace_back(SVG::Text(textStyle.id, text, { p.x,p.y }, p.z));
+    objects.emplace_back(SVG::Text(textStyleIndex, text, { p.x,p.y }, p.z));
 
 }
 
@@ -185,47 +477,46 @@ std::ostream& operator << (std::ostream& os, SVG& svg)
     return os;
 }
 
-std::ostream& operator << (std::ostream& os, const SVG::ViewBox& viewBox)
+OutputBuffer& operator << (OutputBuffer& out, const SVG::ViewBox& viewBox)
 {
-    return os << viewBox.min.x << " " << viewBox.min.y << " " << viewBox.max.x << " " << viewBox.max.y;
+    return out << viewBox.min.x << ' ' << viewBox.min.y << ' ' << viewBox.max.x << ' ' << viewBox.max.y;
 }
 
-std::ostream& operator<<(std::ostream& os, const SVG::StrokeLineJoin& strokeLineJoin)
+OutputBuffer& operator<<(OutputBuffer& out, const SVG::StrokeLineJoin& strokeLineJoin)
 {
     switch (strokeLineJoin)
     {
-    case SVG::StrokeLineJoin::arcs: return os << "arcs";
-    case SVG::StrokeLineJoin::bevel: return os << "bevel";
-    case SVG::StrokeLineJoin::miter: return os << "miter";
-    case SVG::StrokeLineJoin::miterclip: return os << "miter-clip";
-    case SVG::StrokeLineJoin::round: return os << "round";
+    case SVG::StrokeLineJoin::arcs: return out << "arcs";
+    case SVG::StrokeLineJoin::bevel: return out << "bevel";
+    case SVG::StrokeLineJoin::miter: return out << "miter";
+    case SVG::StrokeLineJoin::miterclip: return out << "miter-clip";
+    case SVG::StrokeLineJoin::round: return out << "round";
     default:
         assert(false); // Oops. Add the missing enum value...
-        return os;
+        return out;
     }
 }
 
-std::ostream& operator<<(std::ostream& os, const SVG::Color& color)
+OutputBuffer& operator<<(OutputBuffer& out, const SVG::Color& color)
 {
     struct ColorWriter
     {
-        std::ostream& os;
-        std::ostream& operator () (const SVG::Color::RGB& rgb) 
-        { 
-            return os << "#" << std::hex << std::right << std::setfill('0') << std::setw(2) << rgb.r << std::setw(2) << rgb.g << std::setw(2) << rgb.b << std::dec;
+        OutputBuffer& out;
+        OutputBuffer& operator () (const SVG::Color::RGB& rgb)
+        {
+            return (out << '#').hex(rgb.r).hex(rgb.g).hex(rgb.b);
         }
-        std::ostream& operator () (const SVG::Color::Predefined& p) 
-        { 
-            return os << SVG::Color::predefinedColors[p];
+        OutputBuffer& operator () (const SVG::Color::Predefined& p)
+        {
+            return out << SVG::Color::predefinedColors[p];
         }
     };
-    return std::visit(ColorWriter{os}, color.data);
+    return std::visit(ColorWriter{out}, color.data);
 }
 
-std::ostream& operator<<(std::ostream& os, const SVG::Style& style)
+OutputBuffer& operator<<(OutputBuffer& out, const SVG::Style& style)
 {
-    return os
-        << "." << style.id << "\n"
+    out << '.' << style.id << "\n"
         << "{\n"
         << "  fill: " << style.fill << "; \n"
         << "  fill-opacity: " << style.fillOpacity << ";\n"
@@ -233,37 +524,42 @@ std::ostream& operator<<(std::ostream& os, const SVG::Style& style)
         << "  stroke: " << style.stroke << ";\n"
         << "  stroke-width: " << style.strokeWidth << ";\n"
         << "  stroke-opacity: " << style.strokeOpacity << ";\n"
-        << "  stroke-linejoin: " << style.strokeLineJoin << ";\n"
-        << (style.custom.empty() ? "}\n" : ("  " + style.custom + ";\n}\n"));
+        << "  stroke-linejoin: " << style.strokeLineJoin << ";\n";
+    if (!style.custom.empty())
+    {
+        out << "  " << style.custom << ";\n";
+    }
+    return out << "}\n";
 }
 
-std::ostream& operator<<(std::ostream& os, const SVG::Axis& axis)
+// The stream operators format through a small OutputBuffer
+
+std::ostream& operator << (std::ostream& os, const SVG::ViewBox& viewBox)
 {
-    return os << "<path d=\"M" << std::setprecision(5)
-              << axis.tail.x << "," << axis.tail.y << " "
-              << axis.head.x << "," << axis.head.y << "\""
-              << " class=\"" << axis.classId << "\" />\n";
+    OutputBuffer out(os, 256);
+    out << viewBox;
+    return os;
 }
 
-std::ostream& operator<<(std::ostream& os, const SVG::Path& path)
+std::ostream& operator<<(std::ostream& os, const SVG::StrokeLineJoin& strokeLineJoin)
 {
-    if (!path.points.empty())
-    {
-        os << "<path d=\"M" << std::setprecision(5);
-        for (const auto& p : path.points)
-        {
-            os << p.x << "," << p.y << " ";
-        }
-        const auto& p = path.points.front();
-        os << p.x << "," << p.y << "\"";
-        os << " class=\"" << path.classId << "\" />\n";
-    }
+    OutputBuffer out(os, 256);
+    out << strokeLineJoin;
+    return os;
+}
+
+std::ostream& operator<<(std::ostream& os, const SVG::Color& color)
+{
+    OutputBuffer out(os, 256);
+    out << color;
     return os;
 }
 
-std::ostream& operator<<(std::ostream& os, const SVG::Text& text)
+std::ostream& operator<<(std::ostream& os, const SVG::Style& style)
 {
-    return os << "<text x=\"" << text.point.x << "\" y=\"" << text.point.y << "\" class=\"" << text.classId << "\">" << text.text << "</text>\n";
+    OutputBuffer out(os, 1024);
+    out << style;
+    return os;
 }
 
 bool SVG::Style::operator==(const Style& other) const
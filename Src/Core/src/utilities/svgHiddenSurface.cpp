@@ -0,0 +1,588 @@
+﻿#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <variant>
+
+#include "internal/generic/Limits.h"
+#include "internal/generic/Parallel.h"
+#include "internal/generic/Predicates.h"
+#include "internal/geometry/Contour2D.h"
+
+#include "internal/utilities/svg.h"
+
+// After the view transformation the eye looks along the positive z axis,
+// so drawing back to front means drawing the largest depth first.
+
+namespace
+{
+    const size_t none = std::numeric_limits<size_t>::max();
+
+    struct Plane
+    {
+        Vertex normal;
+        Scalar offset = 0;
+
+        Scalar distance(const Vertex& point) const
+        {
+            return normal.innerProduct(point) - offset;
+        }
+    };
+
+    // True when the counterclockwise polygon has no reflex corner
+    bool IsConvex(const Points& polygon)
+    {
+        for (size_t i = 0; i < polygon.size(); ++i)
+        {
+            if (Predicates::Orient2D(polygon[i], polygon[(i + 1) % polygon.size()], polygon[(i + 2) % polygon.size()]) < 0)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // True when all points lie inside or on the convex counterclockwise polygon
+    bool ConvexContains(const Contour2D& polygon, const Contour2D& points)
+    {
+        for (size_t i = 0; i < polygon.size(); ++i)
+        {
+            const auto& a = polygon[i];
+            const auto& b = polygon[(i + 1) % polygon.size()];
+            for (const auto& point : points)
+            {
+                if (Predicates::Orient2D(a, b, point) < 0)
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    enum class Side
+    {
+        Coplanar,
+        Front,
+        Back,
+        Spanning,
+    };
+
+    // Plane through the polygon with Newell's method, false when it has no area
+    bool PolygonPlane(const SVG::Path& path, const Vertices& vertices, const Scalar& epsilon, Plane& plane)
+    {
+        if (path.count < 3)
+        {
+            return false;
+        }
+        Vertex normal(0, 0, 0);
+        Vertex center(0, 0, 0);
+        for (size_t i = 0; i < path.count; ++i)
+        {
+            const auto& a = vertices[path.first + i];
+            const auto& b = vertices[path.first + (i + 1) % path.count];
+            normal.x += (a.y - b.y) * (a.z + b.z);
+            normal.y += (a.z - b.z) * (a.x + b.x);
+            normal.z += (a.x - b.x) * (a.y + b.y);
+            center += a;
+        }
+        const Scalar length = normal.length();
+        if (length <= epsilon)
+        {
+            return false;
+        }
+        plane.normal = normal / length;
+        plane.offset = plane.normal.innerProduct(center / (Scalar)path.count);
+        return true;
+    }
+
+    Side Classify(const Plane& plane, const SVG::Path& path, const Vertices& vertices, const Scalar& epsilon)
+    {
+        bool front = false;
+        bool back = false;
+        for (size_t i = path.first; i < path.first + path.count; ++i)
+        {
+            const Scalar d = plane.distance(vertices[i]);
+            front |= d > epsilon;
+            back |= d < -epsilon;
+        }
+        return front ? (back ? Side::Spanning : Side::Front) : (back ? Side::Back : Side::Coplanar);
+    }
+
+    // Cut a spanning polygon in two, the new points are added to vertices
+    void Split(const Plane& plane, const SVG::Path& path, Vertices& vertices, const Scalar& epsilon, SVG::Path& front, SVG::Path& back)
+    {
+        Vertices frontPoints;
+        Vertices backPoints;
+        for (size_t i = 0; i < path.count; ++i)
+        {
+            const Vertex a = vertices[path.first + i];
+            const Vertex b = vertices[path.first + (i + 1) % path.count];
+            const Scalar da = plane.distance(a);
+            const Scalar db = plane.distance(b);
+            if (da >= -epsilon) frontPoints.emplace_back(a);
+            if (da <= epsilon) backPoints.emplace_back(a);
+            if ((da > epsilon && db < -epsilon) || (da < -epsilon && db > epsilon))
+            {
+                const Vertex p = a + (b - a) * (da / (da - db));
+                frontPoints.emplace_back(p);
+                backPoints.emplace_back(p);
+            }
+        }
+        front = SVG::Path(path.style, vertices.size(), frontPoints.size(), path.z);
+        vertices.insert(vertices.end(), frontPoints.begin(), frontPoints.end());
+        back = SVG::Path(path.style, vertices.size(), backPoints.size(), path.z);
+        vertices.insert(vertices.end(), backPoints.begin(), backPoints.end());
+    }
+
+    // Position of objects without a plane
+    Vertex Anchor(const SVG::Object& object, const Vertices& vertices)
+    {
+        struct AnchorVisitor
+        {
+            const Vertices& vertices;
+            Vertex operator () (const SVG::Axis& axis) const
+            {
+                return Vertex((axis.tail.x + axis.head.x) / 2, (axis.tail.y + axis.head.y) / 2, axis.z);
+            }
+            Vertex operator () (const SVG::Path& path) const
+            {
+                Vertex center(0, 0, 0);
+                for (size_t i = path.first; i < path.first + path.count; ++i)
+                {
+                    center += vertices[i];
+                }
+                return path.count > 0 ? center / (Scalar)path.count : Vertex(0, 0, path.z);
+            }
+            Vertex operator () (const SVG::Text& text) const
+            {
+                return Vertex(text.point.x, text.point.y, text.z);
+            }
+        };
+        return std::visit(AnchorVisitor{ vertices }, object);
+    }
+
+    Scalar Depth(const SVG::Object& object)
+    {
+        return std::visit([](const auto& arg) { return arg.z; }, object);
+    }
+
+    //
+    // BSP tree over the paths. Every node splits space with the plane of one
+    // path, the paths in that plane are stored in the node. Objects without
+    // a plane (axis, text, degenerate paths) end up in the leaves.
+    //
+    class BSPTree
+    {
+    public:
+        BSPTree(SVG::Objects& objects, Vertices& vertices, const Scalar& epsilon)
+            : objects(objects)
+            , vertices(vertices)
+            , epsilon(epsilon)
+        {
+            planes.resize(objects.size());
+            hasPlane.resize(objects.size(), false);
+            std::vector<size_t> items(objects.size());
+            for (size_t i = 0; i < objects.size(); ++i)
+            {
+                items[i] = i;
+                if (auto path = std::get_if<SVG::Path>(&objects[i]))
+                {
+                    hasPlane[i] = PolygonPlane(*path, vertices, epsilon, planes[i]);
+                }
+            }
+            build(std::move(items));
+        }
+
+        // Objects back to front
+        SVG::Objects order() const
+        {
+            SVG::Objects ordered;
+            ordered.reserve(objects.size());
+            // node index and whether the node's own objects are due
+            std::vector<std::pair<size_t, bool>> stack = { {0, false} };
+            while (!stack.empty())
+            {
+                const auto [index, own] = stack.back();
+                stack.pop_back();
+                const Node& node = nodes[index];
+                if (!node.split)
+                {
+                    std::vector<size_t> items = node.items;
+                    std::stable_sort(items.begin(), items.end(), [this](const size_t a, const size_t b)
+                        {
+                            return Depth(objects[a]) > Depth(objects[b]);
+                        });
+                    for (const auto item : items)
+                    {
+                        ordered.emplace_back(objects[item]);
+                    }
+                }
+                else if (own)
+                {
+                    for (const auto item : node.items)
+                    {
+                        ordered.emplace_back(objects[item]);
+                    }
+                }
+                else
+                {
+                    // the eye is in front of the plane when its normal points to negative z
+                    const bool eyeInFront = node.plane.normal.z < 0;
+                    const size_t first = eyeInFront ? node.back : node.front;
+                    const size_t last = eyeInFront ? node.front : node.back;
+                    if (last != none) stack.emplace_back(last, false);
+                    stack.emplace_back(index, true);
+                    if (first != none) stack.emplace_back(first, false);
+                }
+            }
+            return ordered;
+        }
+
+    private:
+        struct Node
+        {
+            Plane plane;
+            bool split = false;
+            std::vector<size_t> items;
+            size_t front = none;
+            size_t back = none;
+        };
+
+        SVG::Objects& objects;
+        Vertices& vertices;
+        const Scalar epsilon;
+        std::vector<Plane> planes;
+        std::vector<bool> hasPlane;
+        std::vector<Node> nodes;
+
+        void build(std::vector<size_t>&& items)
+        {
+            std::vector<std::pair<size_t, std::vector<size_t>>> tasks;
+            nodes.emplace_back();
+            tasks.emplace_back(0, std::move(items));
+            while (!tasks.empty())
+            {
+                auto task = std::move(tasks.back());
+                tasks.pop_back();
+                Node node;
+                const size_t splitter = chooseSplitter(task.second);
+                if (splitter == none)
+                {
+                    node.items = std::move(task.second);
+                    nodes[task.first] = std::move(node);
+                    continue;
+                }
+                node.split = true;
+                node.plane = planes[splitter];
+                std::vector<size_t> front;
+                std::vector<size_t> back;
+                for (const auto item : task.second)
+                {
+                    if (!hasPlane[item])
+                    {
+                        (node.plane.distance(Anchor(objects[item], vertices)) >= 0 ? front : back).emplace_back(item);
+                        continue;
+                    }
+                    const auto& path = std::get<SVG::Path>(objects[item]);
+                    switch (Classify(node.plane, path, vertices, epsilon))
+                    {
+                    case Side::Coplanar: node.items.emplace_back(item); break;
+                    case Side::Front: front.emplace_back(item); break;
+                    case Side::Back: back.emplace_back(item); break;
+                    case Side::Spanning:
+                        {
+                            SVG::Path frontPath(path);
+                            SVG::Path backPath(path);
+                            Split(node.plane, path, vertices, epsilon, frontPath, backPath);
+                            front.emplace_back(add(frontPath, planes[item]));
+                            back.emplace_back(add(backPath, planes[item]));
+                        }
+                        break;
+                    }
+                }
+                if (!front.empty())
+                {
+                    node.front = nodes.size();
+                    nodes.emplace_back();
+                    tasks.emplace_back(node.front, std::move(front));
+                }
+                if (!back.empty())
+                {
+                    node.back = nodes.size();
+                    nodes.emplace_back();
+                    tasks.emplace_back(node.back, std::move(back));
+                }
+                nodes[task.first] = std::move(node);
+            }
+        }
+
+        // A fragment has the plane of the path it was cut from
+        size_t add(const SVG::Path& path, const Plane plane)
+        {
+            objects.emplace_back(path);
+            planes.emplace_back(plane);
+            hasPlane.emplace_back(true);
+            return objects.size() - 1;
+        }
+
+        // Try a few planes against a sample of the items, prefer few splits
+        // and a balanced tree. Returns none when no item has a plane.
+        size_t chooseSplitter(const std::vector<size_t>& items) const
+        {
+            std::vector<size_t> candidates;
+            for (const auto item : items)
+            {
+                if (hasPlane[item])
+                {
+                    candidates.emplace_back(item);
+                }
+            }
+            if (candidates.empty())
+            {
+                return none;
+            }
+            const size_t tries = std::min<size_t>(candidates.size(), 8);
+            const size_t samples = std::min<size_t>(candidates.size(), 256);
+            size_t best = none;
+            size_t bestScore = std::numeric_limits<size_t>::max();
+            for (size_t t = 0; t < tries; ++t)
+            {
+                const size_t candidate = candidates[t * candidates.size() / tries];
+                const Plane& plane = planes[candidate];
+                size_t splits = 0;
+                size_t front = 0;
+                size_t back = 0;
+                for (size_t s = 0; s < samples; ++s)
+                {
+                    const size_t item = candidates[s * candidates.size() / samples];
+                    switch (Classify(plane, std::get<SVG::Path>(objects[item]), vertices, epsilon))
+                    {
+                    case Side::Coplanar: break;
+                    case Side::Front: ++front; break;
+                    case Side::Back: ++back; break;
+                    case Side::Spanning: ++splits; break;
+                    }
+                }
+                const size_t score = 8 * splits + (front > back ? front - back : back - front);
+                if (score < bestScore)
+                {
+                    bestScore = score;
+                    best = candidate;
+                }
+            }
+            return best;
+        }
+    };
+}
+
+SVG::Objects SVG::orderObjects(Vertices& vertices) const
+{
+    vertices = pathVertices;
+    Objects ordered;
+    switch (hiddenSurface)
+    {
+    case HiddenSurface::Painter:
+        {
+            // sort depth and index pairs, the index makes the order total
+            std::vector<std::pair<Scalar, size_t>> keys(objects.size());
+            Parallel::For(objects.size(), [&](const size_t i)
+                {
+                    keys[i] = { Depth(objects[i]), i };
+                });
+            Parallel::Sort(keys.begin(), keys.end(), [](const auto& a, const auto& b)
+                {
+                    return a.first > b.first || (a.first == b.first && a.second < b.second);
+                });
+            ordered.reserve(objects.size());
+            for (const auto& key : keys)
+            {
+                ordered.emplace_back(objects[key.second]);
+            }
+        }
+        break;
+    case HiddenSurface::BSP:
+        ordered = orderObjectsBSP(vertices);
+        break;
+    case HiddenSurface::BSPClipped:
+        ordered = orderObjectsBSP(vertices);
+        removeOccluded(ordered, vertices);
+        break;
+    }
+    return ordered;
+}
+
+SVG::Objects SVG::orderObjectsBSP(Vertices& vertices) const
+{
+    Scalar extent = 1;
+    for (const auto& vertex : vertices)
+    {
+        extent = std::max({ extent, std::abs(vertex.x), std::abs(vertex.y), std::abs(vertex.z) });
+    }
+    Objects work = objects;
+    BSPTree tree(work, vertices, extent * Limits<Scalar>::CompareEpsilon);
+    return tree.order();
+}
+
+void SVG::removeOccluded(Objects& ordered, const Vertices& vertices) const
+{
+    // The area covered by opaque paths so far, going front to back. The
+    // paths are kept as separate pieces in a grid over their bounding boxes.
+    // Each path subtracts the pieces around it one at a time while they still
+    // overlap what is left of it, and a convex piece holding all that is left
+    // hides it without clipping.
+    struct Piece
+    {
+        std::vector<Contour2D> region;
+        Point min;
+        Point max;
+        bool convex;
+    };
+    std::vector<Piece> pieces;
+    Point min(Limits<Scalar>::MaxValue, Limits<Scalar>::MaxValue);
+    Point max(-Limits<Scalar>::MaxValue, -Limits<Scalar>::MaxValue);
+    size_t pathCount = 0;
+    for (const auto& object : ordered)
+    {
+        if (const auto path = std::get_if<Path>(&object))
+        {
+            ++pathCount;
+            for (size_t j = 0; j < path->count; ++j)
+            {
+                const auto& vertex = vertices[path->first + j];
+                min = Point(std::min(min.x, vertex.x), std::min(min.y, vertex.y));
+                max = Point(std::max(max.x, vertex.x), std::max(max.y, vertex.y));
+            }
+        }
+    }
+    const size_t gridSize = std::clamp<size_t>((size_t)std::sqrt((Scalar)pathCount), 1, 256);
+    const Scalar cellWidth = std::max<Scalar>(max.x - min.x, Limits<Scalar>::CompareEpsilon) / gridSize;
+    const Scalar cellHeight = std::max<Scalar>(max.y - min.y, Limits<Scalar>::CompareEpsilon) / gridSize;
+    auto cell = [&](const Scalar& value, const Scalar& origin, const Scalar& size)
+    {
+        return (size_t)std::clamp<Scalar>(std::floor((value - origin) / size), 0, (Scalar)(gridSize - 1));
+    };
+    std::vector<std::vector<uint32_t>> grid(gridSize * gridSize);
+    // pieces already collected for the current path
+    std::vector<size_t> seen;
+    std::vector<uint32_t> around;
+    std::vector<bool> visible(ordered.size(), true);
+    for (size_t i = ordered.size(); i-- > 0;)
+    {
+        const auto path = std::get_if<Path>(&ordered[i]);
+        if (!path || path->count < 3)
+        {
+            continue;
+        }
+        Points points;
+        points.reserve(path->count);
+        Scalar twiceArea = 0;
+        Point pathMin(Limits<Scalar>::MaxValue, Limits<Scalar>::MaxValue);
+        Point pathMax(-Limits<Scalar>::MaxValue, -Limits<Scalar>::MaxValue);
+        for (size_t j = 0; j < path->count; ++j)
+        {
+            const auto& a = vertices[path->first + j];
+            const auto& b = vertices[path->first + (j + 1) % path->count];
+            points.emplace_back(a.x, a.y);
+            twiceArea += a.x * b.y - b.x * a.y;
+            pathMin = Point(std::min(pathMin.x, a.x), std::min(pathMin.y, a.y));
+            pathMax = Point(std::max(pathMax.x, a.x), std::max(pathMax.y, a.y));
+        }
+        if (twiceArea < 0)
+        {
+            std::reverse(points.begin(), points.end());
+        }
+        const Scalar area = std::abs(twiceArea) / 2;
+        // faces seen edge on are left as they are
+        if (area <= Limits<Scalar>::CompareEpsilon)
+        {
+            continue;
+        }
+        const size_t x0 = cell(pathMin.x, min.x, cellWidth);
+        const size_t x1 = cell(pathMax.x, min.x, cellWidth);
+        const size_t y0 = cell(pathMin.y, min.y, cellHeight);
+        const size_t y1 = cell(pathMax.y, min.y, cellHeight);
+        around.clear();
+        for (size_t y = y0; y <= y1; ++y)
+        {
+            for (size_t x = x0; x <= x1; ++x)
+            {
+                for (const auto index : grid[y * gridSize + x])
+                {
+                    if (seen[index] != i)
+                    {
+                        seen[index] = i;
+                        around.push_back(index);
+                    }
+                }
+            }
+        }
+        std::sort(around.begin(), around.end());
+        const bool convex = IsConvex(points);
+        std::vector<Contour2D> contour = { Contour2D(std::move(points)) };
+        std::vector<Contour2D> remaining = contour;
+        Point remainingMin = pathMin;
+        Point remainingMax = pathMax;
+        for (const auto index : around)
+        {
+            const Piece& piece = pieces[index];
+            if (piece.max.x < remainingMin.x || remainingMax.x < piece.min.x ||
+                piece.max.y < remainingMin.y || remainingMax.y < piece.min.y)
+            {
+                continue;
+            }
+            if (piece.convex && remaining.size() == 1 && ConvexContains(piece.region.front(), remaining.front()))
+            {
+                remaining.clear();
+                break;
+            }
+            remaining = Contour2D::Difference(remaining, piece.region);
+            if (remaining.empty())
+            {
+                break;
+            }
+            remainingMin = Point(Limits<Scalar>::MaxValue, Limits<Scalar>::MaxValue);
+            remainingMax = Point(-Limits<Scalar>::MaxValue, -Limits<Scalar>::MaxValue);
+            for (const auto& part : remaining)
+            {
+                for (const auto& point : part)
+                {
+                    remainingMin = Point(std::min(remainingMin.x, point.x), std::min(remainingMin.y, point.y));
+                    remainingMax = Point(std::max(remainingMax.x, point.x), std::max(remainingMax.y, point.y));
+                }
+            }
+        }
+        Scalar remainingArea = 0;
+        for (const auto& part : remaining)
+        {
+            remainingArea += part.area();
+        }
+        if (remainingArea <= area * 1e-9)
+        {
+            visible[i] = false;
+            continue;
+        }
+        const auto& pathStyle = styles[path->style];
+        if (pathStyle.fillOpacity >= 1 && pathStyle.fill != Color::Predefined::None)
+        {
+            const uint32_t index = (uint32_t)pieces.size();
+            pieces.push_back({ std::move(contour), pathMin, pathMax, convex });
+            seen.push_back(none);
+            for (size_t y = y0; y <= y1; ++y)
+            {
+                for (size_t x = x0; x <= x1; ++x)
+                {
+                    grid[y * gridSize + x].push_back(index);
+                }
+            }
+        }
+    }
+    size_t count = 0;
+    for (size_t i = 0; i < ordered.size(); ++i)
+    {
+        if (visible[i])
+        {
+            ordered[count++] = std::move(ordered[i]);
+        }
+    }
+    ordered.erase(ordered.begin() + count, ordered.end());
+}
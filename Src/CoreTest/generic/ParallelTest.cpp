@@ -0,0 +1,51 @@
+﻿#include <algorithm>
+#include <atomic>
+#include <random>
+
+#include "GoogleTest.h"
+#include "Core.h"
+
+using namespace std;
+using namespace testing;
+
+class ParallelTest : public Test
+{
+protected:
+    virtual void SetUp()
+    {
+    }
+
+    virtual void TearDown()
+    {
+    }
+};
+
+TEST_F(ParallelTest, For)
+{
+    vector<int> visits(10000, 0);
+    atomic<size_t> sum(0);
+    Parallel::For(visits.size(), [&](const size_t i)
+        {
+            ++visits[i];
+            sum += i;
+        }, 100);
+    EXPECT_EQ(visits.size(), (size_t)count(visits.begin(), visits.end(), 1));
+    EXPECT_EQ(visits.size() * (visits.size() - 1) / 2, sum.load());
+}
+
+TEST_F(ParallelTest, Sort)
+{
+    mt19937 rng(7);
+    for (const size_t size : { 0, 1, 100, 5000, 100001 })
+    {
+        vector<int> values(size);
+        for (auto& value : values)
+        {
+            value = (int)(rng() % 1000);
+        }
+        auto expected = values;
+        sort(expected.begin(), expected.end(), greater<int>());
+        Parallel::Sort(values.begin(), values.end(), greater<int>(), 1000);
+        EXPECT_EQ(expected, values);
+    }
+}
@@ -0,0 +1,83 @@
+﻿#include <cmath>
+
+#include "GoogleTest.h"
+#include "Core.h"
+
+using namespace std;
+using namespace testing;
+
+class PredicatesTest : public Test
+{
+protected:
+    virtual void SetUp()
+    {
+    }
+
+    virtual void TearDown()
+    {
+    }
+
+    static int Sign(const Scalar& value)
+    {
+        return (value > 0) - (value < 0);
+    }
+
+    // large enough to make the naive determinants round
+    const Scalar X = std::ldexp(1.0, 45);
+};
+
+TEST_F(PredicatesTest, Orient2D)
+{
+    EXPECT_LT(0, Predicates::Orient2D(Point(0, 0), Point(1, 0), Point(0, 1)));
+    EXPECT_GT(0, Predicates::Orient2D(Point(0, 0), Point(0, 1), Point(1, 0)));
+    EXPECT_EQ(0, Predicates::Orient2D(Point(X, X + 1), Point(X + 3, X + 4), Point(X + 7, X + 8)));
+    EXPECT_LT(0, Predicates::Orient2D(Point(X, X + 1), Point(X + 3, X + 4), Point(X + 7, X + 9)));
+    EXPECT_GT(0, Predicates::Orient2D(Point(X, X + 1), Point(X + 3, X + 4), Point(X + 7, X + 7)));
+    // a grid of points around (0.5,0.5), one ulp apart, against the line y=x
+    Scalar x = 0.5;
+    for (int i = 0; i < 16; ++i, x = std::nextafter(x, 1.0))
+    {
+        Scalar y = 0.5;
+        for (int j = 0; j < 16; ++j, y = std::nextafter(y, 1.0))
+        {
+            EXPECT_EQ(Sign(j - i), Sign(Predicates::Orient2D(Point(x, y), Point(12, 12), Point(24, 24))));
+        }
+    }
+}
+
+TEST_F(PredicatesTest, Orient3D)
+{
+    const Vertex a(0, 0, 0), b(1, 0, 0), c(0, 1, 0);
+    EXPECT_LT(0, Predicates::Orient3D(a, b, c, Vertex(0, 0, -1)));
+    EXPECT_GT(0, Predicates::Orient3D(a, b, c, Vertex(0, 0, 1)));
+    EXPECT_EQ(0, Predicates::Orient3D(a, b, c, Vertex(5, 7, 0)));
+    // the plane z = x + y
+    const Vertex d(X, 0, X), e(X + 1, 0, X + 1), f(X, 1, X + 1);
+    EXPECT_EQ(0, Predicates::Orient3D(d, e, f, Vertex(X + 2, 3, X + 5)));
+    EXPECT_GT(0, Predicates::Orient3D(d, e, f, Vertex(X + 2, 3, X + 6)));
+    EXPECT_LT(0, Predicates::Orient3D(d, e, f, Vertex(X + 2, 3, X + 4)));
+    Scalar z = 0.5;
+    for (int i = 0; i < 16; ++i, z = std::nextafter(z, 1.0))
+    {
+        EXPECT_EQ(-Sign(i), Sign(Predicates::Orient3D(Vertex(0.1, 0.3, 0.5), Vertex(12.7, 0.1, 0.5), Vertex(3.3, 24.9, 0.5), Vertex(0.7, 0.9, z))));
+    }
+}
+
+TEST_F(PredicatesTest, InCircle)
+{
+    const Point a(X + 5, X), b(X, X + 5), c(X - 5, X);
+    EXPECT_EQ(0, Predicates::InCircle(a, b, c, Point(X + 3, X + 4)));
+    EXPECT_LT(0, Predicates::InCircle(a, b, c, Point(X + 3, X + 3)));
+    EXPECT_GT(0, Predicates::InCircle(a, b, c, Point(X + 4, X + 4)));
+    EXPECT_LT(0, Predicates::InCircle(Point(1, 0), Point(0, 1), Point(-1, 0), Point(0, 0)));
+}
+
+TEST_F(PredicatesTest, InSphere)
+{
+    const Vertex a(X + 5, X, X), b(X, X + 5, X), c(X - 5, X, X), d(X, X, X - 5);
+    ASSERT_LT(0, Predicates::Orient3D(a, b, c, d));
+    EXPECT_EQ(0, Predicates::InSphere(a, b, c, d, Vertex(X + 3, X, X + 4)));
+    EXPECT_LT(0, Predicates::InSphere(a, b, c, d, Vertex(X, X, X)));
+    EXPECT_GT(0, Predicates::InSphere(a, b, c, d, Vertex(X, X, X + 6)));
+    EXPECT_GT(0, Predicates::InSphere(a, b, c, d, Vertex(X + 3, X + 1, X + 4)));
+}
@@ -70,3 +70,17 @@ TEST_F(VertexTest, Indexing)
     EXPECT_EQ(2, v[1]);
     EXPECT_THROW(v[3], std::invalid_argument);
 }
+
+TEST_F(VertexTest, Precision)
+{
+    EXPECT_EQ(3 * sizeof(float), sizeof(VertexF));
+    Vertex v(1, 2, 1.0 / 3);
+    VertexF f(v);
+    EXPECT_FLOAT_EQ(1.0f / 3, f.z);
+    EXPECT_FLOAT_EQ(5.0f + 1.0f / 9, f.innerProduct(f));
+    Vertex back(f);
+    EXPECT_NEAR(v.z, back.z, 1e-7);
+    VerticesF vertices = ConvertVertices<VertexF>(Vertices{ v, v * 2 });
+    ASSERT_EQ(2, vertices.size());
+    EXPECT_FLOAT_EQ(4.0f, vertices[1].y);
+}
@@ -120,3 +120,24 @@ TEST_F(BoundingObjectTest, OverlapSphereBox)
     EXPECT_FALSE(b1.overlap(b7));
     EXPECT_FALSE(b1.overlap(b8));
 }
+
+TEST_F(BoundingObjectTest, Contains)
+{
+    BoundingObject box({ -1,-1,-1 }, { 1,1,1 });
+    BoundingObject sphere({ 0,0,0 }, 1);
+    EXPECT_TRUE(box.contains({ 0.9, 0.9, 0.9 }));
+    EXPECT_FALSE(box.contains({ 0.9, 1.1, 0.9 }));
+    EXPECT_FALSE(sphere.contains({ 0.9, 0.9, 0.9 }));
+    EXPECT_TRUE(sphere.contains({ 0, 0, -1 }));
+}
+
+TEST_F(BoundingObjectTest, Precision)
+{
+    VerticesF vertices{ { 1, 2, 3 }, { 2, 3, 4 }, { 1.5f, 2.5f, 3.5f } };
+    BoundingObjectF bounds(vertices);
+    EXPECT_TRUE(bounds);
+    EXPECT_TRUE(bounds.contains({ 1.5f, 2.5f, 3.5f }));
+    EXPECT_FALSE(bounds.contains({ 0, 0, 0 }));
+    BoundingObjectF other({ 1.9f, 2.9f, 3.9f }, 0.5f);
+    EXPECT_TRUE(bounds.overlap(other));
+}
@@ -0,0 +1,233 @@
+﻿#include <algorithm>
+
+#include "GoogleTest.h"
+#include "Core.h"
+
+using namespace std;
+using namespace testing;
+
+class Contour2DTest : public Test
+{
+protected:
+    virtual void SetUp()
+    {
+    }
+
+    virtual void TearDown()
+    {
+    }
+
+    static Scalar Area(const std::vector<Contour2D>& contours)
+    {
+        Scalar area = 0;
+        for (const auto& contour : contours)
+        {
+            area += contour.area();
+        }
+        return area;
+    }
+
+    // Total area of the triangles, which all have to be counterclockwise
+    static Scalar Area(const Points& points, const Contour2D::Triangles& triangles)
+    {
+        Scalar area = 0;
+        for (const auto& triangle : triangles)
+        {
+            const Scalar a = Predicates::Orient2D(points[triangle[0]], points[triangle[1]], points[triangle[2]]) / 2;
+            EXPECT_LT(0, a);
+            area += a;
+        }
+        return area;
+    }
+
+    static Points Concatenate(const Contour2D& outer, const std::vector<Contour2D>& holes)
+    {
+        Points points(outer.begin(), outer.end());
+        for (const auto& hole : holes)
+        {
+            points.insert(points.end(), hole.begin(), hole.end());
+        }
+        return points;
+    }
+};
+
+TEST_F(Contour2DTest, Area)
+{
+    EXPECT_FLOAT_EQ(6, Contour2D::Square({ 1,1 }, { 4,3 }).area());
+    EXPECT_FLOAT_EQ(-0.5, Contour2D().add(0, 0).add(0, 1).add(1, 0).area());
+}
+
+TEST_F(Contour2DTest, TriangulateConvex)
+{
+    const Contour2D square = Contour2D::Square();
+    auto triangles = square.triangulate();
+    EXPECT_EQ(2, triangles.size());
+    EXPECT_FLOAT_EQ(1, Area(Points(square.begin(), square.end()), triangles));
+    const Contour2D circle = Contour2D::Circle({ 1,2 }, 3, 1000);
+    triangles = circle.triangulate();
+    EXPECT_EQ(998, triangles.size());
+    EXPECT_FLOAT_EQ(circle.area(), Area(Points(circle.begin(), circle.end()), triangles));
+}
+
+TEST_F(Contour2DTest, TriangulateConcave)
+{
+    // a comb with teeth up and down, full of split and merge vertices
+    Contour2D comb;
+    const size_t teeth = 50;
+    for (size_t i = 0; i < teeth; ++i)
+    {
+        comb.add(2.0 * i, -1).add(2.0 * i + 1, -5);
+    }
+    comb.add(2.0 * teeth, -1);
+    for (size_t i = teeth; i > 0; --i)
+    {
+        comb.add(2.0 * i, 1).add(2.0 * i - 1, 4 + (i % 3));
+    }
+    comb.add(0, 1);
+    auto triangles = comb.triangulate();
+    EXPECT_EQ(comb.size() - 2, triangles.size());
+    EXPECT_FLOAT_EQ(comb.area(), Area(Points(comb.begin(), comb.end()), triangles));
+    // clockwise input gives the same area
+    Contour2D reversed;
+    for (size_t i = comb.size(); i > 0; --i)
+    {
+        reversed.add(comb[i - 1]);
+    }
+    triangles = reversed.triangulate();
+    EXPECT_EQ(reversed.size() - 2, triangles.size());
+    EXPECT_FLOAT_EQ(-reversed.area(), Area(Points(reversed.begin(), reversed.end()), triangles));
+    // a star with random spikes
+    Contour2D star;
+    const size_t spikes = 500;
+    for (size_t i = 0; i < spikes; ++i)
+    {
+        const Scalar angle = 2 * Constants::Pi * i / spikes;
+        const Scalar radius = 1 + 4 * Numerics::NormalizedRandomNumber<Scalar>();
+        star.add(radius * cos(angle), radius * sin(angle));
+    }
+    triangles = star.triangulate();
+    EXPECT_EQ(star.size() - 2, triangles.size());
+    EXPECT_FLOAT_EQ(star.area(), Area(Points(star.begin(), star.end()), triangles));
+}
+
+TEST_F(Contour2DTest, TriangulateHoles)
+{
+    const Contour2D outer = Contour2D::Square({ 0,0 }, { 10,10 });
+    const std::vector<Contour2D> holes = {
+        Contour2D::Square({ 1,1 }, { 3,2 }),
+        Contour2D::Circle({ 6,6 }, 2, 40),
+        Contour2D().add(7, 1).add(8, 3).add(9, 1).add(8, 2),
+    };
+    const auto triangles = Contour2D::Triangulate(outer, holes);
+    const Points points = Concatenate(outer, holes);
+    EXPECT_EQ(points.size() + 2 * holes.size() - 2, triangles.size());
+    Scalar area = outer.area();
+    for (const auto& hole : holes)
+    {
+        area -= std::abs(hole.area());
+    }
+    EXPECT_FLOAT_EQ(area, Area(points, triangles));
+}
+
+TEST_F(Contour2DTest, TriangulateDegenerate)
+{
+    // repeated points, also as -0 and 0, and a spike without area
+    const Contour2D contour(Points{ { 0,-0.375 }, { -0.0,-0.375 }, { 0.5,-0.25 }, { 0.5,-0.25 }, { 1,0 }, { 0.5,0.125 }, { 0.75,0.125 }, { 0.25,0.125 }, { 0,1 }, { 0,-0.375 } });
+    const auto triangles = contour.triangulate();
+    EXPECT_EQ(4, triangles.size());
+    EXPECT_FLOAT_EQ(contour.area(), Area(Points(contour.begin(), contour.end()), triangles));
+    // holes sharing an edge
+    const Contour2D outer = Contour2D::Square({ 0,0 }, { 10,10 });
+    EXPECT_THROW(Contour2D::Triangulate(outer, { Contour2D::Square({ 1,1 }, { 3,3 }), Contour2D::Square({ 3,1 }, { 5,3 }) }), std::invalid_argument);
+    EXPECT_THROW(Contour2D::Triangulate(outer, { Contour2D::Square({ 1,1 }, { 3,3 }), Contour2D::Square({ 2,1 }, { 4,3 }) }), std::invalid_argument);
+}
+
+TEST_F(Contour2DTest, ExtrusionCaps)
+{
+    const Contour2D circle = Contour2D::Circle({ 0,0 }, 1, 100);
+    Shape single = ShapeFactory::Extrusion(circle, 2);
+    Shape triangulated = ShapeFactory::Extrusion(circle, 2, true);
+    size_t count = 0;
+    for (const auto& face : triangulated.getFaces())
+    {
+        EXPECT_TRUE(face.size() == 3 || face.size() == 4);
+        ++count;
+    }
+    EXPECT_EQ(100 + 2 * 98, count);
+    EXPECT_FLOAT_EQ(single.calculateVolume(), triangulated.calculateVolume());
+    EXPECT_FLOAT_EQ(single.calculateSurfaceArea(), triangulated.calculateSurfaceArea());
+}
+
+TEST_F(Contour2DTest, Boolean)
+{
+    const std::vector<Contour2D> a = { Contour2D::Square({ 0,0 }, { 2,2 }) };
+    const std::vector<Contour2D> b = { Contour2D::Square({ 1,1 }, { 3,3 }) };
+    auto res = Contour2D::Union(a, b);
+    EXPECT_EQ(1, res.size());
+    EXPECT_EQ(8, res[0].size());
+    EXPECT_FLOAT_EQ(7, Area(res));
+    res = Contour2D::Intersection(a, b);
+    EXPECT_EQ(1, res.size());
+    EXPECT_EQ(4, res[0].size());
+    EXPECT_FLOAT_EQ(1, Area(res));
+    res = Contour2D::Difference(a, b);
+    EXPECT_EQ(1, res.size());
+    EXPECT_FLOAT_EQ(3, Area(res));
+    // a hole, returned clockwise
+    res = Contour2D::Difference({ Contour2D::Square({ 0,0 }, { 4,4 }) }, { Contour2D::Square({ 1,1 }, { 2,2 }) });
+    EXPECT_EQ(2, res.size());
+    EXPECT_FLOAT_EQ(15, Area(res));
+    EXPECT_EQ(1, std::count_if(res.begin(), res.end(), [](const Contour2D& c) { return c.area() < 0; }));
+    // shared edges and touching corners
+    res = Contour2D::Union({ Contour2D::Square({ 0,0 }, { 1,1 }), Contour2D::Square({ 1,0 }, { 2,1 }) }, { Contour2D::Square({ 2,1 }, { 3,2 }) });
+    EXPECT_EQ(2, res.size());
+    EXPECT_FLOAT_EQ(3, Area(res));
+    res = Contour2D::Intersection(a, { Contour2D::Square({ 2,0 }, { 3,2 }) });
+    EXPECT_EQ(0, res.size());
+    // corners a rounding error apart, with edges crossing between them
+    const Point p(179.5, 145.25);
+    const Point q(179.5, std::nextafter(145.25, 0.0));
+    const Contour2D left(Points{ { 178.2,140.1 }, { 179.3,138.4 }, { 179.75,139.5 }, p, { 179.3,145.2 } });
+    const Contour2D right(Points{ q, { 182.4,146.1 }, { 179.75,151.8 } });
+    EXPECT_NEAR(left.area() + right.area(), Area(Contour2D::Union({ left }, { right })), 1e-6);
+    EXPECT_NEAR(left.area(), Area(Contour2D::Difference({ left }, { right })), 1e-6);
+    EXPECT_NEAR(0, Area(Contour2D::Intersection({ left }, { right })), 1e-6);
+    // nearly collinear edges meeting at shared corners, the triangles only graze the path
+    const Contour2D path(Points{ { 158.67026462904491,137.23558123607947 }, { 159.03063588365964,139.18518903968726 }, { 159.0334275405161,139.22795628968191 }, { 158.8438027651809,139.52247630814585 } });
+    const Contour2D t1(Points{ { 158.85795297581444,136.53974460674522 }, { 160.46274126318838,137.00798527983855 }, { 159.0334275405161,139.22795628968191 } });
+    const Contour2D t2(Points{ { 158.52361214329184,136.44219156645033 }, { 158.85795297581444,136.53974460674522 }, { 159.03063588365964,139.18518903968726 } });
+    EXPECT_NEAR(path.area(), Area(Contour2D::Difference({ path }, { t1, t2 })), 1e-9);
+    // two detailed circles
+    const Contour2D c1 = Contour2D::Circle({ 0,0 }, 1, 2000);
+    const Contour2D c2 = Contour2D::Circle({ 1,0 }, 1, 2000);
+    const Scalar lens = 2 * acos(0.5) - 0.5 * sqrt(3.0);
+    EXPECT_NEAR(lens, Area(Contour2D::Intersection({ c1 }, { c2 })), 1e-4);
+    EXPECT_NEAR(2 * Constants::Pi - lens, Area(Contour2D::Union({ c1 }, { c2 })), 1e-4);
+    EXPECT_NEAR(Constants::Pi - lens, Area(Contour2D::Difference({ c1 }, { c2 })), 1e-4);
+}
+
+TEST_F(Contour2DTest, Offset)
+{
+    const Contour2D square = Contour2D::Square();
+    EXPECT_FLOAT_EQ(9, Area(square.offset(1)));
+    EXPECT_NEAR(5 + Constants::Pi, Area(square.offset(1, Contour2D::Join::Round)), 0.05);
+    EXPECT_NEAR(5 + Constants::Pi, Area(square.offset(1, Contour2D::Join::Round, 2, 1e-5)), 1e-3);
+    EXPECT_FLOAT_EQ(5 + 4 * (1 - Numerics::Sqr(sqrt(2.0) - 1)), Area(square.offset(1, Contour2D::Join::Square)));
+    EXPECT_FLOAT_EQ(0.25, Area(square.offset(-0.25)));
+    EXPECT_EQ(0, square.offset(-0.6).size());
+    // clockwise input is offset the same way
+    EXPECT_FLOAT_EQ(9, Area(Contour2D().add(0, 0).add(0, 1).add(1, 1).add(1, 0).offset(1)));
+    // an L shape: the concave corner doesn't add area, shrinking it removes the inner corner
+    const Contour2D l = Contour2D().add(0, 0).add(2, 0).add(2, 1).add(1, 1).add(1, 2).add(0, 2);
+    EXPECT_FLOAT_EQ(3 + 8 * 0.1 + 5 * 0.01 - 0.01, Area(l.offset(0.1)));
+    EXPECT_FLOAT_EQ(3 - 8 * 0.1 + 5 * 0.01 - 0.01, Area(l.offset(-0.1)));
+    // a dumbbell splits in two when shrunk
+    const Contour2D dumbbell = Contour2D().add(0, 0).add(3, 0).add(3, 1.1).add(4, 1.1).add(4, 0).add(7, 0).add(7, 3).add(4, 3).add(4, 1.9).add(3, 1.9).add(3, 3).add(0, 3);
+    const auto parts = dumbbell.offset(-0.5);
+    EXPECT_EQ(2, parts.size());
+    EXPECT_FLOAT_EQ(2 * 2 * 2, Area(parts));
+    // holes shrink when the region grows
+    const auto ring = Contour2D::Difference({ Contour2D::Square({ 0,0 }, { 4,4 }) }, { Contour2D::Square({ 1,1 }, { 3,3 }) });
+    EXPECT_FLOAT_EQ(25 - 1, Area(Contour2D::Offset(ring, 0.5)));
+    EXPECT_EQ(1, Contour2D::Offset(ring, 1.5).size());
+}
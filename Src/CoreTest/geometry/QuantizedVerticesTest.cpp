@@ -0,0 +1,102 @@
+﻿#include "GoogleTest.h"
+#include "Core.h"
+
+using namespace std;
+using namespace testing;
+
+class QuantizedVerticesTest : public Test
+{
+protected:
+    virtual void SetUp()
+    {
+    }
+
+    virtual void TearDown()
+    {
+    }
+
+    static Vertices RandomVertices(const size_t count)
+    {
+        Vertices vertices;
+        for (size_t i = 0; i < count; ++i)
+        {
+            vertices.emplace_back(Numerics::NormalizedRandomNumber(100.0) - 50, Numerics::NormalizedRandomNumber(2.0), 7);
+        }
+        return vertices;
+    }
+};
+
+TEST_F(QuantizedVerticesTest, Empty)
+{
+    QuantizedVertices quantized(Vertices{});
+    EXPECT_TRUE(quantized.empty());
+    EXPECT_EQ(0, quantized.decode().size());
+}
+
+TEST_F(QuantizedVerticesTest, Precision)
+{
+    const Vertices vertices = RandomVertices(1000);
+    for (auto precision : { QuantizedVertices::Precision::Bits16, QuantizedVertices::Precision::Bits21 })
+    {
+        QuantizedVertices quantized(vertices, precision);
+        ASSERT_EQ(vertices.size(), quantized.size());
+        EXPECT_EQ(vertices.size() * (precision == QuantizedVertices::Precision::Bits16 ? 6 : 8), quantized.getMemorySize());
+        const Vertex error = quantized.getMaxError();
+        EXPECT_GT(100.0 / (1 << (int)precision), error.x);
+        EXPECT_EQ(0, error.z);
+        const Vertices decoded = quantized.decode();
+        for (size_t i = 0; i < vertices.size(); ++i)
+        {
+            EXPECT_NEAR(vertices[i].x, decoded[i].x, error.x * 1.001);
+            EXPECT_NEAR(vertices[i].y, decoded[i].y, error.y * 1.001);
+            EXPECT_DOUBLE_EQ(7, decoded[i].z);
+            EXPECT_CONTAINER_DOUBLE_EQ(decoded[i], quantized.decode(i));
+        }
+    }
+    EXPECT_THROW(QuantizedVertices(vertices).decode(vertices.size()), std::out_of_range);
+}
+
+TEST_F(QuantizedVerticesTest, Transformed)
+{
+    const Vertices vertices = RandomVertices(100);
+    const Transformation transformation = Transformation({ 1, 2, 3 }) * Transformation({ 1, 1, 0 }, 0.7);
+    QuantizedVertices quantized(vertices, QuantizedVertices::Precision::Bits21);
+    const Vertices decoded = quantized.decode();
+    const Vertices transformed = quantized.decode(transformation);
+    for (size_t i = 0; i < vertices.size(); ++i)
+    {
+        const Vertex expected = transformation * decoded[i];
+        EXPECT_NEAR(expected.x, transformed[i].x, 1e-9);
+        EXPECT_NEAR(expected.y, transformed[i].y, 1e-9);
+        EXPECT_NEAR(expected.z, transformed[i].z, 1e-9);
+    }
+}
+
+TEST_F(QuantizedVerticesTest, Shape)
+{
+    Shape box = ShapeFactory::Box({ -1,-2,-3 }, { 1,2,3 });
+    const QuantizedVertices quantized(box.getVertices());
+    Shape restored(quantized, box.getRawFaces());
+    // the world space vertices come straight from the compact ones
+    restored.translate({ 1, 2, 3 });
+    restored.rotate({ 0, 0, 1 }, 0.3);
+    const Vertices transformed = quantized.decode(Transformation({ 1, 2, 3 }) * Transformation({ 0, 0, 1 }, 0.3));
+    ASSERT_EQ(transformed.size(), restored.getTransformedVertices().size());
+    for (size_t i = 0; i < transformed.size(); ++i)
+    {
+        EXPECT_EQ(transformed[i], restored.getTransformedVertices()[i]);
+    }
+    EXPECT_EQ(box.getVertices().size(), restored.getVertices().size());
+    EXPECT_NEAR(box.calculateVolume(), restored.calculateVolume(), 1e-9);
+    // copies share the compact vertices, a change decodes them
+    Shape scaled(restored);
+    scaled.scale(2);
+    EXPECT_NEAR(8 * box.calculateVolume(), scaled.calculateVolume(), 1e-8);
+    EXPECT_NEAR(box.calculateVolume(), restored.calculateVolume(), 1e-9);
+    EXPECT_EQ(restored.getVertices()[0] * 2, scaled.getVertices()[0]);
+    // unused vertices are dropped
+    Vertices extra = box.getVertices();
+    extra.emplace_back(10, 10, 10);
+    Shape trimmed(QuantizedVertices(extra), box.getRawFaces());
+    EXPECT_EQ(box.getVertices().size(), trimmed.getVertices().size());
+}
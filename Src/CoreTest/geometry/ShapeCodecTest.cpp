@@ -0,0 +1,98 @@
+﻿#include <cstring>
+#include <limits>
+
+#include "GoogleTest.h"
+#include "Core.h"
+
+using namespace std;
+using namespace testing;
+
+class ShapeCodecTest : public Test
+{
+protected:
+    virtual void SetUp()
+    {
+    }
+
+    virtual void TearDown()
+    {
+    }
+
+    // The faces of the decoded shape have the same corners, within the quantization error
+    static void ExpectSameShape(const Shape& expected, const Shape& actual, const Vertex& error)
+    {
+        ASSERT_EQ(expected.getRawFaces().size(), actual.getRawFaces().size());
+        for (size_t i = 0; i < expected.getRawFaces().size(); ++i)
+        {
+            const Face& expectedFace = expected.getRawFace(i);
+            const Face& actualFace = actual.getRawFace(i);
+            ASSERT_EQ(expectedFace.size(), actualFace.size());
+            for (size_t j = 0; j < expectedFace.size(); ++j)
+            {
+                const Vertex& e = expected.getVertices()[expectedFace[j]];
+                const Vertex& a = actual.getVertices()[actualFace[j]];
+                EXPECT_NEAR(e.x, a.x, error.x * 1.001 + 1e-12);
+                EXPECT_NEAR(e.y, a.y, error.y * 1.001 + 1e-12);
+                EXPECT_NEAR(e.z, a.z, error.z * 1.001 + 1e-12);
+            }
+        }
+    }
+};
+
+TEST_F(ShapeCodecTest, RoundTrip)
+{
+    const Shape shapes[] = {
+        ShapeFactory::Box({ -1,-2,-3 }, { 1,2,3 }),
+        ShapeFactory::Torus({ 0,0,0 }, 2, 0.5, 32, 16),
+        ShapeFactory::Icosphere({ 1,1,1 }, 1, 3),
+        ShapeFactory::Cylinder({ 0,0,0 }, 1, 2, 24),
+    };
+    for (const auto& shape : shapes)
+    {
+        for (auto precision : { QuantizedVertices::Precision::Bits16, QuantizedVertices::Precision::Bits21 })
+        {
+            const std::vector<uint8_t> data = ShapeCodec::Encode(shape, precision);
+            const Shape decoded = ShapeCodec::Decode(data);
+            EXPECT_EQ(shape.getVertices().size(), decoded.getVertices().size());
+            ExpectSameShape(shape, decoded, QuantizedVertices(shape.getVertices(), precision).getMaxError());
+        }
+    }
+}
+
+TEST_F(ShapeCodecTest, Compression)
+{
+    Shape torus = ShapeFactory::Torus({ 0,0,0 }, 2, 0.5, 128, 64);
+    size_t corners = 0;
+    for (const auto& face : torus.getRawFaces())
+    {
+        corners += face.size();
+    }
+    const size_t raw = corners * sizeof(Index) + torus.getVertices().size() * sizeof(Vertex);
+    // the quantized vertices with the face indices
+    const size_t compact = corners * sizeof(Index) + QuantizedVertices(torus.getVertices()).getMemorySize();
+    const std::vector<uint8_t> data = ShapeCodec::Encode(torus);
+    EXPECT_GT(raw, 6 * data.size());
+    EXPECT_GT(compact, 3 * data.size());
+}
+
+TEST_F(ShapeCodecTest, InvalidData)
+{
+    const std::vector<uint8_t> data = ShapeCodec::Encode(ShapeFactory::Icosphere({ 0,0,0 }, 1, 2));
+    EXPECT_THROW(ShapeCodec::Decode(std::vector<uint8_t>(data.begin(), data.begin() + 10)), std::invalid_argument);
+    EXPECT_THROW(ShapeCodec::Decode(std::vector<uint8_t>(data.begin(), data.begin() + data.size() / 2)), std::invalid_argument);
+    std::vector<uint8_t> other(data);
+    other[0] = 'X';
+    EXPECT_THROW(ShapeCodec::Decode(other), std::invalid_argument);
+    // the header holds the origin at byte 14 and the step at byte 38, 3 doubles each
+    auto withScalar = [&data](const size_t offset, const double value)
+    {
+        std::vector<uint8_t> corrupt(data);
+        std::memcpy(corrupt.data() + offset, &value, sizeof(value));
+        return corrupt;
+    };
+    EXPECT_THROW(ShapeCodec::Decode(withScalar(38, numeric_limits<double>::quiet_NaN())), std::invalid_argument);
+    EXPECT_THROW(ShapeCodec::Decode(withScalar(46, numeric_limits<double>::infinity())), std::invalid_argument);
+    EXPECT_THROW(ShapeCodec::Decode(withScalar(54, -0.5)), std::invalid_argument);
+    EXPECT_THROW(ShapeCodec::Decode(withScalar(14, -numeric_limits<double>::infinity())), std::invalid_argument);
+    EXPECT_NO_THROW(ShapeCodec::Decode(withScalar(14, 2.5)));
+}
@@ -99,3 +99,752 @@ TEST_F(ShapeTest, ExtrusionCylinder)
     EXPECT_FLOAT_EQ(V, extrusion.calculateVolume());
 }
 
+TEST_F(ShapeTest, SinglePrecision)
+{
+    Shape box = ShapeFactory::Box({ -1,-2,-3 }, { 1,2,3 });
+    const VerticesF vertices = ConvertVertices<VertexF>(box.getVertices());
+    Shape single(vertices, box.getRawFaces());
+    single.translate({ 1, 2, 3 });
+    single.rotate({ 0, 0, 1 }, 0.3);
+    // transformed in double precision straight from the float vertices
+    const Transformation transformation = Transformation({ 1, 2, 3 }) * Transformation({ 0, 0, 1 }, 0.3);
+    ASSERT_EQ(vertices.size(), single.getTransformedVertices().size());
+    for (size_t i = 0; i < vertices.size(); ++i)
+    {
+        EXPECT_EQ(transformation * Vertex(vertices[i]), single.getTransformedVertices()[i]);
+    }
+    EXPECT_EQ(box.getVertices(), single.getVertices());
+    EXPECT_FLOAT_EQ(48, single.calculateVolume());
+    // a change converts them for good, copies keep their own
+    Shape scaled(single);
+    scaled.scale(0.5);
+    EXPECT_FLOAT_EQ(6, scaled.calculateVolume());
+    EXPECT_FLOAT_EQ(48, single.calculateVolume());
+    // moved in, and braced lists still pick the double precision constructor
+    EXPECT_FLOAT_EQ(48, Shape(VerticesF(vertices), Faces(box.getRawFaces())).calculateVolume());
+    const Shape triangle({ { 0,0,0 }, { 1,0,0 }, { 0,1,0 } }, { { 0,1,2 } });
+    EXPECT_FLOAT_EQ(0.5, triangle.calculateSurfaceArea());
+}
+
+TEST_F(ShapeTest, Weld)
+{
+    // box assembled from separate faces, with some noise on the duplicates
+    Shape box = ShapeFactory::Box();
+    Vertices vertices;
+    Faces faces;
+    for (const auto& face : box.getFaces())
+    {
+        std::vector<Index> points;
+        for (const auto& vertex : face)
+        {
+            points.emplace_back((Index)vertices.size());
+            vertices.emplace_back(vertex + Vertex(1e-12 * vertices.size(), 0, 0));
+        }
+        faces.emplace_back(points);
+    }
+    Shape separate(vertices, faces);
+    EXPECT_EQ(24, separate.getVertices().size());
+    Shape welded(vertices, faces, true);
+    EXPECT_EQ(8, welded.getVertices().size());
+    EXPECT_EQ(6, welded.getRawFaces().size());
+    EXPECT_FLOAT_EQ(6, welded.calculateSurfaceArea());
+    EXPECT_FLOAT_EQ(1, welded.calculateVolume());
+    separate.weld();
+    EXPECT_EQ(8, separate.getVertices().size());
+    EXPECT_FLOAT_EQ(1, separate.calculateVolume());
+}
+
+TEST_F(ShapeTest, WeldManyVertices)
+{
+    // more vertices than an Index counts, the faces use the last ones it reaches
+    const Vertices corners = { { 0,0,0 }, { 1,0,0 }, { 1,1,0 }, { 0,1,0 } };
+    Vertices vertices;
+    for (size_t i = 0; i < 70000; ++i)
+    {
+        vertices.emplace_back(corners[i % 4]);
+    }
+    Faces faces;
+    faces.emplace_back(std::vector<Index>{ 0, 1, 2, 3 });
+    faces.emplace_back(std::vector<Index>{ 65532, 65533, 65534, 65535 });
+    Shape welded(vertices, faces, true);
+    EXPECT_EQ(4, welded.getVertices().size());
+    ASSERT_EQ(2, welded.getRawFaces().size());
+    for (const auto& face : welded.getRawFaces())
+    {
+        ASSERT_EQ(4, face.size());
+        for (Index i = 0; i < 4; ++i)
+        {
+            EXPECT_EQ(i, face[i]);
+        }
+    }
+}
+
+TEST_F(ShapeTest, OptimizeAllIndices)
+{
+    // a strip using every Index value, renumbered in order of first use
+    Vertices vertices;
+    Faces faces;
+    for (size_t i = 0; i < 65536; ++i)
+    {
+        vertices.emplace_back((Scalar)(i / 2), (Scalar)(i % 2), 0);
+    }
+    for (size_t i = 65534; i >= 2; i -= 2)
+    {
+        faces.emplace_back(std::vector<Index>{ (Index)i, (Index)(i + 1), (Index)(i - 1), (Index)(i - 2) });
+    }
+    Shape strip(vertices, faces);
+    const Scalar area = strip.calculateSurfaceArea();
+    strip.optimize(true);
+    EXPECT_EQ(65536, strip.getVertices().size());
+    EXPECT_EQ(faces.size(), strip.getRawFaces().size());
+    EXPECT_FLOAT_EQ(area, strip.calculateSurfaceArea());
+    EXPECT_FLOAT_EQ(32767, area);
+}
+
+TEST_F(ShapeTest, WeldCollapse)
+{
+    // welding the top of a box onto the bottom collapses the sides
+    Shape box = ShapeFactory::Box({ 0,0,0 }, { 1,1,0.01 });
+    box.weld(0.1);
+    EXPECT_EQ(4, box.getVertices().size());
+    EXPECT_EQ(2, box.getRawFaces().size());
+    EXPECT_NEAR(2, box.calculateSurfaceArea(), 1e-3);
+}
+
+TEST_F(ShapeTest, OptimizeLocality)
+{
+    Shape shape = ShapeFactory::Extrusion(Contour2D::Circle({ 0,0 }, 1, 64));
+    Scalar A = shape.calculateSurfaceArea();
+    Scalar V = shape.calculateVolume();
+    size_t faceCount = shape.getRawFaces().size();
+    size_t vertexCount = shape.getVertices().size();
+    shape.optimize(true);
+    EXPECT_EQ(faceCount, shape.getRawFaces().size());
+    EXPECT_EQ(vertexCount, shape.getVertices().size());
+    EXPECT_FLOAT_EQ(A, shape.calculateSurfaceArea());
+    EXPECT_FLOAT_EQ(V, shape.calculateVolume());
+    // vertices are numbered in order of first use
+    size_t next = 0;
+    for (const auto& face : shape.getRawFaces())
+    {
+        for (const auto& point : face)
+        {
+            EXPECT_LE(point, next);
+            if (point == next) ++next;
+        }
+    }
+    EXPECT_EQ(vertexCount, next);
+}
+
+TEST_F(ShapeTest, Simplify)
+{
+    Shape cylinder = ShapeFactory::Extrusion(Contour2D::Circle({ 0,0 }, 1, 64));
+    Scalar V = cylinder.calculateVolume();
+    Shape simplified = cylinder.simplify(64);
+    EXPECT_GE(64, simplified.getRawFaces().size());
+    EXPECT_NEAR(V, simplified.calculateVolume(), V * 0.1);
+    // a box can't be simplified without error
+    Shape box = ShapeFactory::Box();
+    Shape same = box.simplify(4, 1e-6);
+    EXPECT_EQ(12, same.getRawFaces().size());
+    EXPECT_FLOAT_EQ(1, same.calculateVolume());
+}
+
+TEST_F(ShapeTest, LevelOfDetail)
+{
+    Shape cylinder = ShapeFactory::Extrusion(Contour2D::Circle({ 0,0 }, 1, 64));
+    cylinder.translate({ 1,2,3 });
+    const Shape& level0 = cylinder.getLevelOfDetail(0);
+    EXPECT_EQ(&cylinder, &level0);
+    const Shape& level1 = cylinder.getLevelOfDetail(1);
+    EXPECT_GE(128, level1.getRawFaces().size());
+    const Shape& level2 = cylinder.getLevelOfDetail(2);
+    EXPECT_GE(64, level2.getRawFaces().size());
+    // levels follow the transformation of the shape
+    EXPECT_NEAR(cylinder.getTransformedVertices()[0].z, level2.getTransformedVertices()[0].z, 1.01);
+    cylinder.translate({ 0,0,10 });
+    EXPECT_NEAR(cylinder.getTransformedVertices()[0].z, cylinder.getLevelOfDetail(2).getTransformedVertices()[0].z, 1.01);
+}
+
+TEST_F(ShapeTest, Instancing)
+{
+    Shape box = ShapeFactory::Box({ -1,-1,-1 }, { 1,1,1 });
+    Shape copy = box;
+    EXPECT_EQ(&box.getVertices(), &copy.getVertices());
+    EXPECT_EQ(&box.getEdges(), &copy.getEdges());
+    // moving a copy keeps the geometry shared
+    copy.translate({ 5,0,0 });
+    EXPECT_EQ(&box.getRawFaces(), &copy.getRawFaces());
+    EXPECT_NEAR(5, copy.getTransformedVertices()[0].x - box.getTransformedVertices()[0].x, 1e-12);
+    // changing the geometry of a copy leaves the others alone
+    copy.scale(2);
+    EXPECT_NE(&box.getVertices(), &copy.getVertices());
+    EXPECT_FLOAT_EQ(8, box.calculateVolume());
+    EXPECT_FLOAT_EQ(64, copy.calculateVolume());
+    // the moved from shape is empty
+    Shape moved = std::move(copy);
+    EXPECT_EQ(0, copy.getVertices().size());
+    EXPECT_FLOAT_EQ(64, moved.calculateVolume());
+}
+
+TEST_F(ShapeTest, ConcurrentQueries)
+{
+    Shape sphere = ShapeFactory::Sphere({ 0,0,0 }, 1, 32, 16);
+    sphere.translate({ 1,2,3 });
+    const Shape reference = ShapeFactory::Sphere({ 0,0,0 }, 1, 32, 16);
+    const Scalar volume = reference.calculateVolume();
+    const Scalar area = reference.calculateSurfaceArea();
+    const Shape copy = sphere;
+    // all volatile data is computed by racing threads, on shared geometry
+    std::vector<int> results(64);
+    Parallel::For(results.size(), [&](const size_t i)
+        {
+            const Shape& shape = (i % 2) ? sphere : copy;
+            bool ok = std::abs(shape.calculateVolume() - volume) < 1e-9;
+            ok = ok && std::abs(shape.calculateSurfaceArea() - area) < 1e-9;
+            ok = ok && shape.isConvex();
+            ok = ok && shape.contains({ 1,2,3 }) && !shape.contains({ 3,2,3 });
+            ok = ok && shape.getTransformedNormals().size() == shape.getRawFaces().size();
+            ok = ok && shape.getLevelOfDetail(1).getRawFaces().size() < shape.getRawFaces().size();
+            results[i] = ok;
+        }, 1);
+    EXPECT_EQ(results.size(), (size_t)std::count(results.begin(), results.end(), 1));
+}
+
+TEST_F(ShapeTest, LoopSubdivision)
+{
+    Shape octahedron = ShapeFactory::Octahedron();
+    Shape level1 = ShapeFactory::LoopSubdivision(octahedron);
+    EXPECT_EQ(6 + 12, level1.getVertices().size());
+    EXPECT_EQ(8 * 4, level1.getRawFaces().size());
+    Shape level3 = ShapeFactory::LoopSubdivision(octahedron, 3);
+    EXPECT_EQ(8 * 4 * 4 * 4, level3.getRawFaces().size());
+    // valence 4: beta = (5/8 - (3/8 + cos(2pi/4)/4)^2) / 4
+    EXPECT_CONTAINER_DOUBLE_EQ(Vertex(0, 0, -(1 - 4 * 0.12109375)), level1.getVertices()[0]);
+    // edge point: 3/8 of the end points, 1/8 of the opposite points
+    EXPECT_CONTAINER_DOUBLE_EQ(Vertex(0.375, 0, -0.375), level1.getVertices()[6 + 0]);
+    // the surface shrinks inside the control cage
+    EXPECT_LT(level3.calculateVolume(), level1.calculateVolume());
+    EXPECT_LT(level1.calculateVolume(), octahedron.calculateVolume());
+    EXPECT_THROW(ShapeFactory::LoopSubdivision(ShapeFactory::Box()), std::invalid_argument);
+}
+
+TEST_F(ShapeTest, CatmullClarkSubdivision)
+{
+    Shape box = ShapeFactory::Box({ -1,-1,-1 }, { 1,1,1 });
+    Shape level1 = ShapeFactory::CatmullClarkSubdivision(box);
+    EXPECT_EQ(8 + 12 + 6, level1.getVertices().size());
+    EXPECT_EQ(6 * 4, level1.getRawFaces().size());
+    for (const auto& face : level1.getRawFaces())
+    {
+        EXPECT_EQ(4, face.size());
+    }
+    // corner: (F + 2R + (n-3)P) / n = (1/3 + 4/3) / 3
+    EXPECT_CONTAINER_DOUBLE_EQ(Vertex(5.0 / 9, 5.0 / 9, 5.0 / 9), level1.getVertices()[0]);
+    Shape level3 = ShapeFactory::CatmullClarkSubdivision(box, 3);
+    EXPECT_EQ(6 * 4 * 4 * 4, level3.getRawFaces().size());
+    EXPECT_LT(level3.calculateVolume(), level1.calculateVolume());
+    EXPECT_LT(level1.calculateVolume(), 8);
+    // open shapes keep their border
+    Shape extrusion = ShapeFactory::CatmullClarkSubdivision(ShapeFactory::Extrusion(Contour2D::Circle({ 0,0 }, 1, 12)), 2);
+    EXPECT_GT(extrusion.calculateVolume(), 0);
+}
+
+
+TEST_F(ShapeTest, OctahedronPlacement)
+{
+    Shape octahedron = ShapeFactory::Octahedron({ 1,2,3 }, 2);
+    // volume of the unit octahedron is 4/3
+    EXPECT_NEAR(8 * 4.0 / 3, octahedron.calculateVolume(), 1e-9);
+    for (const auto& vertex : octahedron.getVertices())
+    {
+        EXPECT_NEAR(2, (vertex - Vertex(1, 2, 3)).length(), 1e-12);
+    }
+}
+
+TEST_F(ShapeTest, Segments)
+{
+    EXPECT_EQ(3, ShapeFactory::Segments(1, 2));
+    EXPECT_EQ(4, ShapeFactory::Segments(1, 1 - cos(Constants::Pi / 4)));
+    const size_t segments = ShapeFactory::Segments(10, 0.01);
+    EXPECT_LE(10 * (1 - cos(Constants::Pi / segments)), 0.01);
+    EXPECT_GT(10 * (1 - cos(Constants::Pi / (segments - 1))), 0.01);
+}
+
+TEST_F(ShapeTest, Primitives)
+{
+    const Scalar pi = Constants::Pi;
+    Shape sphere = ShapeFactory::Sphere({ 1,0,0 }, 2, 64, 32);
+    EXPECT_EQ(2 + 31 * 64, sphere.getVertices().size());
+    EXPECT_EQ(32 * 64, sphere.getRawFaces().size());
+    EXPECT_NEAR(4 * pi * 8 / 3, sphere.calculateVolume(), 0.2);
+    EXPECT_NEAR(4 * pi * 4, sphere.calculateSurfaceArea(), 0.2);
+
+    Shape icosphere = ShapeFactory::Icosphere({ 0,0,0 }, 1, 3);
+    EXPECT_EQ(20 * 64, icosphere.getRawFaces().size());
+    EXPECT_EQ(2 + 10 * 64, icosphere.getVertices().size());
+    EXPECT_NEAR(4 * pi / 3, icosphere.calculateVolume(), 0.05);
+    for (const auto& vertex : icosphere.getVertices())
+    {
+        EXPECT_NEAR(1, vertex.length(), 1e-12);
+    }
+
+    Shape cylinder = ShapeFactory::Cylinder({ 0,0,0 }, 1, 2, 128);
+    EXPECT_EQ(256, cylinder.getVertices().size());
+    EXPECT_EQ(130, cylinder.getRawFaces().size());
+    EXPECT_NEAR(2 * pi, cylinder.calculateVolume(), 0.01);
+    EXPECT_NEAR(6 * pi, cylinder.calculateSurfaceArea(), 0.01);
+
+    Shape cone = ShapeFactory::Cone({ 0,0,0 }, 1, 3, 128);
+    EXPECT_EQ(129, cone.getVertices().size());
+    EXPECT_NEAR(pi, cone.calculateVolume(), 0.01);
+
+    Shape torus = ShapeFactory::Torus({ 0,0,0 }, 2, 0.5, 128, 64);
+    EXPECT_EQ(128 * 64, torus.getRawFaces().size());
+    EXPECT_NEAR(2 * pi * pi * 2 * 0.25, torus.calculateVolume(), 0.05);
+
+    Shape capsule = ShapeFactory::Capsule({ 0,0,0 }, 1, 2, 64, 16);
+    EXPECT_EQ(2 + 32 * 64, capsule.getVertices().size());
+    EXPECT_NEAR(4 * pi / 3 + 2 * pi, capsule.calculateVolume(), 0.05);
+
+    EXPECT_THROW(ShapeFactory::Sphere({ 0,0,0 }, 1, 16, 1), std::invalid_argument);
+    EXPECT_THROW(ShapeFactory::Sphere({ 0,0,0 }, 1, 2, 8), std::invalid_argument);
+    EXPECT_THROW(ShapeFactory::Cylinder({ 0,0,0 }, 1, 1, 2), std::invalid_argument);
+    EXPECT_THROW(ShapeFactory::Cone({ 0,0,0 }, 1, 1, 0), std::invalid_argument);
+    EXPECT_THROW(ShapeFactory::Torus({ 0,0,0 }, 1, 0.25, 0, 12), std::invalid_argument);
+    EXPECT_THROW(ShapeFactory::Capsule({ 0,0,0 }, 1, 1, 16, 0), std::invalid_argument);
+    EXPECT_EQ(5, ShapeFactory::Sphere({ 0,0,0 }, 1, 3, 2).getVertices().size());
+}
+
+TEST_F(ShapeTest, Raycast)
+{
+    Shape box = ShapeFactory::Box({ -1,-1,-1 }, { 1,1,1 });
+    RayHit hit = box.raycast(Ray({ 0.5, 0.25, 5 }, { 0, 0, -1 }));
+    ASSERT_TRUE(hit);
+    EXPECT_DOUBLE_EQ(4, hit.distance);
+    EXPECT_NEAR(0, box.getNormals()[hit.face].innerProduct(Vertex(0, 0, 1)) - 1, 1e-12);
+    EXPECT_FALSE(box.raycast(Ray({ 0.5, 0.25, 5 }, { 0, 0, 1 })));
+    EXPECT_FALSE(box.raycast(Ray({ 0.5, 0.25, 5 }, { 0, 0, -1 }, 3.5)));
+    EXPECT_FALSE(box.raycast(Ray({ 2, 0, 5 }, { 0, 0, -1 })));
+    // from the inside
+    hit = box.raycast(Ray({ 0, 0, 0 }, { 1, 0, 0 }));
+    ASSERT_TRUE(hit);
+    EXPECT_DOUBLE_EQ(1, hit.distance);
+    EXPECT_TRUE(box.raycastAny(Ray({ 0.5, 0.25, 5 }, { 0, 0, -1 })));
+
+    // the ray is moved into the local space of the shape
+    box.translate({ 10, 0, 0 });
+    box.rotate({ 0, 0, 1 }, Constants::Pi / 4);
+    hit = box.raycast(Ray({ 10, 0, 5 }, { 0, 0, -1 }));
+    ASSERT_TRUE(hit);
+    EXPECT_NEAR(4, hit.distance, 1e-12);
+    hit = box.raycast(Ray({ 5, 0, 0 }, { 1, 0, 0 }));
+    ASSERT_TRUE(hit);
+    EXPECT_NEAR(5 - sqrt(2), hit.distance, 1e-12);
+}
+
+TEST_F(ShapeTest, RaycastBatch)
+{
+    Shape sphere = ShapeFactory::Icosphere({ 0,0,0 }, 1, 4);
+    sphere.translate({ 0, 0, 1 });
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<Scalar> dist(-1.5, 1.5);
+    std::vector<Ray> rays;
+    for (size_t i = 0; i < 1001; ++i)
+    {
+        const Vertex origin(dist(gen), dist(gen), 5);
+        rays.emplace_back(origin, Vertex(dist(gen) / 10, dist(gen) / 10, -1));
+    }
+    const auto hits = sphere.raycast(rays);
+    const auto anyHits = sphere.raycastAny(rays);
+    ASSERT_EQ(rays.size(), hits.size());
+    size_t count = 0;
+    for (size_t i = 0; i < rays.size(); ++i)
+    {
+        const RayHit single = sphere.raycast(rays[i]);
+        EXPECT_EQ(single.face, hits[i].face);
+        EXPECT_DOUBLE_EQ(single.distance, hits[i].distance);
+        EXPECT_EQ((bool)single, (bool)anyHits[i]);
+        if (single)
+        {
+            ++count;
+            // the hit point is on the sphere, which is on the front side
+            const Vertex point = rays[i].origin + rays[i].direction * single.distance;
+            EXPECT_NEAR(1, (point - Vertex(0, 0, 1)).length(), 0.01);
+            EXPECT_GT(point.z, 0.9);
+            EXPECT_LE(single.distance, anyHits[i].distance);
+        }
+    }
+    EXPECT_GT(count, 200);
+}
+
+TEST_F(ShapeTest, Contains)
+{
+    Shape box = ShapeFactory::Box({ -1,-1,-1 }, { 1,1,1 });
+    EXPECT_TRUE(box.contains({ 0, 0, 0 }));
+    EXPECT_TRUE(box.contains({ 0.99, -0.99, 0.5 }));
+    EXPECT_FALSE(box.contains({ 1.01, 0, 0 }));
+    box.translate({ 5, 0, 0 });
+    EXPECT_FALSE(box.contains({ 0, 0, 0 }));
+    EXPECT_TRUE(box.contains({ 5.5, 0.5, 0 }));
+
+    // the hole of a torus is outside
+    Shape torus = ShapeFactory::Torus({ 0,0,0 }, 2, 0.5, 64, 32);
+    EXPECT_FALSE(torus.contains({ 0, 0, 0 }));
+    EXPECT_TRUE(torus.contains({ 2, 0, 0 }));
+    EXPECT_TRUE(torus.contains({ 0, -2.3, 0.1 }));
+    EXPECT_FALSE(torus.contains({ 0, -2.6, 0 }));
+}
+
+TEST_F(ShapeTest, ContainsBatch)
+{
+    Shape sphere = ShapeFactory::Icosphere({ 0,0,0 }, 1, 4);
+    sphere.rotate({ 1,0,0 }, 0.3);
+    std::mt19937 gen(3);
+    std::uniform_real_distribution<Scalar> dist(-1.2, 1.2);
+    Vertices points;
+    for (size_t i = 0; i < 5000; ++i)
+    {
+        points.emplace_back(dist(gen), dist(gen), dist(gen));
+    }
+    std::vector<bool> inside;
+    sphere.contains(points, inside);
+    ASSERT_EQ(points.size(), inside.size());
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        EXPECT_EQ(sphere.contains(points[i]), inside[i]);
+        // the icosphere is within 0.01 of the sphere
+        const Scalar radius = points[i].length();
+        if (radius < 0.99 || radius > 1)
+        {
+            EXPECT_EQ(radius < 1, inside[i]);
+        }
+    }
+}
+
+TEST_F(ShapeTest, Convexity)
+{
+    EXPECT_TRUE(ShapeFactory::Box({ -1,-1,-1 }, { 1,2,3 }).isConvex());
+    EXPECT_TRUE(ShapeFactory::Octahedron().isConvex());
+    EXPECT_TRUE(ShapeFactory::Dodecahedron().isConvex());
+    EXPECT_TRUE(ShapeFactory::Extrusion(Contour2D::Circle({ 0,0 }, 1, 12)).isConvex());
+    EXPECT_TRUE(ShapeFactory::Sphere().isConvex());
+    EXPECT_TRUE(ShapeFactory::Capsule().isConvex());
+    EXPECT_FALSE(ShapeFactory::Torus().isConvex());
+    // a box with a dent in the top
+    Vertices vertices = { {0,0,0}, {1,0,0}, {1,1,0}, {0,1,0}, {0,0,1}, {1,0,1}, {1,1,1}, {0,1,1}, {0.5,0.5,0.5} };
+    Faces faces = { Face({0,3,2,1}), Face({0,1,5,4}), Face({1,2,6,5}), Face({2,3,7,6}), Face({3,0,4,7}),
+        Face({4,5,8}), Face({5,6,8}), Face({6,7,8}), Face({7,4,8}) };
+    Shape dented(vertices, faces);
+    EXPECT_FALSE(dented.isConvex());
+    vertices[8].z = 1.5;
+    EXPECT_TRUE(Shape(vertices, faces).isConvex());
+}
+
+TEST_F(ShapeTest, DistanceAndPenetration)
+{
+    Shape a = ShapeFactory::Box({ -1,-1,-1 }, { 1,1,1 });
+    Shape b = ShapeFactory::Box({ -1,-1,-1 }, { 1,1,1 });
+    b.translate({ 5, 0.5, 0 });
+    EXPECT_NEAR(3, a.calculateDistance(b), 1e-9);
+    EXPECT_FALSE(a.detectCollision(b));
+    b.translate({ 0, 0, 3 });
+    EXPECT_NEAR(sqrt(9 + 1), a.calculateDistance(b), 1e-9);
+
+    Shape c = ShapeFactory::Box({ -1,-1,-1 }, { 1,1,1 });
+    c.translate({ 1.5, 0.25, 0 });
+    EXPECT_TRUE(a.detectCollision(c));
+    EXPECT_EQ(0, a.calculateDistance(c));
+    Normal direction;
+    EXPECT_NEAR(0.5, a.calculatePenetration(c, direction), 1e-9);
+    EXPECT_NEAR(1, direction.x, 1e-9);
+    EXPECT_EQ(0, a.calculatePenetration(b, direction));
+
+    // rotated, touching the corner
+    Shape d = ShapeFactory::Box({ -1,-1,-1 }, { 1,1,1 });
+    d.rotate({ 0,0,1 }, Constants::Pi / 4);
+    d.translate({ 1 + sqrt(2) + 0.1, 0, 0 });
+    EXPECT_NEAR(0.1, a.calculateDistance(d), 1e-9);
+    EXPECT_FALSE(a.detectCollision(d));
+
+    // round shapes, the hill climbing has to cross many vertices.
+    // The direction is a face normal of the difference of the polytopes.
+    Shape e = ShapeFactory::Icosphere({ 0,0,0 }, 1, 4);
+    Shape f = ShapeFactory::Icosphere({ 0,0,0 }, 1, 4);
+    f.translate({ 3, 4, 0 });
+    EXPECT_NEAR(3, e.calculateDistance(f), 0.01);
+    EXPECT_GE(e.calculateDistance(f), 3);
+    f.translate({ -2.1, -2.8, 0 });
+    EXPECT_TRUE(e.detectCollision(f));
+    EXPECT_NEAR(0.5, e.calculatePenetration(f, direction), 0.01);
+    EXPECT_NEAR(0.6, direction.x, 0.05);
+    EXPECT_NEAR(0.8, direction.y, 0.05);
+
+    // an open strip using every Index value, its support points are searched one by one
+    Vertices vertices;
+    Faces faces;
+    for (size_t i = 0; i < 65536; ++i)
+    {
+        vertices.emplace_back((Scalar)(i / 2), (Scalar)(i % 2), 0);
+    }
+    for (size_t i = 2; i < 65536; i += 2)
+    {
+        faces.emplace_back(std::vector<Index>{ (Index)(i - 2), (Index)(i - 1), (Index)(i + 1), (Index)i });
+    }
+    Shape strip(vertices, faces);
+    EXPECT_FALSE(strip.isConvex());
+    Shape g = ShapeFactory::Box({ 0,0,0 }, { 1,1,1 });
+    g.translate({ 32770, 0, 0 });
+    EXPECT_NEAR(3, strip.calculateDistance(g), 1e-9);
+    EXPECT_FALSE(strip.detectCollision(g));
+}
+
+TEST_F(ShapeTest, ConvexHull)
+{
+    // box corners and points inside
+    Vertices points = ShapeFactory::Box({ -1,-1,-1 }, { 1,1,1 }).getVertices();
+    std::mt19937 gen(11);
+    std::uniform_real_distribution<Scalar> dist(-1, 1);
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        points.emplace_back(dist(gen), dist(gen), dist(gen));
+    }
+    Shape box = ShapeFactory::ConvexHull(points);
+    EXPECT_EQ(8, box.getVertices().size());
+    EXPECT_EQ(12, box.getRawFaces().size());
+    EXPECT_NEAR(8, box.calculateVolume(), 1e-12);
+    EXPECT_TRUE(box.isConvex());
+
+    // random points in a ball, all of them end up inside or on the hull
+    points.clear();
+    while (points.size() < 20000)
+    {
+        const Vertex point(dist(gen), dist(gen), dist(gen));
+        if (point.length() <= 1)
+        {
+            points.emplace_back(point);
+        }
+    }
+    Shape ball = ShapeFactory::ConvexHull(points);
+    EXPECT_TRUE(ball.isConvex());
+    EXPECT_LT(ball.calculateVolume(), 4 * Constants::Pi / 3);
+    EXPECT_GT(ball.calculateVolume(), 4.0);
+    const auto& vertices = ball.getVertices();
+    const auto& normals = ball.getNormals();
+    // (checking the first faces is enough)
+    for (size_t i = 0; i < std::min<size_t>(50, ball.getRawFaces().size()); ++i)
+    {
+        const Vertex& corner = vertices[ball.getRawFace(i)[0]];
+        Scalar furthest = Limits<Scalar>::MinValue;
+        for (const auto& point : points)
+        {
+            furthest = std::max(furthest, normals[i].innerProduct(point - corner));
+        }
+        EXPECT_LT(furthest, 1e-12);
+    }
+
+    // the vertices of a convex shape are their own hull
+    Shape sphere = ShapeFactory::Icosphere({ 0,0,0 }, 1, 3);
+    Shape hull = ShapeFactory::ConvexHull(sphere.getVertices());
+    EXPECT_EQ(sphere.getVertices().size(), hull.getVertices().size());
+    EXPECT_NEAR(sphere.calculateVolume(), hull.calculateVolume(), 1e-12);
+
+    EXPECT_THROW(ShapeFactory::ConvexHull({ {0,0,0}, {1,0,0}, {0,1,0}, {1,1,0} }), std::invalid_argument);
+}
+
+namespace
+{
+    // every edge has an edge in the opposite direction
+    // Every edge is used once in each direction
+    bool IsClosed(const Shape& shape)
+    {
+        std::set<std::pair<Index, Index>> edges;
+        for (const auto& face : shape.getRawFaces())
+        {
+            for (size_t i = 0, j = face.size() - 1; i < face.size(); j = i++)
+            {
+                if (!edges.emplace(face[j], face[i]).second)
+                {
+                    return false;
+                }
+            }
+        }
+        for (const auto& edge : edges)
+        {
+            if (edges.count({ edge.second, edge.first }) == 0)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+TEST_F(ShapeTest, Boolean)
+{
+    Shape a = ShapeFactory::Box({ -1,-1,-1 }, { 1,1,1 });
+    Shape b = ShapeFactory::Box({ 0,0,0 }, { 2,2,2 });
+    b.translate({ 0.1, 0.2, 0.3 });
+    const Scalar overlap = 0.9 * 0.8 * 0.7;
+
+    Shape united = ShapeFactory::Union(a, b);
+    EXPECT_TRUE(IsClosed(united));
+    EXPECT_NEAR(16 - overlap, united.calculateVolume(), 1e-9);
+
+    Shape intersection = ShapeFactory::Intersection(a, b);
+    EXPECT_TRUE(intersection.isConvex());
+    EXPECT_NEAR(overlap, intersection.calculateVolume(), 1e-9);
+
+    Shape difference = ShapeFactory::Difference(a, b);
+    EXPECT_TRUE(IsClosed(difference));
+    EXPECT_NEAR(8 - overlap, difference.calculateVolume(), 1e-9);
+    EXPECT_TRUE(difference.contains({ -0.5, -0.5, -0.5 }));
+    EXPECT_FALSE(difference.contains({ 0.5, 0.5, 0.5 }));
+
+    // disjoint shapes
+    Shape far = ShapeFactory::Box({ 5,5,5 }, { 6,6,6 });
+    EXPECT_NEAR(9, ShapeFactory::Union(a, far).calculateVolume(), 1e-9);
+    EXPECT_EQ(0, ShapeFactory::Intersection(a, far).getRawFaces().size());
+    EXPECT_NEAR(8, ShapeFactory::Difference(a, far).calculateVolume(), 1e-9);
+}
+
+TEST_F(ShapeTest, BooleanCoplanar)
+{
+    // faces in the same planes
+    Shape a = ShapeFactory::Box({ 0,0,0 }, { 1,1,1 });
+    Shape b = ShapeFactory::Box({ 0.5,0,0 }, { 1.5,1,1 });
+    Shape united = ShapeFactory::Union(a, b);
+    EXPECT_TRUE(IsClosed(united));
+    EXPECT_NEAR(1.5, united.calculateVolume(), 1e-9);
+    Shape intersection = ShapeFactory::Intersection(a, b);
+    EXPECT_TRUE(IsClosed(intersection));
+    EXPECT_NEAR(0.5, intersection.calculateVolume(), 1e-9);
+    Shape difference = ShapeFactory::Difference(a, b);
+    EXPECT_TRUE(IsClosed(difference));
+    EXPECT_NEAR(0.5, difference.calculateVolume(), 1e-9);
+    EXPECT_TRUE(difference.contains({ 0.25, 0.5, 0.5 }));
+    EXPECT_FALSE(difference.contains({ 0.75, 0.5, 0.5 }));
+
+    // touching in a face
+    Shape touching = ShapeFactory::Box({ 1,0.25,0.25 }, { 2,0.75,0.75 });
+    Shape attached = ShapeFactory::Union(a, touching);
+    EXPECT_TRUE(IsClosed(attached));
+    EXPECT_NEAR(1.25, attached.calculateVolume(), 1e-9);
+    EXPECT_EQ(0, ShapeFactory::Intersection(a, touching).getRawFaces().size());
+    Shape unchanged = ShapeFactory::Difference(a, touching);
+    EXPECT_TRUE(IsClosed(unchanged));
+    EXPECT_NEAR(1, unchanged.calculateVolume(), 1e-9);
+    Shape neighbour = ShapeFactory::Box({ 1,0,0 }, { 2,1,1 });
+    Shape pair = ShapeFactory::Union(a, neighbour);
+    EXPECT_TRUE(IsClosed(pair));
+    EXPECT_NEAR(2, pair.calculateVolume(), 1e-9);
+
+    // identical
+    Shape same = ShapeFactory::Union(a, a);
+    EXPECT_TRUE(IsClosed(same));
+    EXPECT_NEAR(1, same.calculateVolume(), 1e-9);
+    Shape common = ShapeFactory::Intersection(a, a);
+    EXPECT_TRUE(IsClosed(common));
+    EXPECT_NEAR(1, common.calculateVolume(), 1e-9);
+    EXPECT_EQ(0, ShapeFactory::Difference(a, a).getRawFaces().size());
+
+    // coplanar faces of a rotated shape
+    Shape c = ShapeFactory::Cylinder({ 0,0,0 }, 1, 2, 24);
+    Shape d = ShapeFactory::Cylinder({ 0,0,0 }, 0.5, 2, 24);
+    c.rotate({ 1,2,3 }, 0.4);
+    d.rotate({ 1,2,3 }, 0.4);
+    Shape tube = ShapeFactory::Difference(c, d);
+    EXPECT_TRUE(IsClosed(tube));
+    EXPECT_NEAR(c.calculateVolume() - d.calculateVolume(), tube.calculateVolume(), 1e-9);
+}
+
+TEST_F(ShapeTest, BooleanRound)
+{
+    // a sphere with a cylinder drilled through it
+    Shape sphere = ShapeFactory::Icosphere({ 0,0,0 }, 1, 3);
+    Shape cylinder = ShapeFactory::Cylinder({ 0,0,0 }, 0.3, 3, 32);
+    cylinder.rotate({ 1,0,0 }, 0.2);
+    Shape drilled = ShapeFactory::Difference(sphere, cylinder);
+    Shape core = ShapeFactory::Intersection(sphere, cylinder);
+    EXPECT_TRUE(IsClosed(drilled));
+    EXPECT_TRUE(IsClosed(core));
+    EXPECT_NEAR(sphere.calculateVolume(), drilled.calculateVolume() + core.calculateVolume(), 1e-9);
+    EXPECT_FALSE(drilled.contains({ 0, 0, 0 }));
+    EXPECT_TRUE(core.contains({ 0, 0, 0 }));
+    Shape united = ShapeFactory::Union(sphere, cylinder);
+    EXPECT_TRUE(IsClosed(united));
+    EXPECT_NEAR(sphere.calculateVolume() + cylinder.calculateVolume() - core.calculateVolume(), united.calculateVolume(), 1e-9);
+}
+
+TEST_F(ShapeTest, Sweep)
+{
+    const Scalar pi = Constants::Pi;
+    // a straight path is an extrusion
+    Shape straight = ShapeFactory::Sweep(Contour2D::Square(), Contour3D().add(0, 0, 0).add(0, 0, 0.5).add(0, 0, 1));
+    EXPECT_EQ(12, straight.getVertices().size());
+    EXPECT_TRUE(IsClosed(straight));
+    EXPECT_FLOAT_EQ(1, straight.calculateVolume());
+    EXPECT_FLOAT_EQ(6, straight.calculateSurfaceArea());
+    // a closed circle is a torus
+    Contour3D circle;
+    for (size_t i = 0; i < 256; ++i)
+    {
+        const Scalar a = 2 * pi * i / 256;
+        circle.add(2 * cos(a), 2 * sin(a), 0);
+    }
+    Shape torus = ShapeFactory::Sweep(Contour2D::Circle({ 0,0 }, 0.5, 64), circle, true);
+    EXPECT_EQ(256 * 64, torus.getRawFaces().size());
+    EXPECT_TRUE(IsClosed(torus));
+    EXPECT_NEAR(2 * pi * pi * 2 * 0.25, torus.calculateVolume(), 0.05);
+    // the profile doesn't twist along a helix
+    Contour3D helix;
+    for (size_t i = 0; i <= 2000; ++i)
+    {
+        const Scalar a = 8 * pi * i / 2000;
+        helix.add(3 * cos(a), 3 * sin(a), a / 2);
+    }
+    const Contour2D profile = Contour2D::Square({ -0.5,-0.1 }, { 0.5,0.1 });
+    Shape spring = ShapeFactory::Sweep(profile, helix);
+    EXPECT_TRUE(IsClosed(spring));
+    const Scalar length = 8 * pi * sqrt(9 + 0.25);
+    EXPECT_NEAR(0.2 * length, spring.calculateVolume(), 0.01);
+    EXPECT_NEAR(2.4 * length + 0.4, spring.calculateSurfaceArea(), 0.01);
+    // degenerate input
+    const Contour3D line = Contour3D().add(0, 0, 0).add(0, 0, 1);
+    EXPECT_THROW(ShapeFactory::Sweep(profile, Contour3D().add(0, 0, 0)), std::invalid_argument);
+    EXPECT_THROW(ShapeFactory::Sweep(profile, Contour3D().add(0, 0, 0).add(0, 0, 0).add(0, 0, 1)), std::invalid_argument);
+    EXPECT_THROW(ShapeFactory::Sweep(profile, Contour3D().add(0, 0, 0).add(1, 0, 0).add(0, 0, 0), true), std::invalid_argument);
+    EXPECT_THROW(ShapeFactory::Sweep(Contour2D().add(0, 0).add(1, 0), line), std::invalid_argument);
+}
+
+TEST_F(ShapeTest, Revolve)
+{
+    const Scalar pi = Constants::Pi;
+    // a square ring, volume by Pappus
+    Shape ring = ShapeFactory::Revolve(Contour2D::Square({ 1,0 }, { 2,1 }), { 0,0,1 }, 256);
+    EXPECT_EQ(4 * 256, ring.getVertices().size());
+    EXPECT_TRUE(IsClosed(ring));
+    EXPECT_NEAR(2 * pi * 1.5, ring.calculateVolume(), 1e-3);
+    // a sphere from a half circle, the ends on the axis
+    Contour2D half;
+    for (size_t i = 0; i <= 64; ++i)
+    {
+        const Scalar a = pi * i / 64;
+        half.add(sin(a), -cos(a));
+    }
+    Shape sphere = ShapeFactory::Revolve(half, { 1,1,0 }, 128);
+    EXPECT_EQ(2 + 63 * 128, sphere.getVertices().size());
+    EXPECT_EQ(64 * 128, sphere.getRawFaces().size());
+    EXPECT_TRUE(IsClosed(sphere));
+    EXPECT_NEAR(4 * pi / 3, sphere.calculateVolume(), 0.01);
+    for (const auto& vertex : sphere.getVertices())
+    {
+        EXPECT_NEAR(1, vertex.length(), 1e-12);
+    }
+    // degenerate input
+    EXPECT_THROW(ShapeFactory::Revolve(half, { 0,0,0 }), std::invalid_argument);
+    EXPECT_THROW(ShapeFactory::Revolve(half, { 0,0,1 }, 2), std::invalid_argument);
+    EXPECT_THROW(ShapeFactory::Revolve(Contour2D().add(1, 0).add(1, 1)), std::invalid_argument);
+    // a profile reaching across the axis
+    EXPECT_THROW(ShapeFactory::Revolve(Contour2D::Square({ -1,0 }, { 1,1 })), std::invalid_argument);
+}
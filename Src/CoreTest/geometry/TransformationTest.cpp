@@ -56,3 +56,25 @@ TEST_F(TransformationTest, RotationTranslation)
     Vertex res(2-1, 4+1, 6+0);
     EXPECT_CONTAINER_DOUBLE_EQ(res, t * v);
 }
+
+TEST_F(TransformationTest, Inverted)
+{
+    Transformation t = Transformation({ 1, 2, 3 }) * Transformation({ 1, 1, 0 }, 0.7);
+    Transformation inverse = t.inverted();
+    Vertex v(4, -5, 6);
+    EXPECT_CONTAINER_DOUBLE_EQ(v, inverse * (t * v));
+    EXPECT_CONTAINER_DOUBLE_EQ(v, t * (inverse * v));
+    EXPECT_CONTAINER_DOUBLE_EQ(v, inverse.rotate(t.rotate(v)));
+}
+
+TEST_F(TransformationTest, Precision)
+{
+    Transformation t = Transformation({ 1, 2, 3 }) * Transformation({ 0, 0, 1 }, Constants::Pi / 2);
+    TransformationF f(t);
+    VertexF v = f * VertexF(1, 1, 0);
+    EXPECT_NEAR(0.0f, v.x, 1e-6f);
+    EXPECT_NEAR(3.0f, v.y, 1e-6f);
+    EXPECT_NEAR(3.0f, v.z, 1e-6f);
+    TransformationF r({ 0, 0, 1 }, (float)Constants::Pi / 2);
+    EXPECT_NEAR(-1.0f, r.rotate(VertexF(0, 1, 0)).x, 1e-6f);
+}
@@ -0,0 +1,89 @@
+﻿#include <algorithm>
+#include <sstream>
+
+#include "GoogleTest.h"
+#include "Core.h"
+
+using namespace std;
+using namespace testing;
+
+class OutputBufferTest : public Test
+{
+protected:
+    virtual void SetUp()
+    {
+    }
+
+    virtual void TearDown()
+    {
+    }
+};
+
+TEST_F(OutputBufferTest, Numbers)
+{
+    string text;
+    {
+        OutputBuffer out([&text](const char* data, const size_t size) { text.append(data, size); });
+        out << 42 << ' ' << -7 << ' ' << (size_t)123456789 << ' ';
+        out << 1.5 << ' ' << 0.1 << ' ' << 3.14159265 << ' ' << -250.0 << ' ' << 1e-7;
+        EXPECT_TRUE(text.empty());
+    }
+    EXPECT_EQ("42 -7 123456789 1.5 0.1 3.1416 -250 1e-07", text);
+}
+
+TEST_F(OutputBufferTest, Precision)
+{
+    string text;
+    {
+        OutputBuffer out([&text](const char* data, const size_t size) { text.append(data, size); });
+        out.setPrecision(9);
+        out << 3.14159265 << ' ';
+        // more digits than a double has are limited to 17
+        out.setPrecision(40);
+        out << 0.1 << ' ' << -1.2345678901234567e-300;
+    }
+    EXPECT_EQ("3.14159265 0.10000000000000001 -1.2345678901234568e-300", text);
+}
+
+TEST_F(OutputBufferTest, Hex)
+{
+    ostringstream os;
+    {
+        OutputBuffer out(os);
+        out << '#';
+        out.hex(205).hex(0).hex(15);
+    }
+    EXPECT_EQ("#cd000f", os.str());
+}
+
+TEST_F(OutputBufferTest, Blocks)
+{
+    string expected;
+    string text;
+    vector<size_t> blocks;
+    {
+        OutputBuffer out([&](const char* data, const size_t size)
+            {
+                text.append(data, size);
+                blocks.emplace_back(size);
+            }, 64);
+        for (int i = 0; i < 100; ++i)
+        {
+            out << i << ',' << i * 0.25 << ';';
+            expected += to_string(i) + ',';
+            ostringstream os;
+            os << i * 0.25 << ';';
+            expected += os.str();
+        }
+        out.flush();
+        EXPECT_EQ(expected, text);
+        EXPECT_LT(10u, blocks.size());
+        EXPECT_LE(*max_element(blocks.begin(), blocks.end()), 64u);
+        // a long text is passed on directly
+        string line(200, 'x');
+        out << line;
+        expected += line;
+    }
+    EXPECT_EQ(expected, text);
+    EXPECT_EQ(200u, blocks.back());
+}
@@ -0,0 +1,94 @@
+﻿#include <sstream>
+
+#include "GoogleTest.h"
+#include "Core.h"
+
+using namespace std;
+using namespace testing;
+
+class RasterTest : public Test
+{
+protected:
+    virtual void SetUp()
+    {
+    }
+
+    virtual void TearDown()
+    {
+    }
+
+    // looking along the z axis, so the boxes show their -z face unshaded
+    static Raster FrontView(const int width, const int height)
+    {
+        const Vertex center(100, 100, 0);
+        return Raster(width, height, { 0,0,200,200 }, SVG::View(center, center - Vertex(0, 0, 1), { 0, -1, 0 }));
+    }
+
+    static bool Equal(const Raster::RGB& a, const Raster::RGB& b)
+    {
+        return a == b;
+    }
+};
+
+TEST_F(RasterTest, Box)
+{
+    Raster raster = FrontView(200, 200);
+    Shape box = ShapeFactory::Box({-1,-1,-1},{1,1,1});
+    box.scale(20);
+    raster.addShape(box, Raster::RGB(200, 0, 0));
+
+    EXPECT_TRUE(Equal(Raster::RGB(200, 0, 0), raster.getPixel(100, 100)));
+    EXPECT_TRUE(Equal(Raster::RGB(255, 255, 255), raster.getPixel(5, 5)));
+    EXPECT_TRUE(Equal(Raster::RGB(255, 255, 255), raster.getPixel(150, 100)));
+    // faces reaching far beyond the raster are clipped to it
+    Raster large = FrontView(50, 50);
+    large.addShape(ShapeFactory::Box({ -1e12,-1e12,-1 }, { 1e12,1e12,1 }), Raster::RGB(200, 0, 0));
+    EXPECT_TRUE(Equal(Raster::RGB(200, 0, 0), large.getPixel(0, 0)));
+    EXPECT_TRUE(Equal(Raster::RGB(200, 0, 0), large.getPixel(49, 49)));
+
+    raster.writeToFile("Box.png", Raster::Format::PNG);
+}
+
+TEST_F(RasterTest, Depth)
+{
+    Raster raster = FrontView(300, 300);
+    Shape back = ShapeFactory::Box({-1,-1,-1},{1,1,1});
+    back.scale(20);
+    Shape front = back;
+    front.translate({ 10, 0, -30 });
+    // the order of adding doesn't matter
+    raster.addShape(front, Raster::RGB(0, 0, 200));
+    raster.addShape(back, Raster::RGB(200, 0, 0));
+
+    // 1.5 pixel per unit, the view decides the direction of the x axis
+    const Vertex center(100, 100, 0);
+    const int side = SVG::View(center, center - Vertex(0, 0, 1), { 0, -1, 0 }).getTransformation().rotate({ 1, 0, 0 }).x > 0 ? 1 : -1;
+    EXPECT_TRUE(Equal(Raster::RGB(200, 0, 0), raster.getPixel(150 - 25 * side, 150)));
+    EXPECT_TRUE(Equal(Raster::RGB(0, 0, 200), raster.getPixel(150, 150)));
+    EXPECT_TRUE(Equal(Raster::RGB(0, 0, 200), raster.getPixel(150 + 40 * side, 150)));
+}
+
+TEST_F(RasterTest, Formats)
+{
+    Raster raster = FrontView(100, 50);
+    Shape dodecahedron = ShapeFactory::Dodecahedron();
+    dodecahedron.scale(40);
+    raster.addShape(dodecahedron, Raster::RGB(50, 100, 150));
+
+    ostringstream ppm;
+    raster.writeToStream(ppm, Raster::Format::PPM);
+    const string header = "P6\n100 50\n255\n";
+    EXPECT_EQ(header.size() + 100 * 50 * 3, ppm.str().size());
+    EXPECT_EQ(header, ppm.str().substr(0, header.size()));
+
+    ostringstream png;
+    raster.writeToStream(png, Raster::Format::PNG);
+    const string text = png.str();
+    EXPECT_EQ(string("\x89PNG\r\n\x1a\n", 8), text.substr(0, 8));
+    EXPECT_EQ("IHDR", text.substr(12, 4));
+    EXPECT_EQ(string("\0\0\0\x64\0\0\0\x32", 8), text.substr(16, 8));
+    // signature, IHDR, IDAT with zlib header, one stored block and adler, IEND
+    const size_t raw = 50 * (1 + 100 * 3);
+    EXPECT_EQ(8 + 25 + 12 + 2 + 5 + raw + 4 + 12, text.size());
+    EXPECT_EQ("IEND", text.substr(text.size() - 8, 4));
+}
@@ -1,4 +1,7 @@
-﻿#include "Core.h"
+﻿#include <sstream>
+#include <thread>
+
+#include "Core.h"
 #include "GoogleTest.h"
 
 using namespace std;
@@ -15,7 +18,7 @@ protected:
     {
     }
 
-    void addShape(SVG & svg, Shape & shape, const Vertex center, const Vertex dir, const Vertex up)
+    void addShape(SVG & svg, Shape & shape, const Vertex center, const Vertex dir, const Vertex up, const bool cullBackFaces = false)
     {
         auto& style = svg.getStyle();
         style.fillOpacity = 1;
@@ -26,8 +29,62 @@ protected:
         style.fillOpacity = 0.5;
         style.fill = SVG::Color::Predefined::Red;
         style.stroke = SVG::Color::RGB(205, 0, 0);
-        svg.addShape(shape, center);
+        svg.addShape(shape, center, cullBackFaces);
     };
+
+    // Opaque shapes without axis, seen from direction dir
+    static string Render(const vector<Shape>& shapes, const SVG::HiddenSurface hiddenSurface, const Vertex dir)
+    {
+        SVG svg(500, 500, { 0,0,200,200 });
+        svg.setHiddenSurface(hiddenSurface);
+        const Vertex center(100, 100, 0);
+        svg.setView(SVG::View(center, center - dir, { 0, 0, -1 }));
+        auto& style = svg.getStyle();
+        style.fillOpacity = 1;
+        style.fill = SVG::Color::Predefined::Red;
+        for (const auto& shape : shapes)
+        {
+            svg.addShape(shape, center);
+        }
+        return svg.writeToString();
+    }
+
+    static size_t CountPaths(const string& text)
+    {
+        size_t paths = 0;
+        for (auto pos = text.find("<path d=\"M"); pos != string::npos; pos = text.find("<path d=\"M", pos + 1))
+        {
+            ++paths;
+        }
+        return paths;
+    }
+
+    // The style classes of the paths, in drawing order
+    static vector<string> PathClasses(const string& text)
+    {
+        vector<string> classes;
+        for (auto pos = text.find("<path d=\"M"); pos != string::npos; pos = text.find("<path d=\"M", pos + 1))
+        {
+            const auto start = text.find("class=\"", pos) + 7;
+            classes.emplace_back(text.substr(start, text.find('"', start) - start));
+        }
+        return classes;
+    }
+
+    // The points of the last path
+    static Points LastPath(const string& text)
+    {
+        const auto start = text.rfind("<path d=\"M") + 10;
+        istringstream in(text.substr(start, text.find('"', start) - start));
+        Points points;
+        Scalar x, y;
+        char comma;
+        while (in >> x >> comma >> y)
+        {
+            points.emplace_back(x, y);
+        }
+        return points;
+    }
 };
 
 TEST_F(SVGTest, Box)
@@ -57,3 +114,186 @@ TEST_F(SVGTest, Dodecahedron)
 
     svg.writeToFile("Dodecahedron.svg");
 }
+
+TEST_F(SVGTest, WriteToString)
+{
+    SVG svg(500, 500, { 0,0,200,200 });
+    Shape box = ShapeFactory::Box({-1,-1,-1},{1,1,1});
+    box.scale(20);
+
+    addShape(svg, box, {  50,  50, 0 }, {  0,0,1 }, {  0, 1, 0 });
+
+    auto text = svg.writeToString();
+    EXPECT_EQ(0, text.find("<svg "));
+    EXPECT_NE(string::npos, text.find("viewBox = \"0 0 200 200\""));
+    EXPECT_NE(string::npos, text.find("stroke: #cd0000;"));
+    EXPECT_NE(string::npos, text.find("fill-opacity: 0.5;"));
+    // three axis and six faces
+    EXPECT_EQ(9, CountPaths(text));
+    EXPECT_NE(string::npos, text.rfind("</svg>\n"));
+
+    ostringstream os;
+    svg.writeToStream(os);
+    EXPECT_EQ(text, os.str());
+}
+
+TEST_F(SVGTest, CullBackFaces)
+{
+    SVG svg(500, 500, { 0,0,200,200 });
+    Shape box = ShapeFactory::Box({-1,-1,-1},{1,1,1});
+    box.scale(20);
+
+    addShape(svg, box, { 150, 150, 0 }, {  1,2,1 }, {  0, 0,-1 }, true);
+
+    // three axis and the three faces seen from the eye
+    EXPECT_EQ(6, CountPaths(svg.writeToString()));
+
+    svg.writeToFile("BoxCulled.svg");
+}
+
+TEST_F(SVGTest, HiddenSurface)
+{
+    Shape box = ShapeFactory::Box({-1,-1,-1},{1,1,1});
+    box.scale(20);
+
+    // the back faces are covered by the three front faces
+    EXPECT_EQ(6, CountPaths(Render({ box }, SVG::HiddenSurface::BSP, { 1,2,1 })));
+    EXPECT_EQ(3, CountPaths(Render({ box }, SVG::HiddenSurface::BSPClipped, { 1,2,1 })));
+
+    // intersecting boxes have to be split
+    Shape other = box;
+    other.translate({ 10, 15, 5 });
+    const size_t painter = CountPaths(Render({ box, other }, SVG::HiddenSurface::Painter, { 1,2,1 }));
+    const size_t bsp = CountPaths(Render({ box, other }, SVG::HiddenSurface::BSP, { 1,2,1 }));
+    const size_t clipped = CountPaths(Render({ box, other }, SVG::HiddenSurface::BSPClipped, { 1,2,1 }));
+    EXPECT_EQ(12, painter);
+    EXPECT_LT(painter, bsp);
+    EXPECT_LT(clipped, bsp);
+    EXPECT_LE(6, clipped);
+
+    // Two quads piercing each other, seen along x. The first one (red, S1)
+    // splits the second one (blue, S2), whose half nearer to the eye is drawn
+    // last: the tilted quad in front for y < 100, the upright one for y > 100.
+    // The view maps y to 100 - x.
+    const Shape upright({ { 100,80,-20 }, { 100,120,-20 }, { 100,120,20 }, { 100,80,20 } }, { { 0,1,2,3 } });
+    const Shape tilted({ { 90,90,-10 }, { 110,110,-10 }, { 110,110,10 }, { 90,90,10 } }, { { 0,1,2,3 } });
+    auto drawingOrder = [](const Shape& first, const Shape& second)
+    {
+        SVG svg(500, 500, { 0,0,200,200 });
+        svg.setHiddenSurface(SVG::HiddenSurface::BSP);
+        const Vertex center(100, 100, 0);
+        svg.setView(SVG::View(center, center - Vertex(1, 0, 0), { 0, 0, -1 }));
+        auto& style = svg.getStyle();
+        style.fillOpacity = 1;
+        style.fill = SVG::Color::Predefined::Red;
+        svg.addShape(first, center);
+        style.fill = SVG::Color::RGB(0, 0, 255);
+        svg.addShape(second, center);
+        return svg.writeToString();
+    };
+    const vector<string> expected = { "S2", "S1", "S2" };
+    string text = drawingOrder(upright, tilted);
+    EXPECT_EQ(expected, PathClasses(text));
+    // closed, the first point is repeated
+    EXPECT_EQ(5, LastPath(text).size());
+    for (const auto& point : LastPath(text))
+    {
+        EXPECT_LE(0, point.x);
+    }
+    text = drawingOrder(tilted, upright);
+    EXPECT_EQ(expected, PathClasses(text));
+    EXPECT_EQ(5, LastPath(text).size());
+    for (const auto& point : LastPath(text))
+    {
+        EXPECT_GE(0, point.x);
+    }
+}
+
+TEST_F(SVGTest, AddShapes)
+{
+    vector<Shape> shapes;
+    for (int i = 0; i < 50; ++i)
+    {
+        Shape shape = (i % 2) ? ShapeFactory::Dodecahedron() : ShapeFactory::Box({-1,-1,-1},{1,1,1});
+        shape.scale(5);
+        shape.translate({ (Scalar)(i % 7) * 10, (Scalar)(i / 7) * 10, (Scalar)(i % 3) });
+        shapes.emplace_back(shape);
+    }
+    const Vertex center(100, 100, 0);
+    const SVG::View view(center, center - Vertex(1, 2, 1), { 0, 0, -1 });
+
+    SVG one(500, 500, { 0,0,200,200 }, view);
+    for (const auto& shape : shapes)
+    {
+        one.addShape(shape, center);
+    }
+    SVG all(500, 500, { 0,0,200,200 }, view);
+    all.addShapes(shapes);
+    const auto expected = one.writeToString();
+    EXPECT_EQ(expected, all.writeToString());
+
+    // from several threads, the shapes can end up in any order
+    SVG threaded(500, 500, { 0,0,200,200 }, view);
+    vector<thread> threads;
+    for (size_t t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([&, t]()
+            {
+                for (size_t i = t; i < shapes.size(); i += 4)
+                {
+                    threaded.addShape(shapes[i], center);
+                }
+            });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    const auto text = threaded.writeToString();
+    EXPECT_EQ(CountPaths(expected), CountPaths(text));
+    EXPECT_EQ(expected.size(), text.size());
+}
+
+TEST_F(SVGTest, MergeCoplanarFaces)
+{
+    // the hull of the corners and the face centers of a cube is made of triangles
+    Vertices points;
+    for (int i = 0; i < 8; ++i)
+    {
+        points.emplace_back((i & 1) ? 20 : -20, (i & 2) ? 20 : -20, (i & 4) ? 20 : -20);
+    }
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        for (const Scalar side : { -20, 20 })
+        {
+            Vertex center(0, 0, 0);
+            center[axis] = side;
+            points.emplace_back(center);
+        }
+    }
+    Shape hull = ShapeFactory::ConvexHull(points);
+    ASSERT_LT(6u, hull.getRawFaces().size());
+
+    const Vertex center(100, 100, 0);
+    const SVG::View view(center, center - Vertex(1, 2, 1), { 0, 0, -1 });
+    SVG plain(500, 500, { 0,0,200,200 }, view);
+    plain.addShape(hull, center);
+    SVG merged(500, 500, { 0,0,200,200 }, view);
+    merged.setMergeCoplanarFaces(true);
+    merged.addShape(hull, center);
+    const auto text = merged.writeToString();
+    EXPECT_EQ(hull.getRawFaces().size(), CountPaths(plain.writeToString()));
+    EXPECT_EQ(6, CountPaths(text));
+    // every side is a square: 4 points and the closing point
+    size_t pos = text.find("<path d=\"M");
+    ASSERT_NE(string::npos, pos);
+    const auto path = text.substr(pos, text.find('"', pos + 9) - pos);
+    EXPECT_EQ(5, count(path.begin(), path.end(), ','));
+
+    // the triangulated caps are one path each
+    Shape extrusion = ShapeFactory::Extrusion(Contour2D::Circle({ 0, 0 }, 20, 12), 10, true);
+    SVG capped(500, 500, { 0,0,200,200 }, view);
+    capped.setMergeCoplanarFaces(true);
+    capped.addShape(extrusion, center);
+    EXPECT_EQ(12 + 2, CountPaths(capped.writeToString()));
+}